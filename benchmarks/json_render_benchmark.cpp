@@ -0,0 +1,115 @@
+﻿#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <fmt/core.h>
+#include "services/json_stream_renderer.h"
+#include "services/json_structural_index.h"
+
+using namespace lunarica;
+
+namespace {
+
+class NullBuffer : public std::streambuf {
+protected:
+    std::streamsize xsputn(const char*, std::streamsize count) override {
+        return count;
+    }
+
+    int_type overflow(int_type c) override {
+        return c;
+    }
+};
+
+std::string makeRecords(size_t count, bool pretty) {
+    std::mt19937 rng(42);
+    std::string newline = pretty ? "\n    " : "";
+    std::string json = "[";
+    for (size_t i = 0; i < count; ++i) {
+        json += i == 0 ? "" : ",";
+        json += newline + "{" + newline + "  \"id\": " + std::to_string(i) + "," +
+                newline + "  \"name\": \"user " + std::to_string(rng()) + "\"," +
+                newline + "  \"active\": true," +
+                newline + "  \"score\": " + std::to_string(rng() % 1000) + ".25," +
+                newline + "  \"tags\": [\"alpha\", \"beta\"]," +
+                newline + "  \"bio\": \"Lorem ipsum dolor sit amet, consectetur adipiscing elit\"," +
+                newline + "  \"parent\": null" + newline + "}";
+    }
+    return json + "]";
+}
+
+std::string makeBlobs(size_t count, size_t blobSize) {
+    std::mt19937 rng(7);
+    const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string json = "[";
+    for (size_t i = 0; i < count; ++i) {
+        json += i == 0 ? "{\"blob\": \"" : ",{\"blob\": \"";
+        for (size_t j = 0; j < blobSize; ++j) {
+            json += alphabet[rng() % 64];
+        }
+        json += "\"}";
+    }
+    return json + "]";
+}
+
+template <typename Fn>
+double bestSeconds(int rounds, Fn&& fn) {
+    double best = 1e9;
+    for (int i = 0; i < rounds; ++i) {
+        auto started = std::chrono::steady_clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count());
+    }
+    return best;
+}
+
+void benchmarkPayload(const char* name, const std::string& json) {
+    fmt::print("{} ({:.1f} MB)\n", name, json.size() / 1e6);
+
+    const JsonStructuralIndexer::Backend backends[] = {
+        JsonStructuralIndexer::Backend::Scalar,
+        JsonStructuralIndexer::Backend::Sse2,
+        JsonStructuralIndexer::Backend::Avx2
+    };
+
+    std::vector<uint32_t> positions;
+    for (auto backend : backends) {
+        JsonStructuralIndexer indexer(backend);
+        if (indexer.backend() != backend) {
+            continue;
+        }
+        double seconds = bestSeconds(5, [&] {
+            indexer.reset();
+            for (size_t offset = 0; offset < json.size(); offset += 256 * 1024) {
+                indexer.index(json.data() + offset, std::min<size_t>(256 * 1024, json.size() - offset), positions);
+            }
+        });
+        fmt::print("  index  {:<7} {:8.2f} GB/s\n", JsonStructuralIndexer::backendName(backend), json.size() / seconds / 1e9);
+    }
+
+    NullBuffer nullBuffer;
+    std::ostream out(&nullBuffer);
+    OutputSink sink(out);
+    double seconds = bestSeconds(3, [&] {
+        JsonStreamRenderer renderer(sink, true, 120);
+        for (size_t offset = 0; offset < json.size(); offset += 16 * 1024) {
+            renderer.feed(json.data() + offset, std::min<size_t>(16 * 1024, json.size() - offset));
+        }
+        renderer.finish();
+    });
+    fmt::print("  render {:<7} {:8.2f} GB/s\n\n",
+               JsonStructuralIndexer::backendName(JsonStructuralIndexer::detectBackend()),
+               json.size() / seconds / 1e9);
+}
+
+}
+
+int main() {
+    benchmarkPayload("compact records", makeRecords(200000, false));
+    benchmarkPayload("pretty-printed records", makeRecords(200000, true));
+    benchmarkPayload("base64 blobs", makeBlobs(64, 512 * 1024));
+    return 0;
+}
@@ -1,11 +1,36 @@
 ﻿#pragma once
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include "core/command.h"
+#include "services/content_encoder.h"
 
 namespace lunarica {
 
+inline bool parseByteSize(const std::string& value, size_t& bytes) {
+    try {
+        size_t consumed = 0;
+        unsigned long long number = std::stoull(value, &consumed);
+        std::string unit = value.substr(consumed);
+        std::transform(unit.begin(), unit.end(), unit.begin(),
+                      [](unsigned char c){ return std::tolower(c); });
+
+        if (unit.empty() || unit == "b") {
+            bytes = number;
+        } else if (unit == "k" || unit == "kb") {
+            bytes = number * 1024;
+        } else if (unit == "m" || unit == "mb") {
+            bytes = number * 1024 * 1024;
+        } else {
+            return false;
+        }
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
 class ClearCommand : public Command {
 public:
     explicit ClearCommand(std::shared_ptr<Context> context)
@@ -54,50 +79,346 @@ public:
     }
 
     std::string getDescription() const override {
-        return "Set connection and read timeouts";
+        return "Set connection, read and keep-alive idle timeouts";
     }
 
     std::vector<std::string> getExamples() const override {
         return {
             "timeout",
-            "timeout 5 10"
+            "timeout 5 10",
+            "timeout 5 10 60"
         };
     }
 
     bool execute(const std::string& args) override {
         std::istringstream iss(args);
         int connTimeout, readTimeout;
+        int idleTimeout = context_->getIdleTimeout();
 
         if (args.empty()) {
             std::cout << "Current timeouts:" << std::endl;
             std::cout << "  Connection timeout: " << context_->getConnectionTimeout() << " seconds" << std::endl;
             std::cout << "  Read timeout: " << context_->getReadTimeout() << " seconds" << std::endl;
+            std::cout << "  Idle timeout: " << context_->getIdleTimeout() << " seconds" << std::endl;
             return true;
         }
 
         if (!(iss >> connTimeout >> readTimeout)) {
-            std::cout << "Usage: timeout <connection_timeout> <read_timeout>" << std::endl;
-            std::cout << "  Both values are in seconds" << std::endl;
+            std::cout << "Usage: timeout <connection_timeout> <read_timeout> [idle_timeout]" << std::endl;
+            std::cout << "  All values are in seconds, idle_timeout 0 disables keep-alive pooling" << std::endl;
             return true;
         }
 
-        if (connTimeout <= 0 || readTimeout <= 0) {
+        if (!(iss >> std::ws).eof() && !(iss >> idleTimeout)) {
+            std::cout << "Error: Idle timeout must be a number" << std::endl;
+            return true;
+        }
+
+        if (connTimeout <= 0 || readTimeout <= 0 || idleTimeout < 0) {
             std::cout << "Error: Timeout values must be positive" << std::endl;
             return true;
         }
 
         context_->setConnectionTimeout(connTimeout);
         context_->setReadTimeout(readTimeout);
+        context_->setIdleTimeout(idleTimeout);
 
         std::cout << "Timeouts set:" << std::endl;
         std::cout << "  Connection timeout: " << context_->getConnectionTimeout() << " seconds" << std::endl;
         std::cout << "  Read timeout: " << context_->getReadTimeout() << " seconds" << std::endl;
+        std::cout << "  Idle timeout: " << context_->getIdleTimeout() << " seconds" << std::endl;
+
+        return true;
+    }
+
+    std::string getHint() const override {
+        return "<conn> <read> [idle] - Set connection, read and idle timeouts in seconds";
+    }
+};
+
+class WindowCommand : public Command {
+public:
+    explicit WindowCommand(std::shared_ptr<Context> context)
+        : Command(context) {}
+
+    std::string getName() const override {
+        return "window";
+    }
+
+    std::string getCategory() const override {
+        return "misc";
+    }
+
+    std::string getDescription() const override {
+        return "Set how many bytes of a streamed response are buffered before output";
+    }
+
+    std::vector<std::string> getExamples() const override {
+        return {
+            "window",
+            "window 64k",
+            "window 1m"
+        };
+    }
+
+    bool execute(const std::string& args) override {
+        if (args.empty()) {
+            std::cout << "Stream window: " << context_->getStreamWindow() << " bytes" << std::endl;
+            return true;
+        }
+
+        size_t bytes = 0;
+        if (!parseByteSize(args, bytes) || bytes < 1024) {
+            std::cout << "Usage: window <bytes>[k|m]" << std::endl;
+            std::cout << "  The window must be at least 1k" << std::endl;
+            return true;
+        }
+
+        context_->setStreamWindow(bytes);
+        std::cout << "Stream window set to: " << context_->getStreamWindow() << " bytes" << std::endl;
+        return true;
+    }
+
+    std::string getHint() const override {
+        return "[bytes]        - Show or set the response stream window";
+    }
+};
+
+class InlineCommand : public Command {
+public:
+    explicit InlineCommand(std::shared_ptr<Context> context)
+        : Command(context) {}
+
+    std::string getName() const override {
+        return "inline";
+    }
 
+    std::string getCategory() const override {
+        return "misc";
+    }
+
+    std::string getDescription() const override {
+        return "Set how many bytes of a response body are rendered inline; use 'page' for the rest";
+    }
+
+    std::vector<std::string> getExamples() const override {
+        return {
+            "inline",
+            "inline 256k",
+            "inline off"
+        };
+    }
+
+    bool execute(const std::string& args) override {
+        if (args.empty()) {
+            size_t limit = context_->getInlineLimit();
+            std::cout << "Inline limit: " << (limit == 0 ? "off" : std::to_string(limit) + " bytes") << std::endl;
+            return true;
+        }
+
+        size_t bytes = 0;
+        if (args == "off") {
+            bytes = 0;
+        } else if (!parseByteSize(args, bytes) || bytes == 0) {
+            std::cout << "Usage: inline <bytes>[k|m] | off" << std::endl;
+            return true;
+        }
+
+        context_->setInlineLimit(bytes);
+        std::cout << "Inline limit set to: " << (bytes == 0 ? "off" : std::to_string(bytes) + " bytes") << std::endl;
+        return true;
+    }
+
+    std::string getHint() const override {
+        return "[bytes|off]    - Show or set how much of a body is printed inline";
+    }
+};
+
+class CollapseCommand : public Command {
+public:
+    explicit CollapseCommand(std::shared_ptr<Context> context)
+        : Command(context) {}
+
+    std::string getName() const override {
+        return "collapse";
+    }
+
+    std::string getCategory() const override {
+        return "misc";
+    }
+
+    std::string getDescription() const override {
+        return "Collapse JSON deeper than a nesting depth or past an element budget";
+    }
+
+    std::vector<std::string> getExamples() const override {
+        return {
+            "collapse",
+            "collapse depth 2",
+            "collapse items 20",
+            "collapse off"
+        };
+    }
+
+    bool execute(const std::string& args) override {
+        std::istringstream iss(args);
+        std::string setting;
+        iss >> setting;
+
+        if (setting == "off") {
+            context_->setCollapseDepth(0);
+            context_->setCollapseItems(0);
+        } else if (setting == "depth" || setting == "items") {
+            long long value = -1;
+            if (!(iss >> value) || value < 0) {
+                std::cout << "Error: collapse " << setting << " expects a number, 0 turns it off" << std::endl;
+                return true;
+            }
+            if (setting == "depth") {
+                context_->setCollapseDepth(static_cast<size_t>(value));
+            } else {
+                context_->setCollapseItems(static_cast<size_t>(value));
+            }
+        } else if (!setting.empty()) {
+            std::cout << "Usage: collapse [depth N | items N | off]" << std::endl;
+            return true;
+        }
+
+        auto describe = [](size_t value) {
+            return value == 0 ? std::string("unlimited") : std::to_string(value);
+        };
+        std::cout << "Collapse depth: " << describe(context_->getCollapseDepth()) << std::endl;
+        std::cout << "Collapse items: " << describe(context_->getCollapseItems()) << std::endl;
+        return true;
+    }
+
+    std::string getHint() const override {
+        return "[depth N|items N|off] - Limit how much nested JSON is rendered";
+    }
+};
+
+class CompressCommand : public Command {
+public:
+    explicit CompressCommand(std::shared_ptr<Context> context)
+        : Command(context) {}
+
+    std::string getName() const override {
+        return "compress";
+    }
+
+    std::string getCategory() const override {
+        return "misc";
+    }
+
+    std::string getDescription() const override {
+        return "Gzip request bodies at or above a size threshold before sending";
+    }
+
+    std::vector<std::string> getExamples() const override {
+        return {
+            "compress",
+            "compress 6",
+            "compress 1 64k",
+            "compress off"
+        };
+    }
+
+    bool execute(const std::string& args) override {
+        std::istringstream iss(args);
+        std::string setting;
+        iss >> setting;
+
+        if (setting == "off") {
+            context_->setCompressLevel(0);
+        } else if (!setting.empty()) {
+            int level = setting.size() == 1 ? setting[0] - '0' : 0;
+            std::string threshold;
+            size_t bytes = context_->getCompressThreshold();
+            if (level < 1 || level > 9 || ((iss >> threshold) && !parseByteSize(threshold, bytes))) {
+                std::cout << "Usage: compress <level 1-9> [threshold bytes[k|m]] | off" << std::endl;
+                return true;
+            }
+            if (!ContentEncoder::available()) {
+                std::cout << "Error: request compression is not available in this build" << std::endl;
+                return true;
+            }
+            context_->setCompressLevel(level);
+            context_->setCompressThreshold(bytes);
+        }
+
+        int level = context_->getCompressLevel();
+        if (level == 0) {
+            std::cout << "Request compression: off" << std::endl;
+        } else {
+            std::cout << "Request compression: gzip level " << level << " for bodies of at least "
+                      << context_->getCompressThreshold() << " bytes" << std::endl;
+        }
+        return true;
+    }
+
+    std::string getHint() const override {
+        return "[level [bytes]|off] - Gzip large request bodies";
+    }
+};
+
+class Http2Command : public Command {
+public:
+    explicit Http2Command(std::shared_ptr<Context> context)
+        : Command(context) {}
+
+    std::string getName() const override {
+        return "http2";
+    }
+
+    std::string getCategory() const override {
+        return "misc";
+    }
+
+    std::string getDescription() const override {
+        return "Send requests over multiplexed HTTP/2 connections (ALPN on https, prior knowledge with h2c)";
+    }
+
+    std::vector<std::string> getExamples() const override {
+        return {
+            "http2",
+            "http2 on",
+            "http2 h2c",
+            "http2 off"
+        };
+    }
+
+    bool execute(const std::string& args) override {
+        std::istringstream iss(args);
+        std::string setting;
+        iss >> setting;
+
+        if (setting == "off") {
+            context_->setHttp2Mode(Http2Mode::Off);
+        } else if (setting == "on") {
+            context_->setHttp2Mode(Http2Mode::Negotiate);
+        } else if (setting == "h2c") {
+            context_->setHttp2Mode(Http2Mode::PriorKnowledge);
+        } else if (!setting.empty()) {
+            std::cout << "Usage: http2 [on|h2c|off]" << std::endl;
+            return true;
+        }
+
+        switch (context_->getHttp2Mode()) {
+            case Http2Mode::Off:
+                std::cout << "HTTP/2: off" << std::endl;
+                break;
+            case Http2Mode::Negotiate:
+                std::cout << "HTTP/2: negotiated via ALPN on https, HTTP/1.1 elsewhere" << std::endl;
+                break;
+            case Http2Mode::PriorKnowledge:
+                std::cout << "HTTP/2: negotiated via ALPN on https, prior knowledge (h2c) on http" << std::endl;
+                break;
+        }
         return true;
     }
 
     std::string getHint() const override {
-        return "<conn> <read>   - Set connection and read timeouts in seconds";
+        return "[on|h2c|off] - Multiplex requests over HTTP/2";
     }
 };
 
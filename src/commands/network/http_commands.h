@@ -1,8 +1,14 @@
-#pragma once
+﻿#pragma once
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <sstream>
+#include <fmt/core.h>
 #include "core/command.h"
 #include "services/http_service.h"
+#include "services/downloader.h"
+#include "services/load_generator.h"
 
 namespace lunarica {
 
@@ -18,6 +24,68 @@ public:
 
 protected:
     std::shared_ptr<HttpService> httpService_;
+
+    bool uploadIfRequested(const std::string& method, const std::string& args) {
+        std::istringstream probe(args);
+        std::string word;
+        bool requested = false;
+        while (probe >> word && !requested) {
+            requested = word == "--file" || word == "-F" || word == "--multipart";
+        }
+        if (!requested) {
+            return false;
+        }
+
+        std::string path;
+        std::string file;
+        std::vector<FormField> fields;
+        bool multipart = false;
+        bool chunked = false;
+
+        std::istringstream iss(args);
+        std::string token;
+        while (iss >> token) {
+            if (token == "--file") {
+                iss >> file;
+            } else if (token == "--chunked") {
+                chunked = true;
+            } else if (token == "--multipart") {
+                multipart = true;
+            } else if (token == "-F") {
+                std::string spec;
+                iss >> spec;
+                size_t equals = spec.find('=');
+                if (equals == std::string::npos || equals == 0) {
+                    std::cout << "Error: -F expects name=value or name=@file" << std::endl;
+                    return true;
+                }
+                FormField field;
+                field.name = spec.substr(0, equals);
+                if (spec.compare(equals + 1, 1, "@") == 0) {
+                    field.file = spec.substr(equals + 2);
+                } else {
+                    field.value = spec.substr(equals + 1);
+                }
+                fields.push_back(field);
+                multipart = true;
+            } else {
+                path = token;
+            }
+        }
+
+        if (multipart) {
+            httpService_->uploadForm(method, path, fields);
+            return true;
+        }
+
+        if (file.empty()) {
+            std::cout << "Usage: " << getName() << " --file <file> [--chunked] <path>" << std::endl;
+            return true;
+        }
+
+        httpService_->upload(method, path, file, chunked);
+        return true;
+    }
 };
 
 class GetCommand : public HttpCommand {
@@ -68,12 +136,16 @@ public:
     std::vector<std::string> getExamples() const override {
         return {
             "post /users",
-            "post /api/login"
+            "post /api/login",
+            "post --file payload.bin /upload",
+            "post -F title=Holiday -F video=@clip.mp4 /media"
         };
     }
 
     bool execute(const std::string& args) override {
-        httpService_->post(args);
+        if (!uploadIfRequested("POST", args)) {
+            httpService_->post(args);
+        }
         return true;
     }
 
@@ -99,12 +171,15 @@ public:
     std::vector<std::string> getExamples() const override {
         return {
             "put /users/1",
-            "put /api/products/123"
+            "put /api/products/123",
+            "put --chunked --file image.iso /images/1"
         };
     }
 
     bool execute(const std::string& args) override {
-        httpService_->put(args);
+        if (!uploadIfRequested("PUT", args)) {
+            httpService_->put(args);
+        }
         return true;
     }
 
@@ -144,4 +219,516 @@ public:
     }
 };
 
+class StreamCommand : public HttpCommand {
+public:
+    explicit StreamCommand(std::shared_ptr<Context> context,
+                           std::shared_ptr<HttpService> httpService)
+        : HttpCommand(context, httpService) {}
+
+    std::string getName() const override {
+        return "stream";
+    }
+
+    std::string getDescription() const override {
+        return "Follow a Server-Sent Events or NDJSON stream, rendering each event as it arrives (Ctrl+C stops)";
+    }
+
+    std::vector<std::string> getExamples() const override {
+        return {
+            "stream /events",
+            "stream -n 100 /logs/tail"
+        };
+    }
+
+    bool execute(const std::string& args) override {
+        size_t limit = 0;
+        std::string path;
+
+        std::istringstream iss(args);
+        std::string token;
+        while (iss >> token) {
+            if (token == "-n") {
+                long long value = 0;
+                if (!(iss >> value) || value <= 0) {
+                    std::cout << "Error: -n expects a positive number" << std::endl;
+                    return true;
+                }
+                limit = static_cast<size_t>(value);
+            } else {
+                path = token;
+            }
+        }
+
+        httpService_->stream(path, limit);
+        return true;
+    }
+
+    std::string getHint() const override {
+        return "[-n N] <path>  - Follow an event stream";
+    }
+};
+
+class DownloadCommand : public HttpCommand {
+public:
+    explicit DownloadCommand(std::shared_ptr<Context> context,
+                             std::shared_ptr<HttpService> httpService)
+        : HttpCommand(context, httpService), downloader_(httpService) {}
+
+    std::string getName() const override {
+        return "download";
+    }
+
+    std::string getDescription() const override {
+        return "Download a path straight to a file, in parallel ranges when the server allows it (resumable)";
+    }
+
+    std::vector<std::string> getExamples() const override {
+        return {
+            "download /artifacts/build.tar.gz",
+            "download /dumps/db.sql dump.sql",
+            "download -c 8 /images/disk.img disk.img"
+        };
+    }
+
+    bool execute(const std::string& args) override {
+        DownloadOptions options;
+        std::vector<std::string> positional;
+
+        std::istringstream iss(args);
+        std::string token;
+        while (iss >> token) {
+            if (token == "-c") {
+                long long value = 0;
+                if (!(iss >> value) || value <= 0) {
+                    std::cout << "Error: -c expects a positive number" << std::endl;
+                    return true;
+                }
+                options.connections = static_cast<size_t>(value);
+            } else {
+                positional.push_back(token);
+            }
+        }
+
+        if (positional.empty() || positional.size() > 2) {
+            std::cout << "Usage: download [-c connections] <path> [file]" << std::endl;
+            return true;
+        }
+
+        HttpRequest request = httpService_->prepareRequest("GET", positional[0]);
+        std::string file = positional.size() == 2 ? positional[1] : fileNameFor(request.path);
+        std::cout << "Downloading " << request.url << " -> " << file << std::endl;
+
+        DownloadReport report = downloader_.run(request, file, options, [](const DownloadProgress& progress) {
+            std::cout << "\r" << describe(progress) << "    " << std::flush;
+        });
+        std::cout << "\r" << describe(report.progress) << "    " << std::endl;
+
+        if (report.completed) {
+            std::cout << fmt::format("Saved {} ({}) in {:.2f} s using {} {}", file,
+                                     formatSize(report.progress.resumed + report.progress.received),
+                                     std::chrono::duration<double>(report.progress.elapsed).count(),
+                                     report.progress.connections,
+                                     report.progress.connections == 1 ? "connection" : "connections") << std::endl;
+            if (!report.ranged) {
+                std::cout << "Server does not accept ranges, downloaded over a single connection" << std::endl;
+            }
+            return true;
+        }
+
+        if (!report.error.empty()) {
+            std::cout << "Error: " << report.error << std::endl;
+        } else if (report.interrupted) {
+            std::cout << "Interrupted" << std::endl;
+        }
+        if (report.ranged) {
+            std::cout << "Progress saved to " << Downloader::statePath(file)
+                      << ", run the same command again to resume" << std::endl;
+        }
+        return true;
+    }
+
+    std::string getHint() const override {
+        return "<path> [file]  - Download to a file";
+    }
+
+private:
+    Downloader downloader_;
+
+    static std::string fileNameFor(const std::string& path) {
+        std::string name = path.substr(0, path.find('?'));
+        name = name.substr(name.find_last_of('/') + 1);
+        return name.empty() ? "download.bin" : name;
+    }
+
+    static std::string describe(const DownloadProgress& progress) {
+        uint64_t have = progress.resumed + progress.received;
+        std::string line = "  " + formatSize(have);
+        if (progress.total > 0) {
+            line += fmt::format(" / {} ({:.1f}%)", formatSize(progress.total), 100.0 * have / progress.total);
+        }
+        return line + fmt::format("  {}/s", formatSize(static_cast<uint64_t>(progress.throughput())));
+    }
+
+    static std::string formatSize(uint64_t bytes) {
+        if (bytes >= 1024ull * 1024 * 1024) {
+            return fmt::format("{:.2f} GB", bytes / (1024.0 * 1024.0 * 1024.0));
+        }
+        if (bytes >= 1024 * 1024) {
+            return fmt::format("{:.1f} MB", bytes / (1024.0 * 1024.0));
+        }
+        if (bytes >= 1024) {
+            return fmt::format("{:.1f} KB", bytes / 1024.0);
+        }
+        return fmt::format("{} B", bytes);
+    }
+};
+
+class BenchCommand : public HttpCommand {
+public:
+    explicit BenchCommand(std::shared_ptr<Context> context,
+                          std::shared_ptr<HttpService> httpService)
+        : HttpCommand(context, httpService), loadGenerator_(httpService) {}
+
+    std::string getName() const override {
+        return "bench";
+    }
+
+    std::string getDescription() const override {
+        return "Load test the specified path with the current headers, query and body";
+    }
+
+    std::vector<std::string> getExamples() const override {
+        return {
+            "bench /users",
+            "bench -n 1000 -c 20 /users",
+            "bench -n 500 -c 10 post /api/login",
+            "bench --rate 5000/s --duration 60s -c 64 /users",
+            "bench --engine epoll -n 1000000 -c 50000 /users",
+            "bench --engine uring --threads 1 -c 1000 -n 1000000 /users"
+        };
+    }
+
+    bool execute(const std::string& args) override {
+        BenchOptions options;
+        std::string method = "GET";
+        std::string path;
+        double durationSeconds = 0.0;
+
+        std::istringstream iss(args);
+        std::string token;
+        while (iss >> token) {
+            if (token == "--rate" || token == "--duration") {
+                std::string value;
+                double parsed = 0.0;
+                bool valid = (iss >> value) &&
+                             (token == "--rate" ? parseRate(value, parsed) : parseDuration(value, parsed));
+                bool inRange = token == "--rate" ? parsed >= kMinRate && parsed <= kMaxRate
+                                                 : parsed > 0.0 && parsed <= kMaxDurationSeconds;
+                if (!valid || !std::isfinite(parsed) || !inRange) {
+                    std::cout << "Error: invalid value for " << token << std::endl;
+                    std::cout << "Examples: --rate 5000/s, --rate 300/m, --duration 60s, --duration 500ms" << std::endl;
+                    std::cout << "Rates run from 1/h to 10000000/s, durations up to 7 days" << std::endl;
+                    return true;
+                }
+
+                if (token == "--rate") {
+                    options.rate = parsed;
+                } else {
+                    durationSeconds = parsed;
+                }
+                continue;
+            }
+
+            if (token == "--engine") {
+                std::string engine;
+                iss >> engine;
+                if (engine != "epoll" && engine != "uring" && engine != "io_uring" && engine != "threads") {
+                    std::cout << "Error: --engine expects epoll, uring or threads" << std::endl;
+                    return true;
+                }
+                options.eventLoop = engine != "threads";
+                options.backend = engine == "epoll" ? EngineBackend::Epoll : EngineBackend::IoUring;
+                continue;
+            }
+
+            if (token == "-n" || token == "-c" || token == "--threads") {
+                long long value = 0;
+                if (!(iss >> value) || value <= 0) {
+                    std::cout << "Error: " << token << " expects a positive number" << std::endl;
+                    return true;
+                }
+                if (token == "-n") {
+                    options.requests = static_cast<size_t>(value);
+                } else if (token == "--threads") {
+                    options.threads = static_cast<size_t>(value);
+                } else {
+                    options.concurrency = static_cast<size_t>(value);
+                }
+                continue;
+            }
+
+            std::string upper = token;
+            std::transform(upper.begin(), upper.end(), upper.begin(),
+                          [](unsigned char c){ return std::toupper(c); });
+
+            if (path.empty() && (upper == "GET" || upper == "POST" || upper == "PUT" || upper == "DELETE")) {
+                method = upper;
+            } else {
+                path = token;
+            }
+        }
+
+        if (durationSeconds > 0.0 && options.rate <= 0.0) {
+            std::cout << "Error: --duration requires --rate" << std::endl;
+            return true;
+        }
+
+        if (options.rate > 0.0 && durationSeconds > 0.0) {
+            double requests = std::min(options.rate * durationSeconds, kMaxRequests);
+            options.requests = std::max<size_t>(1, static_cast<size_t>(requests));
+        }
+
+        HttpRequest request = httpService_->prepareRequest(method, path);
+        options.connectTimeout = std::chrono::seconds(context_->getConnectionTimeout());
+        options.readTimeout = std::chrono::seconds(context_->getReadTimeout());
+
+        std::cout << "Benchmarking " << method << " " << request.url << std::endl;
+        std::cout << "  " << options.requests << " requests, concurrency "
+                  << std::min(options.concurrency, options.requests);
+        if (options.rate > 0.0) {
+            std::cout << fmt::format(", open loop at {:.1f} req/s", options.rate);
+        }
+        if (options.eventLoop) {
+            size_t threads = options.threads > 0 ? options.threads : LoadGenerator::defaultThreads();
+            EngineBackend backend = EventLoopEngine::resolveBackend(options.backend);
+            std::cout << ", " << EventLoopEngine::backendName(backend) << " engine on "
+                      << std::min({threads, options.concurrency, options.requests}) << " threads";
+            if (backend != options.backend) {
+                std::cout << " (io_uring unavailable)";
+            }
+        }
+        std::cout << std::endl << std::endl;
+
+        BenchReport report;
+        if (options.eventLoop) {
+            std::string error;
+            if (!loadGenerator_.runEventLoop(request, options, report, error)) {
+                std::cout << "Error: " << error << std::endl;
+                return true;
+            }
+        } else {
+            report = options.rate > 0.0
+                ? loadGenerator_.runOpenLoop(request, options)
+                : loadGenerator_.runClosedLoop(request, options);
+        }
+        printReport(report);
+        return true;
+    }
+
+    std::string getHint() const override {
+        return "[-n N] [-c C] [--rate R/s --duration D] [--engine epoll|uring [--threads T]] [method] <path> - Load test an endpoint";
+    }
+
+private:
+    static constexpr double kMinRate = 1.0 / 3600.0;
+    static constexpr double kMaxRate = 1e7;
+    static constexpr double kMaxDurationSeconds = 7 * 24 * 3600.0;
+    static constexpr double kMaxRequests = 1e12;
+
+    LoadGenerator loadGenerator_;
+
+    static bool parseRate(const std::string& value, double& rate) {
+        size_t slash = value.find('/');
+        double perUnit = 1.0;
+
+        if (slash != std::string::npos) {
+            std::string unit = value.substr(slash + 1);
+            if (unit == "s") {
+                perUnit = 1.0;
+            } else if (unit == "m") {
+                perUnit = 60.0;
+            } else if (unit == "h") {
+                perUnit = 3600.0;
+            } else {
+                return false;
+            }
+        }
+
+        try {
+            size_t consumed = 0;
+            std::string number = value.substr(0, slash);
+            rate = std::stod(number, &consumed) / perUnit;
+            return consumed == number.size();
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    static bool parseDuration(const std::string& value, double& seconds) {
+        try {
+            size_t consumed = 0;
+            double number = std::stod(value, &consumed);
+            std::string unit = value.substr(consumed);
+
+            if (unit.empty() || unit == "s") {
+                seconds = number;
+            } else if (unit == "ms") {
+                seconds = number / 1000.0;
+            } else if (unit == "m") {
+                seconds = number * 60.0;
+            } else if (unit == "h") {
+                seconds = number * 3600.0;
+            } else {
+                return false;
+            }
+            return true;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    void printReport(const BenchReport& report) {
+        std::cout << fmt::format("Completed {} requests in {:.3f} s",
+                                 report.requests,
+                                 std::chrono::duration<double>(report.elapsed).count()) << std::endl;
+        std::cout << fmt::format("Throughput: {:.2f} req/s", report.throughput()) << std::endl;
+        if (report.targetRate > 0.0) {
+            std::cout << fmt::format("Target rate: {:.2f} req/s, {} sends more than 1 ms late (max lag {:.3f} ms)",
+                                     report.targetRate, report.lateSends, report.maxSendLagUs / 1000.0) << std::endl;
+        }
+
+        if (!report.statusCounts.empty()) {
+            std::cout << std::endl << "Status codes:" << std::endl;
+            for (const auto& [status, count] : report.statusCounts) {
+                std::cout << "  " << status << ": " << count << std::endl;
+            }
+        }
+
+        if (!report.errorCounts.empty()) {
+            std::cout << std::endl << "Errors:" << std::endl;
+            for (const auto& [error, count] : report.errorCounts) {
+                std::cout << "  " << error << ": " << count << std::endl;
+            }
+        }
+
+        const std::pair<const char*, double> percentiles[] = {
+            {"p50", 50.0}, {"p90", 90.0}, {"p99", 99.0}, {"p99.9", 99.9}
+        };
+
+        if (report.targetRate > 0.0) {
+            std::cout << std::endl << "Latency from intended send time (ms):     service time (ms):" << std::endl;
+            for (const auto& [label, percent] : percentiles) {
+                std::cout << fmt::format("  {:<6} {:<35.3f} {:.3f}", label,
+                                         report.percentile(percent) / 1000.0,
+                                         report.servicePercentile(percent) / 1000.0) << std::endl;
+            }
+            std::cout << fmt::format("  {:<6} {:<35.3f} {:.3f}", "max",
+                                     report.max() / 1000.0,
+                                     report.servicePercentile(100.0) / 1000.0) << std::endl;
+            return;
+        }
+
+        std::cout << std::endl << "Latency (ms):" << std::endl;
+        for (const auto& [label, percent] : percentiles) {
+            std::cout << fmt::format("  {:<6} {:.3f}", label, report.percentile(percent) / 1000.0) << std::endl;
+        }
+        std::cout << fmt::format("  {:<6} {:.3f}", "max", report.max() / 1000.0) << std::endl;
+    }
+};
+
+class HedgeCommand : public HttpCommand {
+public:
+    explicit HedgeCommand(std::shared_ptr<Context> context,
+                          std::shared_ptr<HttpService> httpService)
+        : HttpCommand(context, httpService) {}
+
+    std::string getName() const override {
+        return "hedge";
+    }
+
+    std::string getDescription() const override {
+        return "Duplicate slow GETs on a second pooled connection and keep whichever answers first";
+    }
+
+    std::vector<std::string> getExamples() const override {
+        return {
+            "hedge",
+            "hedge 50ms",
+            "hedge p95",
+            "hedge reset",
+            "hedge off"
+        };
+    }
+
+    bool execute(const std::string& args) override {
+        std::istringstream iss(args);
+        std::string setting;
+        iss >> setting;
+
+        RequestHedger& hedger = httpService_->getHedger();
+        if (setting == "off") {
+            context_->setHedgeMode(HedgeMode::Off);
+        } else if (setting == "p95") {
+            context_->setHedgeMode(HedgeMode::Percentile);
+        } else if (setting == "reset") {
+            hedger.reset();
+        } else if (!setting.empty()) {
+            int milliseconds = parseDelay(setting);
+            if (milliseconds <= 0) {
+                std::cout << "Usage: hedge [<delay>ms|p95|reset|off]" << std::endl;
+                return true;
+            }
+            context_->setHedgeMode(HedgeMode::Fixed);
+            context_->setHedgeDelay(milliseconds);
+        }
+
+        switch (context_->getHedgeMode()) {
+            case HedgeMode::Off:
+                std::cout << "Hedging: off" << std::endl;
+                break;
+            case HedgeMode::Fixed:
+                std::cout << "Hedging: GETs are duplicated after " << context_->getHedgeDelay()
+                          << " ms without response headers" << std::endl;
+                break;
+            case HedgeMode::Percentile: {
+                std::string host = httpService_->extractHost(context_->getUrl());
+                size_t samples = hedger.samples(host);
+                std::cout << "Hedging: GETs are duplicated after the observed p95 for the host";
+                if (samples < RequestHedger::kMinSamples) {
+                    std::cout << " (" << samples << " of " << RequestHedger::kMinSamples
+                              << " samples for " << host << " so far)";
+                }
+                std::cout << std::endl;
+                break;
+            }
+        }
+
+        HedgeStats stats = hedger.stats();
+        std::cout << stats.requests << " hedgeable " << (stats.requests == 1 ? "request" : "requests")
+                  << ", " << stats.fired << " hedges fired, " << stats.won << " won by the duplicate" << std::endl;
+        return true;
+    }
+
+    std::string getHint() const override {
+        return "[delay|p95|reset|off] - Hedge slow GETs with a duplicate request";
+    }
+
+private:
+    static int parseDelay(const std::string& value) {
+        try {
+            size_t consumed = 0;
+            double number = std::stod(value, &consumed);
+            std::string unit = value.substr(consumed);
+            if (unit == "s") {
+                number *= 1000.0;
+            } else if (!unit.empty() && unit != "ms") {
+                return 0;
+            }
+            return number >= 1.0 && number <= 600000.0 ? static_cast<int>(number) : 0;
+        } catch (const std::exception&) {
+            return 0;
+        }
+    }
+};
+
 }
\ No newline at end of file
@@ -0,0 +1,241 @@
+﻿#pragma once
+
+#include <iostream>
+#include <fmt/core.h>
+#include "core/command.h"
+#include "services/http_service.h"
+#include "services/pager.h"
+
+namespace lunarica {
+
+class ResponseCommand : public Command {
+public:
+    explicit ResponseCommand(std::shared_ptr<Context> context,
+                             std::shared_ptr<HttpService> httpService)
+        : Command(context), httpService_(httpService) {}
+
+    std::string getCategory() const override {
+        return "responses";
+    }
+
+protected:
+    std::shared_ptr<HttpService> httpService_;
+};
+
+class ResponsesCommand : public ResponseCommand {
+public:
+    explicit ResponsesCommand(std::shared_ptr<Context> context,
+                              std::shared_ptr<HttpService> httpService)
+        : ResponseCommand(context, httpService) {}
+
+    std::string getName() const override {
+        return "responses";
+    }
+
+    std::string getDescription() const override {
+        return "List the stored responses, newest first as $1, $2, ...";
+    }
+
+    std::vector<std::string> getExamples() const override {
+        return {
+            "responses",
+            "responses clear"
+        };
+    }
+
+    bool execute(const std::string& args) override {
+        ResponseStore& store = httpService_->getResponses();
+
+        if (args == "clear") {
+            store.clear();
+            std::cout << "Stored responses cleared" << std::endl;
+            return true;
+        }
+
+        if (store.entries().empty()) {
+            std::cout << "No stored responses" << std::endl;
+            return true;
+        }
+
+        size_t number = 1;
+        for (const auto& response : store.entries()) {
+            std::cout << fmt::format("  ${:<3} {:<6} {:<4} {:>10}  {}{}",
+                                     number++, response->method, response->status,
+                                     formatSize(response->body.size()), response->url,
+                                     response->body.spilled() ? "  (on disk)" : "") << std::endl;
+        }
+        std::cout << "In memory: " << formatSize(store.memoryUsage()) << std::endl;
+        return true;
+    }
+
+    std::string getHint() const override {
+        return "[clear]        - List stored responses";
+    }
+
+private:
+    static std::string formatSize(size_t bytes) {
+        if (bytes >= 1024 * 1024) {
+            return fmt::format("{:.1f} MB", bytes / (1024.0 * 1024.0));
+        }
+        if (bytes >= 1024) {
+            return fmt::format("{:.1f} KB", bytes / 1024.0);
+        }
+        return fmt::format("{} B", bytes);
+    }
+};
+
+class ShowCommand : public ResponseCommand {
+public:
+    explicit ShowCommand(std::shared_ptr<Context> context,
+                         std::shared_ptr<HttpService> httpService)
+        : ResponseCommand(context, httpService) {}
+
+    std::string getName() const override {
+        return "show";
+    }
+
+    std::string getDescription() const override {
+        return "Render a stored response or a path inside it";
+    }
+
+    std::vector<std::string> getExamples() const override {
+        return {
+            "show $2",
+            "show $1.items[5000].id",
+            "show data.users[0]"
+        };
+    }
+
+    bool execute(const std::string& args) override {
+        httpService_->show(args);
+        return true;
+    }
+
+    std::string getHint() const override {
+        return "[$N][path]     - Show a stored response";
+    }
+};
+
+class ExpandCommand : public ResponseCommand {
+public:
+    explicit ExpandCommand(std::shared_ptr<Context> context,
+                           std::shared_ptr<HttpService> httpService)
+        : ResponseCommand(context, httpService) {}
+
+    std::string getName() const override {
+        return "expand";
+    }
+
+    std::string getDescription() const override {
+        return "Render a collapsed part of the last response body";
+    }
+
+    std::vector<std::string> getExamples() const override {
+        return {
+            "expand items[42]",
+            "expand data.users[0].address"
+        };
+    }
+
+    bool execute(const std::string& args) override {
+        if (args.empty()) {
+            std::cout << "Usage: expand <path>" << std::endl;
+            return true;
+        }
+        httpService_->show(args[0] == '$' ? args : "$1." + args);
+        return true;
+    }
+
+    std::string getHint() const override {
+        return "<path>         - Expand a path of the last response";
+    }
+};
+
+class JqCommand : public ResponseCommand {
+public:
+    explicit JqCommand(std::shared_ptr<Context> context,
+                       std::shared_ptr<HttpService> httpService)
+        : ResponseCommand(context, httpService) {}
+
+    std::string getName() const override {
+        return "jq";
+    }
+
+    std::string getDescription() const override {
+        return "Run a jq-style filter (paths, [], select, |) over a stored response";
+    }
+
+    std::vector<std::string> getExamples() const override {
+        return {
+            "jq .items[] | select(.status==\"failed\") | .id",
+            "jq $2 .data.users[0].name",
+            "jq .items[] | select(.took > 100 and .retry) | .id"
+        };
+    }
+
+    bool execute(const std::string& args) override {
+        if (args.empty()) {
+            std::cout << "Usage: jq [$N] <filter>" << std::endl;
+            return true;
+        }
+        httpService_->query(args);
+        return true;
+    }
+
+    std::string getHint() const override {
+        return "[$N] <filter>  - Query a stored response";
+    }
+};
+
+class PageCommand : public ResponseCommand {
+public:
+    explicit PageCommand(std::shared_ptr<Context> context,
+                         std::shared_ptr<HttpService> httpService)
+        : ResponseCommand(context, httpService) {}
+
+    std::string getName() const override {
+        return "page";
+    }
+
+    std::string getDescription() const override {
+        return "Browse a stored response in a pager (scroll, / search, : jump to path)";
+    }
+
+    std::vector<std::string> getExamples() const override {
+        return {
+            "page",
+            "page $2",
+            "page items[5000].id"
+        };
+    }
+
+    bool execute(const std::string& args) override {
+        size_t number = 1;
+        std::vector<JsonPathStep> steps;
+        if (!ResponseStore::parseReference(args, number, steps)) {
+            std::cout << "Invalid path: " << args << std::endl;
+            return true;
+        }
+
+        auto response = httpService_->getResponses().get(number);
+        if (!response || response->body.size() == 0) {
+            std::cout << "No response body to page" << std::endl;
+            return true;
+        }
+
+        bool jsonHint = response->contentType.find("json") != std::string::npos;
+        Pager pager(response->body.view(), jsonHint, httpService_->getOutput());
+        if (!steps.empty() && !pager.jumpToPath(JsonPath::toString(steps))) {
+            std::cout << pager.message() << std::endl;
+            return true;
+        }
+        pager.run();
+        return true;
+    }
+
+    std::string getHint() const override {
+        return "[$N][path]     - Page through a stored response";
+    }
+};
+
+}
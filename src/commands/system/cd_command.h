@@ -2,12 +2,14 @@
 
 #include <iostream>
 #include "core/command.h"
+#include "services/http_service.h"
 
 namespace lunarica {
 
     class CdCommand : public Command {
     public:
-        explicit CdCommand(std::shared_ptr<Context> context) : Command(context) {}
+        CdCommand(std::shared_ptr<Context> context, std::shared_ptr<HttpService> httpService)
+            : Command(context), httpService_(std::move(httpService)) {}
 
         std::string getName() const override {
             return "cd";
@@ -34,6 +36,7 @@ namespace lunarica {
             }
 
             context_->setUrl(args);
+            httpService_->getConnectionPool().prefetch(httpService_->extractHost(context_->getUrl()));
             std::cout << "Current URL set to: " << context_->getUrl() << std::endl;
             return true;
         }
@@ -41,6 +44,9 @@ namespace lunarica {
         std::string getHint() const override {
             return "<url>          - Change the current URL";
         }
+
+    private:
+        std::shared_ptr<HttpService> httpService_;
     };
 
 }
\ No newline at end of file
@@ -39,6 +39,7 @@ namespace lunarica {
 
         while (!context_->shouldExit()) {
             std::string prompt = fmt::format("{} > ", context_->getUrl());
+            commandProcessor_->flushOutput();
 
             const char* input = rx_.input(prompt);
 
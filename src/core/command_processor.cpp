@@ -4,8 +4,9 @@ namespace lunarica {
 
 CommandProcessor::CommandProcessor(std::shared_ptr<Context> context)
     : context_(std::move(context)) {
-    jsonFormatter_ = std::make_shared<JsonFormatter>();
-    httpService_ = std::make_shared<HttpService>(context_, jsonFormatter_);
+    outputSink_ = std::make_shared<OutputSink>(std::cout);
+    jsonFormatter_ = std::make_shared<JsonFormatter>(outputSink_);
+    httpService_ = std::make_shared<HttpService>(context_, jsonFormatter_, outputSink_);
 
     registerCommands();
 }
@@ -14,13 +15,24 @@ void CommandProcessor::registerCommands() {
     // System commands
     commandRegistry_.registerCommand(std::make_shared<ExitCommand>(context_));
     commandRegistry_.registerCommand(std::make_shared<HelpCommand>(context_, commandRegistry_));
-    commandRegistry_.registerCommand(std::make_shared<CdCommand>(context_));
+    commandRegistry_.registerCommand(std::make_shared<CdCommand>(context_, httpService_));
 
     // Network commands
     commandRegistry_.registerCommand(std::make_shared<GetCommand>(context_, httpService_));
     commandRegistry_.registerCommand(std::make_shared<PostCommand>(context_, httpService_));
     commandRegistry_.registerCommand(std::make_shared<PutCommand>(context_, httpService_));
     commandRegistry_.registerCommand(std::make_shared<DeleteCommand>(context_, httpService_));
+    commandRegistry_.registerCommand(std::make_shared<StreamCommand>(context_, httpService_));
+    commandRegistry_.registerCommand(std::make_shared<DownloadCommand>(context_, httpService_));
+    commandRegistry_.registerCommand(std::make_shared<BenchCommand>(context_, httpService_));
+    commandRegistry_.registerCommand(std::make_shared<HedgeCommand>(context_, httpService_));
+
+    // Response commands
+    commandRegistry_.registerCommand(std::make_shared<ResponsesCommand>(context_, httpService_));
+    commandRegistry_.registerCommand(std::make_shared<ShowCommand>(context_, httpService_));
+    commandRegistry_.registerCommand(std::make_shared<ExpandCommand>(context_, httpService_));
+    commandRegistry_.registerCommand(std::make_shared<JqCommand>(context_, httpService_));
+    commandRegistry_.registerCommand(std::make_shared<PageCommand>(context_, httpService_));
 
     // Header commands
     commandRegistry_.registerCommand(std::make_shared<HeadersCommand>(context_));
@@ -46,6 +58,11 @@ void CommandProcessor::registerCommands() {
     // Misc commands
     commandRegistry_.registerCommand(std::make_shared<ClearCommand>(context_));
     commandRegistry_.registerCommand(std::make_shared<TimeoutCommand>(context_));
+    commandRegistry_.registerCommand(std::make_shared<WindowCommand>(context_));
+    commandRegistry_.registerCommand(std::make_shared<InlineCommand>(context_));
+    commandRegistry_.registerCommand(std::make_shared<CollapseCommand>(context_));
+    commandRegistry_.registerCommand(std::make_shared<CompressCommand>(context_));
+    commandRegistry_.registerCommand(std::make_shared<Http2Command>(context_));
     commandRegistry_.registerCommand(std::make_shared<ParamsCommand>(context_));
     commandRegistry_.registerCommand(std::make_shared<ClearScreenCommand>(context_));
 }
@@ -66,11 +83,17 @@ bool CommandProcessor::process(const std::string& commandLine) {
 
     std::cout << "---------------------------------------------------" << std::endl;
     bool result = command->execute(args);
+    outputSink_->flush();
     std::cout << "---------------------------------------------------" << std::endl;
 
     return result;
 }
 
+void CommandProcessor::flushOutput() {
+    outputSink_->flush();
+    std::cout.flush();
+}
+
 std::pair<std::string, std::string> CommandProcessor::parseCommandLine(const std::string& commandLine) {
     std::string cmdName;
     std::string args;
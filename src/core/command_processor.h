@@ -7,6 +7,7 @@
 #include <string>
 #include "command_registry.h"
 #include "context.h"
+#include "output_sink.h"
 #include "services/http_service.h"
 #include "services/json_formatter.h"
 #include "commands/auth/auth_commands.h"
@@ -15,6 +16,7 @@
 #include "commands/misc/misc_commands.h"
 #include "commands/network/http_commands.h"
 #include "commands/query/query_commands.h"
+#include "commands/responses/response_commands.h"
 #include "commands/system/cd_command.h"
 #include "commands/system/exit_command.h"
 #include "commands/system/help_command.h"
@@ -44,8 +46,11 @@ namespace lunarica {
 
         std::pair<std::string, std::string> parseCommandLine(const std::string& commandLine);
 
+        void flushOutput();
+
     private:
         std::shared_ptr<Context> context_;
+        std::shared_ptr<OutputSink> outputSink_;
         std::shared_ptr<JsonFormatter> jsonFormatter_;
         std::shared_ptr<HttpService> httpService_;
         CommandRegistry commandRegistry_;
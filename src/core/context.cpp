@@ -87,4 +87,84 @@ namespace lunarica {
         readTimeout_ = seconds;
     }
 
+    int Context::getIdleTimeout() const {
+        return idleTimeout_;
+    }
+
+    void Context::setIdleTimeout(int seconds) {
+        idleTimeout_ = seconds;
+    }
+
+    size_t Context::getStreamWindow() const {
+        return streamWindow_;
+    }
+
+    void Context::setStreamWindow(size_t bytes) {
+        streamWindow_ = bytes;
+    }
+
+    size_t Context::getInlineLimit() const {
+        return inlineLimit_;
+    }
+
+    void Context::setInlineLimit(size_t bytes) {
+        inlineLimit_ = bytes;
+    }
+
+    size_t Context::getCollapseDepth() const {
+        return collapseDepth_;
+    }
+
+    void Context::setCollapseDepth(size_t depth) {
+        collapseDepth_ = depth;
+    }
+
+    size_t Context::getCollapseItems() const {
+        return collapseItems_;
+    }
+
+    void Context::setCollapseItems(size_t items) {
+        collapseItems_ = items;
+    }
+
+    int Context::getCompressLevel() const {
+        return compressLevel_;
+    }
+
+    void Context::setCompressLevel(int level) {
+        compressLevel_ = level;
+    }
+
+    size_t Context::getCompressThreshold() const {
+        return compressThreshold_;
+    }
+
+    void Context::setCompressThreshold(size_t bytes) {
+        compressThreshold_ = bytes;
+    }
+
+    Http2Mode Context::getHttp2Mode() const {
+        return http2Mode_;
+    }
+
+    void Context::setHttp2Mode(Http2Mode mode) {
+        http2Mode_ = mode;
+    }
+
+    HedgeMode Context::getHedgeMode() const {
+        return hedgeMode_;
+    }
+
+    void Context::setHedgeMode(HedgeMode mode) {
+        hedgeMode_ = mode;
+    }
+
+    int Context::getHedgeDelay() const {
+        return hedgeDelay_;
+    }
+
+    void Context::setHedgeDelay(int milliseconds) {
+        hedgeDelay_ = milliseconds;
+    }
+
 }
\ No newline at end of file
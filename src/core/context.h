@@ -1,11 +1,16 @@
 ﻿#pragma once
 
+#include <cstddef>
 #include <string>
 #include <map>
 #include <vector>
 
 namespace lunarica {
 
+    enum class Http2Mode { Off, Negotiate, PriorKnowledge };
+
+    enum class HedgeMode { Off, Fixed, Percentile };
+
     class Context {
     public:
         Context();
@@ -36,6 +41,27 @@ namespace lunarica {
         void setConnectionTimeout(int seconds);
         int getReadTimeout() const;
         void setReadTimeout(int seconds);
+        int getIdleTimeout() const;
+        void setIdleTimeout(int seconds);
+
+        size_t getStreamWindow() const;
+        void setStreamWindow(size_t bytes);
+        size_t getInlineLimit() const;
+        void setInlineLimit(size_t bytes);
+        size_t getCollapseDepth() const;
+        void setCollapseDepth(size_t depth);
+        size_t getCollapseItems() const;
+        void setCollapseItems(size_t items);
+        int getCompressLevel() const;
+        void setCompressLevel(int level);
+        size_t getCompressThreshold() const;
+        void setCompressThreshold(size_t bytes);
+        Http2Mode getHttp2Mode() const;
+        void setHttp2Mode(Http2Mode mode);
+        HedgeMode getHedgeMode() const;
+        void setHedgeMode(HedgeMode mode);
+        int getHedgeDelay() const;
+        void setHedgeDelay(int milliseconds);
 
     private:
         std::string url_;
@@ -45,6 +71,16 @@ namespace lunarica {
         bool shouldExit_;
         int connectionTimeout_ = 3;
         int readTimeout_ = 5;
+        int idleTimeout_ = 30;
+        size_t streamWindow_ = 64 * 1024;
+        size_t inlineLimit_ = 1024 * 1024;
+        size_t collapseDepth_ = 0;
+        size_t collapseItems_ = 0;
+        int compressLevel_ = 0;
+        size_t compressThreshold_ = 8 * 1024;
+        Http2Mode http2Mode_ = Http2Mode::Off;
+        HedgeMode hedgeMode_ = HedgeMode::Off;
+        int hedgeDelay_ = 100;
     };
 
 }
\ No newline at end of file
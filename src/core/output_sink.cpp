@@ -0,0 +1,45 @@
+﻿#include "output_sink.h"
+
+namespace lunarica {
+
+    OutputSink::OutputSink(std::ostream& target, size_t capacity)
+        : target_(target), capacity_(capacity), lastFlush_(Clock::now()) {
+        buffer_.reserve(capacity_);
+    }
+
+    OutputSink::~OutputSink() {
+        flush();
+    }
+
+    void OutputSink::write(const char* data, size_t length) {
+        if (buffer_.size() + length > capacity_) {
+            flush();
+            if (length >= capacity_) {
+                target_.write(data, static_cast<std::streamsize>(length));
+                target_.flush();
+                lastFlush_ = Clock::now();
+                return;
+            }
+        }
+        buffer_.append(data, length);
+    }
+
+    void OutputSink::flush() {
+        if (!buffer_.empty()) {
+            target_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+            buffer_.clear();
+        }
+        target_.flush();
+        lastFlush_ = Clock::now();
+    }
+
+    void OutputSink::flushIfDue() {
+        if (buffer_.empty()) {
+            return;
+        }
+        if (buffer_.size() >= kPaceBytes || Clock::now() - lastFlush_ >= kPaceInterval) {
+            flush();
+        }
+    }
+
+}
@@ -0,0 +1,72 @@
+﻿#pragma once
+
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace lunarica {
+
+    class OutputSink {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr size_t kDefaultCapacity = 256 * 1024;
+        static constexpr size_t kPaceBytes = 32 * 1024;
+        static constexpr std::chrono::milliseconds kPaceInterval{50};
+
+        explicit OutputSink(std::ostream& target, size_t capacity = kDefaultCapacity);
+        ~OutputSink();
+
+        OutputSink(const OutputSink&) = delete;
+        OutputSink& operator=(const OutputSink&) = delete;
+
+        void write(const char* data, size_t length);
+        void flush();
+
+        // For per-chunk call sites: flushes only once kPaceBytes are buffered
+        // or kPaceInterval has passed since the last flush. Whatever is left
+        // goes out with the flush at the end of the command.
+        void flushIfDue();
+
+        size_t buffered() const {
+            return buffer_.size();
+        }
+
+        OutputSink& operator<<(std::string_view text) {
+            write(text.data(), text.size());
+            return *this;
+        }
+
+        OutputSink& operator<<(const char* text) {
+            return *this << std::string_view(text);
+        }
+
+        OutputSink& operator<<(const std::string& text) {
+            return *this << std::string_view(text);
+        }
+
+        OutputSink& operator<<(char c) {
+            write(&c, 1);
+            return *this;
+        }
+
+        template <typename T, typename = std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, char> && !std::is_same_v<T, bool>>>
+        OutputSink& operator<<(T value) {
+            char digits[24];
+            auto result = std::to_chars(digits, digits + sizeof(digits), value);
+            write(digits, static_cast<size_t>(result.ptr - digits));
+            return *this;
+        }
+
+    private:
+        std::ostream& target_;
+        std::string buffer_;
+        size_t capacity_;
+        Clock::time_point lastFlush_;
+    };
+
+}
@@ -0,0 +1,97 @@
+﻿#include "body_spool.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+namespace lunarica {
+
+BodySpool::BodySpool(size_t memoryLimit)
+    : memoryLimit_(memoryLimit) {
+}
+
+BodySpool::~BodySpool() {
+    clear();
+}
+
+void BodySpool::append(const char* data, size_t length) {
+    if (!file_ && size_ + length > memoryLimit_) {
+        spill();
+    }
+
+    if (file_) {
+        size_ += std::fwrite(data, 1, length, file_);
+        return;
+    }
+    memory_.append(data, length);
+    size_ += length;
+}
+
+void BodySpool::clear() {
+    unmap();
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    memory_.clear();
+    memory_.shrink_to_fit();
+    size_ = 0;
+}
+
+std::string_view BodySpool::view() {
+    if (!file_) {
+        return memory_;
+    }
+    if (mapping_ && mappedSize_ == size_) {
+        return {static_cast<const char*>(mapping_), mappedSize_};
+    }
+
+    unmap();
+    std::fflush(file_);
+#ifndef _WIN32
+    void* mapping = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fileno(file_), 0);
+    if (mapping != MAP_FAILED) {
+        madvise(mapping, size_, MADV_SEQUENTIAL);
+        mapping_ = mapping;
+        mappedSize_ = size_;
+        return {static_cast<const char*>(mapping_), mappedSize_};
+    }
+#endif
+    memory_.resize(size_);
+    std::rewind(file_);
+    memory_.resize(std::fread(&memory_[0], 1, size_, file_));
+    std::fseek(file_, 0, SEEK_END);
+    return memory_;
+}
+
+bool BodySpool::spill() {
+    if (file_) {
+        return true;
+    }
+
+    file_ = std::tmpfile();
+    if (!file_) {
+        return false;
+    }
+    std::setvbuf(file_, nullptr, _IOFBF, 1024 * 1024);
+    if (std::fwrite(memory_.data(), 1, memory_.size(), file_) != memory_.size()) {
+        std::fclose(file_);
+        file_ = nullptr;
+        return false;
+    }
+    memory_.clear();
+    memory_.shrink_to_fit();
+    return true;
+}
+
+void BodySpool::unmap() {
+#ifndef _WIN32
+    if (mapping_) {
+        munmap(mapping_, mappedSize_);
+    }
+#endif
+    mapping_ = nullptr;
+    mappedSize_ = 0;
+}
+
+}
@@ -0,0 +1,49 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+namespace lunarica {
+
+    class BodySpool {
+    public:
+        static constexpr size_t kDefaultMemoryLimit = 16 * 1024 * 1024;
+
+        explicit BodySpool(size_t memoryLimit = kDefaultMemoryLimit);
+        ~BodySpool();
+
+        BodySpool(const BodySpool&) = delete;
+        BodySpool& operator=(const BodySpool&) = delete;
+
+        void append(const char* data, size_t length);
+        void clear();
+        bool spill();
+
+        std::string_view view();
+
+        size_t size() const {
+            return size_;
+        }
+
+        bool spilled() const {
+            return file_ != nullptr;
+        }
+
+        size_t memoryUsage() const {
+            return memory_.size();
+        }
+
+    private:
+        size_t memoryLimit_;
+        size_t size_ = 0;
+        std::string memory_;
+        std::FILE* file_ = nullptr;
+        void* mapping_ = nullptr;
+        size_t mappedSize_ = 0;
+
+        void unmap();
+    };
+
+}
@@ -0,0 +1,207 @@
+﻿#include "connection_pool.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace lunarica {
+
+ConnectionPool::Lease::Lease(ConnectionPool* pool, std::string key, std::unique_ptr<PooledClient> client,
+                             int connectionTimeout, int readTimeout, bool reused)
+    : pool_(pool), key_(std::move(key)), client_(std::move(client)),
+      connectionTimeout_(connectionTimeout), readTimeout_(readTimeout), reused_(reused) {
+}
+
+ConnectionPool::Lease::Lease(Lease&& other) noexcept
+    : pool_(other.pool_), key_(std::move(other.key_)), client_(std::move(other.client_)),
+      connectionTimeout_(other.connectionTimeout_), readTimeout_(other.readTimeout_), reused_(other.reused_) {
+    other.pool_ = nullptr;
+}
+
+ConnectionPool::Lease& ConnectionPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool_ = other.pool_;
+        key_ = std::move(other.key_);
+        client_ = std::move(other.client_);
+        connectionTimeout_ = other.connectionTimeout_;
+        readTimeout_ = other.readTimeout_;
+        reused_ = other.reused_;
+        other.pool_ = nullptr;
+    }
+    return *this;
+}
+
+ConnectionPool::Lease::~Lease() {
+    release();
+}
+
+bool ConnectionPool::Lease::unpin() {
+    if (!client_ || !client_->pinned) {
+        return false;
+    }
+
+    // Walk the cached addresses in resolver order; once they are used up,
+    // let httplib resolve the name itself in case the cache went stale.
+    PooledClient& pooled = *client_;
+    if (++pooled.addressIndex < pooled.addresses.size()) {
+        pooled.client.set_hostname_addr_map({{pooled.hostname, pooled.addresses[pooled.addressIndex]}});
+        return true;
+    }
+
+    pooled.client.set_hostname_addr_map({});
+    pooled.pinned = false;
+    return true;
+}
+
+void ConnectionPool::Lease::discard() {
+    client_.reset();
+    pool_ = nullptr;
+}
+
+void ConnectionPool::Lease::release() {
+    if (pool_ && client_) {
+        pool_->release(key_, std::move(client_), connectionTimeout_, readTimeout_);
+    }
+    pool_ = nullptr;
+}
+
+ConnectionPool::ConnectionPool(std::shared_ptr<Context> context)
+    : context_(std::move(context)) {
+}
+
+ConnectionPool::Lease ConnectionPool::acquire(const std::string& scheme, const std::string& host) {
+    std::string key = makeKey(scheme, host);
+    int connectionTimeout = context_->getConnectionTimeout();
+    int readTimeout = context_->getReadTimeout();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        evictIdleLocked(Clock::now());
+
+        auto it = idle_.find(key);
+        if (it != idle_.end()) {
+            auto& clients = it->second;
+            while (!clients.empty()) {
+                IdleClient entry = std::move(clients.back());
+                clients.pop_back();
+
+                if (entry.connectionTimeout == connectionTimeout && entry.readTimeout == readTimeout) {
+                    return Lease(this, key, std::move(entry.client), connectionTimeout, readTimeout, true);
+                }
+            }
+            idle_.erase(it);
+        }
+    }
+
+    return Lease(this, key, createClient(key, connectionTimeout, readTimeout),
+                 connectionTimeout, readTimeout, false);
+}
+
+void ConnectionPool::prefetch(const std::string& host) {
+    dnsCache_.prefetch(DnsResolver::hostnameOf(host));
+}
+
+void ConnectionPool::evictIdle() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    evictIdleLocked(Clock::now());
+}
+
+void ConnectionPool::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_.clear();
+}
+
+size_t ConnectionPool::idleCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (const auto& [_, clients] : idle_) {
+        count += clients.size();
+    }
+    return count;
+}
+
+std::string ConnectionPool::makeKey(const std::string& scheme, const std::string& host) {
+    std::string normalizedScheme = scheme.empty() ? "http" : scheme;
+    std::transform(normalizedScheme.begin(), normalizedScheme.end(), normalizedScheme.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+
+    std::string normalizedHost = host;
+    std::transform(normalizedHost.begin(), normalizedHost.end(), normalizedHost.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+
+    size_t bracketEnd = normalizedHost.rfind(']');
+    size_t portSep = normalizedHost.rfind(':');
+    bool hasPort = portSep != std::string::npos &&
+                   (bracketEnd == std::string::npos || portSep > bracketEnd);
+
+    if (!hasPort) {
+        normalizedHost += normalizedScheme == "https" ? ":443" : ":80";
+    }
+
+    return normalizedScheme + "://" + normalizedHost;
+}
+
+void ConnectionPool::release(const std::string& key, std::unique_ptr<PooledClient> client,
+                             int connectionTimeout, int readTimeout) {
+    if (context_->getIdleTimeout() <= 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& clients = idle_[key];
+    clients.push_back({std::move(client), Clock::now(), connectionTimeout, readTimeout});
+    // acquire() takes from the back, so the front has been idle the longest.
+    if (clients.size() > kMaxIdlePerHost) {
+        clients.erase(clients.begin());
+    }
+}
+
+void ConnectionPool::evictIdleLocked(Clock::time_point now) {
+    auto maxIdle = std::chrono::seconds(context_->getIdleTimeout());
+
+    for (auto it = idle_.begin(); it != idle_.end();) {
+        auto& clients = it->second;
+        clients.erase(std::remove_if(clients.begin(), clients.end(),
+                                     [&](const IdleClient& entry) { return now - entry.lastUsed >= maxIdle; }),
+                      clients.end());
+
+        if (clients.empty()) {
+            it = idle_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+std::unique_ptr<ConnectionPool::PooledClient> ConnectionPool::createClient(const std::string& key,
+                                                                           int connectionTimeout, int readTimeout) {
+    auto pooled = std::make_unique<PooledClient>(key);
+    httplib::Client& client = pooled->client;
+    client.set_connection_timeout(connectionTimeout);
+    client.set_read_timeout(readTimeout);
+    client.set_keep_alive(true);
+    client.set_follow_location(true);
+    client.set_decompress(false);
+
+    pooled->probe.attach(client);
+    pooled->probe.attachSessions(client, tlsSessions_, key);
+
+    std::string hostname = DnsResolver::hostnameOf(key.substr(key.find("://") + 3));
+    if (!DnsResolver::isNumericAddress(hostname)) {
+        ResolveResult resolved = dnsCache_.resolve(hostname);
+        pooled->probe.addResolveTime(resolved.elapsed);
+
+        if (resolved.ok) {
+            client.set_hostname_addr_map({{hostname, resolved.address}});
+            pooled->hostname = hostname;
+            pooled->addresses = std::move(resolved.addresses);
+            pooled->pinned = true;
+        } else {
+            pooled->resolveError = resolved.error;
+        }
+    }
+
+    return pooled;
+}
+
+}
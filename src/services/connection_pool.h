@@ -0,0 +1,110 @@
+﻿#pragma once
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <httplib.h>
+#include "core/context.h"
+#include "dns_cache.h"
+#include "request_timing.h"
+#include "tls_session_cache.h"
+
+namespace lunarica {
+
+    class ConnectionPool {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr size_t kMaxIdlePerHost = 32;
+
+        struct PooledClient {
+            explicit PooledClient(const std::string& key) : client(key) {}
+
+            httplib::Client client;
+            ConnectionProbe probe;
+            std::string hostname;
+            std::vector<std::string> addresses;
+            size_t addressIndex = 0;
+            bool pinned = false;
+            std::string resolveError;
+        };
+
+        class Lease {
+        public:
+            Lease() = default;
+            Lease(ConnectionPool* pool, std::string key, std::unique_ptr<PooledClient> client,
+                  int connectionTimeout, int readTimeout, bool reused);
+            Lease(Lease&& other) noexcept;
+            Lease& operator=(Lease&& other) noexcept;
+            Lease(const Lease&) = delete;
+            Lease& operator=(const Lease&) = delete;
+            ~Lease();
+
+            httplib::Client& client() { return client_->client; }
+            httplib::Client* operator->() { return &client_->client; }
+            ConnectionProbe& probe() { return client_->probe; }
+
+            const std::string& key() const { return key_; }
+            bool isReused() const { return reused_; }
+            const std::string& resolveError() const { return client_->resolveError; }
+
+            bool unpin();
+            void discard();
+
+        private:
+            ConnectionPool* pool_ = nullptr;
+            std::string key_;
+            std::unique_ptr<PooledClient> client_;
+            int connectionTimeout_ = 0;
+            int readTimeout_ = 0;
+            bool reused_ = false;
+
+            void release();
+        };
+
+        explicit ConnectionPool(std::shared_ptr<Context> context);
+        ~ConnectionPool() = default;
+
+        Lease acquire(const std::string& scheme, const std::string& host);
+
+        void evictIdle();
+        void clear();
+        size_t idleCount() const;
+
+        void prefetch(const std::string& host);
+
+        DnsCache& getDnsCache() {
+            return dnsCache_;
+        }
+
+        TlsSessionCache& getTlsSessions() {
+            return tlsSessions_;
+        }
+
+        static std::string makeKey(const std::string& scheme, const std::string& host);
+
+    private:
+        struct IdleClient {
+            std::unique_ptr<PooledClient> client;
+            Clock::time_point lastUsed;
+            int connectionTimeout;
+            int readTimeout;
+        };
+
+        std::shared_ptr<Context> context_;
+        DnsCache dnsCache_;
+        TlsSessionCache tlsSessions_;
+        mutable std::mutex mutex_;
+        std::map<std::string, std::vector<IdleClient>> idle_;
+
+        void release(const std::string& key, std::unique_ptr<PooledClient> client,
+                     int connectionTimeout, int readTimeout);
+        void evictIdleLocked(Clock::time_point now);
+        std::unique_ptr<PooledClient> createClient(const std::string& key,
+                                                   int connectionTimeout, int readTimeout);
+    };
+
+}
@@ -0,0 +1,245 @@
+﻿#include "content_decoder.h"
+
+#include <algorithm>
+#include <cctype>
+#include <vector>
+
+#ifdef LUNARICA_ZLIB_SUPPORT
+#include <zlib.h>
+#endif
+
+#ifdef LUNARICA_BROTLI_SUPPORT
+#include <brotli/decode.h>
+#endif
+
+namespace lunarica {
+
+namespace {
+
+std::string normalize(const std::string& encoding) {
+    std::string result;
+    for (char c : encoding) {
+        if (!std::isspace(static_cast<unsigned char>(c))) {
+            result += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+    }
+    return result;
+}
+
+#ifdef LUNARICA_ZLIB_SUPPORT
+
+class ZlibDecoder : public ContentDecoder {
+public:
+    explicit ZlibDecoder(bool gzip) : ContentDecoder(gzip ? "gzip" : "deflate"), gzip_(gzip), output_(kOutputChunk) {
+    }
+
+    ~ZlibDecoder() override {
+        if (initialized_) {
+            inflateEnd(&stream_);
+        }
+    }
+
+    bool feed(const char* data, size_t length, const Sink& sink) override {
+        if (length == 0) {
+            return true;
+        }
+        seen_ = true;
+
+        if (!initialized_) {
+            if (gzip_) {
+                return start(15 + 32) && inflate(data, length, sink);
+            }
+            header_.append(data, length);
+            if (header_.size() < 2) {
+                return true;
+            }
+            auto cmf = static_cast<unsigned char>(header_[0]);
+            auto flg = static_cast<unsigned char>(header_[1]);
+            bool wrapped = (cmf & 0x0f) == 8 && (cmf * 256 + flg) % 31 == 0;
+            std::string pending = std::move(header_);
+            return start(wrapped ? 15 : -15) && inflate(pending.data(), pending.size(), sink);
+        }
+        return inflate(data, length, sink);
+    }
+
+    bool finish(const Sink& sink) override {
+        if (!seen_) {
+            return true;
+        }
+        if (!initialized_ && !start(-15)) {
+            return false;
+        }
+        if (!header_.empty()) {
+            std::string pending = std::move(header_);
+            if (!inflate(pending.data(), pending.size(), sink)) {
+                return false;
+            }
+        }
+        if (!ended_) {
+            error_ = "truncated " + name_ + " stream";
+            return false;
+        }
+        return true;
+    }
+
+private:
+    bool gzip_;
+    bool initialized_ = false;
+    bool seen_ = false;
+    bool ended_ = false;
+    z_stream stream_{};
+    std::string header_;
+    std::vector<char> output_;
+
+    bool start(int windowBits) {
+        if (inflateInit2(&stream_, windowBits) != Z_OK) {
+            error_ = "could not initialize " + name_ + " decoder";
+            return false;
+        }
+        initialized_ = true;
+        return true;
+    }
+
+    bool inflate(const char* data, size_t length, const Sink& sink) {
+        stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        stream_.avail_in = static_cast<uInt>(length);
+
+        while (stream_.avail_in > 0) {
+            if (ended_) {
+                if (!gzip_) {
+                    return true;
+                }
+                inflateReset(&stream_);
+                ended_ = false;
+            }
+
+            stream_.next_out = reinterpret_cast<Bytef*>(output_.data());
+            stream_.avail_out = static_cast<uInt>(output_.size());
+            int result = ::inflate(&stream_, Z_NO_FLUSH);
+            if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) {
+                error_ = "invalid " + name_ + " data" + (stream_.msg ? std::string(": ") + stream_.msg : "");
+                return false;
+            }
+
+            size_t produced = output_.size() - stream_.avail_out;
+            if (produced > 0 && !sink(output_.data(), produced)) {
+                return false;
+            }
+            ended_ = result == Z_STREAM_END;
+            if (result == Z_BUF_ERROR && produced == 0) {
+                break;
+            }
+        }
+        return true;
+    }
+};
+
+#endif
+
+#ifdef LUNARICA_BROTLI_SUPPORT
+
+class BrotliDecoder : public ContentDecoder {
+public:
+    BrotliDecoder() : ContentDecoder("br"), state_(BrotliDecoderCreateInstance(nullptr, nullptr, nullptr)),
+                      output_(kOutputChunk) {
+    }
+
+    ~BrotliDecoder() override {
+        if (state_) {
+            BrotliDecoderDestroyInstance(state_);
+        }
+    }
+
+    bool feed(const char* data, size_t length, const Sink& sink) override {
+        if (length == 0) {
+            return true;
+        }
+        seen_ = true;
+        if (!state_) {
+            error_ = "could not initialize br decoder";
+            return false;
+        }
+
+        auto input = reinterpret_cast<const uint8_t*>(data);
+        size_t available = length;
+        while (result_ != BROTLI_DECODER_RESULT_SUCCESS) {
+            auto output = reinterpret_cast<uint8_t*>(output_.data());
+            size_t space = output_.size();
+            result_ = BrotliDecoderDecompressStream(state_, &available, &input, &space, &output, nullptr);
+            if (result_ == BROTLI_DECODER_RESULT_ERROR) {
+                error_ = std::string("invalid br data: ") +
+                         BrotliDecoderErrorString(BrotliDecoderGetErrorCode(state_));
+                return false;
+            }
+
+            size_t produced = output_.size() - space;
+            if (produced > 0 && !sink(output_.data(), produced)) {
+                return false;
+            }
+            if (result_ == BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT) {
+                break;
+            }
+        }
+        return true;
+    }
+
+    bool finish(const Sink&) override {
+        if (seen_ && result_ != BROTLI_DECODER_RESULT_SUCCESS) {
+            error_ = "truncated br stream";
+            return false;
+        }
+        return true;
+    }
+
+private:
+    BrotliDecoderState* state_;
+    BrotliDecoderResult result_ = BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT;
+    bool seen_ = false;
+    std::vector<char> output_;
+};
+
+#endif
+
+}
+
+std::unique_ptr<ContentDecoder> ContentDecoder::create(const std::string& encoding, std::string& error) {
+    std::string coding = normalize(encoding);
+    if (isIdentity(coding)) {
+        return nullptr;
+    }
+
+#ifdef LUNARICA_ZLIB_SUPPORT
+    if (coding == "gzip" || coding == "x-gzip") {
+        return std::make_unique<ZlibDecoder>(true);
+    }
+    if (coding == "deflate") {
+        return std::make_unique<ZlibDecoder>(false);
+    }
+#endif
+#ifdef LUNARICA_BROTLI_SUPPORT
+    if (coding == "br") {
+        return std::make_unique<BrotliDecoder>();
+    }
+#endif
+
+    error = "unsupported Content-Encoding: " + encoding;
+    return nullptr;
+}
+
+std::string ContentDecoder::acceptEncoding() {
+    std::string result;
+#ifdef LUNARICA_ZLIB_SUPPORT
+    result = "gzip, deflate";
+#endif
+#ifdef LUNARICA_BROTLI_SUPPORT
+    result += result.empty() ? "br" : ", br";
+#endif
+    return result;
+}
+
+bool ContentDecoder::isIdentity(const std::string& encoding) {
+    std::string coding = normalize(encoding);
+    return coding.empty() || coding == "identity";
+}
+
+}
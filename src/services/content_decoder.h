@@ -0,0 +1,41 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace lunarica {
+
+    class ContentDecoder {
+    public:
+        using Sink = std::function<bool(const char*, size_t)>;
+
+        virtual ~ContentDecoder() = default;
+
+        static std::unique_ptr<ContentDecoder> create(const std::string& encoding, std::string& error);
+        static std::string acceptEncoding();
+        static bool isIdentity(const std::string& encoding);
+
+        virtual bool feed(const char* data, size_t length, const Sink& sink) = 0;
+        virtual bool finish(const Sink& sink) = 0;
+
+        const std::string& name() const {
+            return name_;
+        }
+
+        const std::string& error() const {
+            return error_;
+        }
+
+    protected:
+        static constexpr size_t kOutputChunk = 64 * 1024;
+
+        explicit ContentDecoder(std::string name) : name_(std::move(name)) {
+        }
+
+        std::string name_;
+        std::string error_;
+    };
+
+}
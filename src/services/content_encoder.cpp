@@ -0,0 +1,130 @@
+﻿#include "content_encoder.h"
+
+#ifdef LUNARICA_ZLIB_SUPPORT
+#include <zlib.h>
+#endif
+
+namespace lunarica {
+
+namespace {
+
+constexpr size_t kOutputChunk = 64 * 1024;
+
+}
+
+#ifdef LUNARICA_ZLIB_SUPPORT
+
+struct ContentEncoder::State {
+    z_stream stream{};
+    bool initialized = false;
+};
+
+#else
+
+struct ContentEncoder::State {
+};
+
+#endif
+
+ContentEncoder::ContentEncoder(int level)
+    : level_(level), state_(std::make_unique<State>()), output_(kOutputChunk) {
+}
+
+ContentEncoder::~ContentEncoder() {
+#ifdef LUNARICA_ZLIB_SUPPORT
+    if (state_->initialized) {
+        deflateEnd(&state_->stream);
+    }
+#endif
+}
+
+std::unique_ptr<ContentEncoder> ContentEncoder::create(int level, std::string& error) {
+#ifdef LUNARICA_ZLIB_SUPPORT
+    if (level < 1 || level > 9) {
+        error = "compression level must be between 1 and 9";
+        return nullptr;
+    }
+    std::unique_ptr<ContentEncoder> encoder(new ContentEncoder(level));
+    z_stream& stream = encoder->state_->stream;
+    if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        error = "could not initialize gzip encoder";
+        return nullptr;
+    }
+    encoder->state_->initialized = true;
+    return encoder;
+#else
+    (void)level;
+    error = "request compression is not available in this build";
+    return nullptr;
+#endif
+}
+
+bool ContentEncoder::available() {
+#ifdef LUNARICA_ZLIB_SUPPORT
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::string ContentEncoder::compress(std::string_view input, int level, std::string& error) {
+    std::string result;
+    auto encoder = create(level, error);
+    if (!encoder) {
+        return result;
+    }
+
+    auto append = [&result](const char* data, size_t length) {
+        result.append(data, length);
+        return true;
+    };
+    if (!encoder->feed(input.data(), input.size(), append) || !encoder->finish(append)) {
+        error = encoder->error();
+        result.clear();
+    }
+    return result;
+}
+
+bool ContentEncoder::feed(const char* data, size_t length, const Sink& sink) {
+    return length == 0 || deflate(data, length, false, sink);
+}
+
+bool ContentEncoder::finish(const Sink& sink) {
+    return deflate(nullptr, 0, true, sink);
+}
+
+#ifdef LUNARICA_ZLIB_SUPPORT
+
+bool ContentEncoder::deflate(const char* data, size_t length, bool last, const Sink& sink) {
+    z_stream& stream = state_->stream;
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = static_cast<uInt>(length);
+
+    int result = Z_OK;
+    do {
+        stream.next_out = reinterpret_cast<Bytef*>(output_.data());
+        stream.avail_out = static_cast<uInt>(output_.size());
+        result = ::deflate(&stream, last ? Z_FINISH : Z_NO_FLUSH);
+        if (result == Z_STREAM_ERROR) {
+            error_ = "gzip encoder failed";
+            return false;
+        }
+
+        size_t produced = output_.size() - stream.avail_out;
+        if (produced > 0 && !sink(output_.data(), produced)) {
+            return false;
+        }
+    } while (stream.avail_out == 0 || (last && result != Z_STREAM_END));
+    return true;
+}
+
+#else
+
+bool ContentEncoder::deflate(const char*, size_t, bool, const Sink&) {
+    error_ = "request compression is not available in this build";
+    return false;
+}
+
+#endif
+
+}
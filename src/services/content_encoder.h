@@ -0,0 +1,53 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lunarica {
+
+    class ContentEncoder {
+    public:
+        using Sink = std::function<bool(const char*, size_t)>;
+
+        ~ContentEncoder();
+        ContentEncoder(const ContentEncoder&) = delete;
+        ContentEncoder& operator=(const ContentEncoder&) = delete;
+
+        static std::unique_ptr<ContentEncoder> create(int level, std::string& error);
+        static bool available();
+        static std::string compress(std::string_view input, int level, std::string& error);
+
+        bool feed(const char* data, size_t length, const Sink& sink);
+        bool finish(const Sink& sink);
+
+        const std::string& name() const {
+            return name_;
+        }
+
+        int level() const {
+            return level_;
+        }
+
+        const std::string& error() const {
+            return error_;
+        }
+
+    private:
+        struct State;
+
+        explicit ContentEncoder(int level);
+
+        std::string name_ = "gzip";
+        std::string error_;
+        int level_;
+        std::unique_ptr<State> state_;
+        std::vector<char> output_;
+
+        bool deflate(const char* data, size_t length, bool last, const Sink& sink);
+    };
+
+}
@@ -0,0 +1,96 @@
+﻿#include "dns_cache.h"
+
+#include <algorithm>
+
+namespace lunarica {
+
+DnsCache::DnsCache(Lookup lookup) : lookup_(std::move(lookup)) {
+    if (!lookup_) {
+        lookup_ = [this](const std::string& hostname) {
+            return resolver_.resolve(hostname);
+        };
+    }
+}
+
+DnsCache::~DnsCache() {
+    for (auto& prefetch : prefetches_) {
+        prefetch.wait();
+    }
+}
+
+ResolveResult DnsCache::resolve(const std::string& hostname) {
+    auto started = Clock::now();
+    ResolveResult result;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!claim(hostname, lock, result)) {
+            result.elapsed = Clock::now() - started;
+            return result;
+        }
+    }
+
+    result = lookup_(hostname);
+    store(hostname, result);
+    return result;
+}
+
+void DnsCache::prefetch(const std::string& hostname) {
+    if (hostname.empty() || DnsResolver::isNumericAddress(hostname)) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = entries_.find(hostname);
+    if (it != entries_.end() && (it->second.pending || it->second.expires > Clock::now())) {
+        return;
+    }
+    entries_[hostname] = Entry();
+
+    prefetches_.erase(std::remove_if(prefetches_.begin(), prefetches_.end(), [](const std::future<void>& prefetch) {
+        return prefetch.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }), prefetches_.end());
+    prefetches_.push_back(std::async(std::launch::async, [this, hostname] {
+        store(hostname, lookup_(hostname));
+    }));
+}
+
+void DnsCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        it = it->second.pending ? std::next(it) : entries_.erase(it);
+    }
+}
+
+size_t DnsCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+bool DnsCache::claim(const std::string& hostname, std::unique_lock<std::mutex>& lock, ResolveResult& cached) {
+    while (true) {
+        auto it = entries_.find(hostname);
+        if (it == entries_.end() || (!it->second.pending && it->second.expires <= Clock::now())) {
+            entries_[hostname] = Entry();
+            return true;
+        }
+        if (!it->second.pending) {
+            cached = it->second.result;
+            cached.cached = true;
+            return false;
+        }
+        ready_.wait(lock);
+    }
+}
+
+void DnsCache::store(const std::string& hostname, const ResolveResult& result) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Entry& entry = entries_[hostname];
+        entry.result = result;
+        entry.pending = false;
+        entry.expires = Clock::now() + (result.ok ? ttl_ : negativeTtl_);
+    }
+    ready_.notify_all();
+}
+
+}
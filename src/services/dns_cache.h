@@ -0,0 +1,56 @@
+﻿#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "dns_resolver.h"
+
+namespace lunarica {
+
+    class DnsCache {
+    public:
+        using Clock = std::chrono::steady_clock;
+        using Lookup = std::function<ResolveResult(const std::string&)>;
+
+        explicit DnsCache(Lookup lookup = {});
+        ~DnsCache();
+        DnsCache(const DnsCache&) = delete;
+        DnsCache& operator=(const DnsCache&) = delete;
+
+        ResolveResult resolve(const std::string& hostname);
+        void prefetch(const std::string& hostname);
+        void clear();
+        size_t size() const;
+
+        void setTtl(std::chrono::seconds positive, std::chrono::seconds negative) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ttl_ = positive;
+            negativeTtl_ = negative;
+        }
+
+    private:
+        struct Entry {
+            ResolveResult result;
+            Clock::time_point expires;
+            bool pending = true;
+        };
+
+        Lookup lookup_;
+        DnsResolver resolver_;
+        mutable std::mutex mutex_;
+        std::condition_variable ready_;
+        std::map<std::string, Entry> entries_;
+        std::vector<std::future<void>> prefetches_;
+        std::chrono::seconds ttl_{60};
+        std::chrono::seconds negativeTtl_{5};
+
+        bool claim(const std::string& hostname, std::unique_lock<std::mutex>& lock, ResolveResult& cached);
+        void store(const std::string& hostname, const ResolveResult& result);
+    };
+
+}
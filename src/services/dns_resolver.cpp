@@ -0,0 +1,73 @@
+﻿#include "dns_resolver.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#endif
+
+namespace lunarica {
+
+ResolveResult DnsResolver::resolve(const std::string& hostname) {
+    ResolveResult result;
+    auto started = std::chrono::steady_clock::now();
+
+    struct addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo* info = nullptr;
+    int rc = getaddrinfo(hostname.c_str(), nullptr, &hints, &info);
+
+    if (rc == 0 && info != nullptr) {
+        for (struct addrinfo* entry = info; entry != nullptr; entry = entry->ai_next) {
+            char buffer[NI_MAXHOST] = {0};
+            if (getnameinfo(entry->ai_addr, static_cast<socklen_t>(entry->ai_addrlen),
+                            buffer, sizeof(buffer), nullptr, 0, NI_NUMERICHOST) == 0 &&
+                std::find(result.addresses.begin(), result.addresses.end(), buffer) == result.addresses.end()) {
+                result.addresses.emplace_back(buffer);
+            }
+        }
+        result.ok = !result.addresses.empty();
+        if (result.ok) {
+            result.address = result.addresses.front();
+        } else {
+            result.error = "could not format resolved address";
+        }
+    } else {
+        result.error = gai_strerror(rc);
+    }
+
+    if (info != nullptr) {
+        freeaddrinfo(info);
+    }
+
+    result.elapsed = std::chrono::steady_clock::now() - started;
+    return result;
+}
+
+bool DnsResolver::isNumericAddress(const std::string& hostname) {
+    unsigned char buffer[16];
+    return inet_pton(AF_INET, hostname.c_str(), buffer) == 1 ||
+           inet_pton(AF_INET6, hostname.c_str(), buffer) == 1;
+}
+
+std::string DnsResolver::hostnameOf(const std::string& hostAndPort) {
+    if (!hostAndPort.empty() && hostAndPort[0] == '[') {
+        size_t end = hostAndPort.find(']');
+        return end == std::string::npos ? hostAndPort.substr(1) : hostAndPort.substr(1, end - 1);
+    }
+
+    size_t colon = hostAndPort.rfind(':');
+    if (colon != std::string::npos && hostAndPort.find(':') == colon) {
+        return hostAndPort.substr(0, colon);
+    }
+    return hostAndPort;
+}
+
+}
@@ -0,0 +1,29 @@
+﻿#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace lunarica {
+
+    struct ResolveResult {
+        bool ok = false;
+        std::string address;
+        std::vector<std::string> addresses;
+        std::string error;
+        std::chrono::nanoseconds elapsed{0};
+        bool cached = false;
+    };
+
+    class DnsResolver {
+    public:
+        DnsResolver() = default;
+        ~DnsResolver() = default;
+
+        ResolveResult resolve(const std::string& hostname);
+
+        static bool isNumericAddress(const std::string& hostname);
+        static std::string hostnameOf(const std::string& hostAndPort);
+    };
+
+}
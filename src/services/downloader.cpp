@@ -0,0 +1,401 @@
+﻿#include "downloader.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <fmt/core.h>
+#include "utils/interrupt_guard.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <mutex>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace lunarica {
+
+namespace {
+
+constexpr int kMaxRetries = 3;
+constexpr auto kProgressInterval = std::chrono::milliseconds(200);
+constexpr auto kSaveInterval = std::chrono::seconds(1);
+
+int openFile(const std::string& path, bool truncate) {
+#ifdef _WIN32
+    int flags = _O_RDWR | _O_CREAT | _O_BINARY | (truncate ? _O_TRUNC : 0);
+    return _open(path.c_str(), flags, _S_IREAD | _S_IWRITE);
+#else
+    int flags = O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0);
+    return open(path.c_str(), flags, 0644);
+#endif
+}
+
+void closeFile(int fd) {
+#ifdef _WIN32
+    _close(fd);
+#else
+    close(fd);
+#endif
+}
+
+bool resizeFile(int fd, uint64_t size) {
+#ifdef _WIN32
+    return _chsize_s(fd, static_cast<__int64>(size)) == 0;
+#else
+    return ftruncate(fd, static_cast<off_t>(size)) == 0;
+#endif
+}
+
+bool writeAt(int fd, const char* data, size_t length, uint64_t offset) {
+#ifdef _WIN32
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (_lseeki64(fd, static_cast<__int64>(offset), SEEK_SET) < 0) {
+        return false;
+    }
+#endif
+    while (length > 0) {
+#ifdef _WIN32
+        int written = _write(fd, data, static_cast<unsigned>(std::min<size_t>(length, 1u << 30)));
+#else
+        ssize_t written = pwrite(fd, data, length, static_cast<off_t>(offset));
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+#endif
+        if (written <= 0) {
+            return false;
+        }
+        data += written;
+        length -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+    return true;
+}
+
+HttpRequest asGet(const HttpRequest& request) {
+    HttpRequest get = request;
+    get.method = "GET";
+    get.body.clear();
+    get.headers.erase("Content-Type");
+    get.headers.erase("Range");
+    return get;
+}
+
+}
+
+bool DownloadState::load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+
+    segments.clear();
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t space = line.find(' ');
+        std::string key = line.substr(0, space);
+        std::string value = space == std::string::npos ? "" : line.substr(space + 1);
+
+        if (key == "url") {
+            url = value;
+        } else if (key == "size") {
+            size = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "validator") {
+            validator = value;
+        } else if (key == "segment") {
+            DownloadSegment segment;
+            std::istringstream fields(value);
+            if (!(fields >> segment.begin >> segment.end >> segment.done) ||
+                segment.end < segment.begin || segment.done > segment.end - segment.begin) {
+                return false;
+            }
+            segments.push_back(segment);
+        }
+    }
+    return !segments.empty() && segments.back().end == size;
+}
+
+bool DownloadState::save(const std::string& path) const {
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        out << "url " << url << '\n';
+        out << "size " << size << '\n';
+        out << "validator " << validator << '\n';
+        for (const auto& segment : segments) {
+            out << "segment " << segment.begin << ' ' << segment.end << ' ' << segment.done << '\n';
+        }
+        if (!out.flush()) {
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    return !error;
+}
+
+uint64_t DownloadState::completed() const {
+    uint64_t total = 0;
+    for (const auto& segment : segments) {
+        total += segment.done;
+    }
+    return total;
+}
+
+std::vector<DownloadSegment> DownloadState::split(uint64_t size, size_t parts) {
+    std::vector<DownloadSegment> segments;
+    parts = static_cast<size_t>(std::min<uint64_t>(std::max<size_t>(parts, 1), size));
+    for (size_t i = 0; i < parts; ++i) {
+        DownloadSegment segment;
+        segment.begin = size * i / parts;
+        segment.end = size * (i + 1) / parts;
+        segments.push_back(segment);
+    }
+    return segments;
+}
+
+double DownloadProgress::throughput() const {
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    return seconds > 0.0 ? static_cast<double>(received) / seconds : 0.0;
+}
+
+Downloader::Downloader(std::shared_ptr<HttpService> httpService)
+    : httpService_(std::move(httpService)) {
+}
+
+DownloadReport Downloader::run(const HttpRequest& request, const std::string& path,
+                               const DownloadOptions& options, const ProgressCallback& progress) {
+    DownloadReport report;
+    DownloadState state;
+    state.url = request.url;
+    if (!probe(request, state, report.ranged, report.error)) {
+        return report;
+    }
+
+    std::string sidecar = statePath(path);
+    DownloadState saved;
+    std::error_code sizeError;
+    bool resume = report.ranged && saved.load(sidecar) && saved.url == state.url && saved.size == state.size &&
+                  saved.validator == state.validator && std::filesystem::file_size(path, sizeError) == state.size;
+
+    int fd = openFile(path, !resume);
+    if (fd < 0) {
+        report.error = "Cannot open " + path + ": " + std::strerror(errno);
+        return report;
+    }
+
+    if (report.ranged) {
+        state.segments = resume ? saved.segments : DownloadState::split(state.size, options.connections);
+        if (!resume && !resizeFile(fd, state.size)) {
+            report.error = "Cannot allocate " + path + ": " + std::strerror(errno);
+            closeFile(fd);
+            return report;
+        }
+    }
+
+    size_t parts = report.ranged ? state.segments.size() : 1;
+    std::unique_ptr<std::atomic<uint64_t>[]> done(new std::atomic<uint64_t>[parts]);
+    std::vector<std::string> errors(parts);
+    std::atomic<uint64_t> received{0};
+    std::atomic<size_t> active{0};
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> workers;
+
+    report.progress.total = state.size;
+    report.progress.resumed = state.completed();
+    auto started = Clock::now();
+
+    for (size_t i = 0; i < parts; ++i) {
+        DownloadSegment segment = report.ranged ? state.segments[i] : DownloadSegment();
+        done[i] = segment.done;
+        if (report.ranged && segment.remaining() == 0) {
+            continue;
+        }
+        active++;
+        workers.emplace_back([&, i, segment]() {
+            if (report.ranged) {
+                fetchRange(request, fd, segment, done[i], received, stop, errors[i]);
+            } else {
+                fetchWhole(request, fd, received, stop, errors[i]);
+            }
+            active--;
+        });
+    }
+    report.progress.connections = workers.size();
+
+    auto snapshot = [&]() {
+        report.progress.received = received.load();
+        report.progress.elapsed = Clock::now() - started;
+        for (size_t i = 0; report.ranged && i < parts; ++i) {
+            state.segments[i].done = done[i].load();
+        }
+    };
+
+    {
+        InterruptGuard interrupt;
+        auto lastSave = started;
+        while (active > 0) {
+            std::this_thread::sleep_for(kProgressInterval);
+            if (interrupt.triggered()) {
+                stop = true;
+                report.interrupted = true;
+            }
+            snapshot();
+            if (progress) {
+                progress(report.progress);
+            }
+            if (report.ranged && Clock::now() - lastSave >= kSaveInterval) {
+                state.save(sidecar);
+                lastSave = Clock::now();
+            }
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+    closeFile(fd);
+    snapshot();
+
+    for (const auto& error : errors) {
+        if (!error.empty()) {
+            report.error = error;
+            break;
+        }
+    }
+
+    if (report.ranged) {
+        report.completed = state.completed() == state.size;
+    } else {
+        report.completed = report.error.empty() && !report.interrupted &&
+                           (state.size == 0 || report.progress.received == state.size);
+    }
+
+    std::error_code ignored;
+    if (report.completed) {
+        std::filesystem::remove(sidecar, ignored);
+    } else if (report.ranged) {
+        state.save(sidecar);
+    }
+    return report;
+}
+
+bool Downloader::probe(const HttpRequest& request, DownloadState& state, bool& ranged, std::string& error) {
+    HttpRequest head = asGet(request);
+    head.method = "HEAD";
+
+    auto res = httpService_->send(head);
+    if (!res) {
+        error = httplib::to_string(res.error());
+        return false;
+    }
+
+    ranged = false;
+    if (res->status < 200 || res->status >= 300) {
+        return true;
+    }
+
+    std::string length = res->get_header_value("Content-Length");
+    if (!length.empty()) {
+        state.size = std::strtoull(length.c_str(), nullptr, 10);
+    }
+    state.validator = res->get_header_value("ETag");
+    if (state.validator.empty()) {
+        state.validator = res->get_header_value("Last-Modified");
+    }
+    ranged = state.size > 0 && res->get_header_value("Accept-Ranges").find("bytes") != std::string::npos;
+    return true;
+}
+
+void Downloader::fetchRange(const HttpRequest& request, int fd, DownloadSegment segment,
+                            std::atomic<uint64_t>& done, std::atomic<uint64_t>& received,
+                            const std::atomic<bool>& stop, std::string& error) {
+    uint64_t offset = segment.begin + segment.done;
+    int attempts = 0;
+
+    while (!stop && offset < segment.end) {
+        HttpRequest ranged = asGet(request);
+        ranged.headers.emplace("Range", fmt::format("bytes={}-{}", offset, segment.end - 1));
+
+        int status = 0;
+        ResponseHooks hooks;
+        hooks.onHeaders = [&](const httplib::Response& response) {
+            status = response.status;
+            return status == 206;
+        };
+        hooks.onBody = [&](const char* data, size_t length) {
+            if (stop) {
+                return false;
+            }
+            length = static_cast<size_t>(std::min<uint64_t>(length, segment.end - offset));
+            if (!writeAt(fd, data, length, offset)) {
+                error = std::string("Write failed: ") + std::strerror(errno);
+                return false;
+            }
+            offset += length;
+            done.store(offset - segment.begin);
+            received += length;
+            return true;
+        };
+
+        auto res = httpService_->send(ranged, hooks);
+        if (stop || !error.empty()) {
+            return;
+        }
+        if (status != 0 && status != 206) {
+            error = status == 200 ? "Server ignored the Range header" : "Range request failed with status " +
+                                                                          std::to_string(status);
+            return;
+        }
+        if ((!res || offset < segment.end) && ++attempts > kMaxRetries) {
+            error = res ? "Connection closed before the range completed" : httplib::to_string(res.error());
+            return;
+        }
+    }
+}
+
+void Downloader::fetchWhole(const HttpRequest& request, int fd, std::atomic<uint64_t>& received,
+                            const std::atomic<bool>& stop, std::string& error) {
+    uint64_t offset = 0;
+    int status = 0;
+
+    ResponseHooks hooks;
+    hooks.onHeaders = [&](const httplib::Response& response) {
+        status = response.status;
+        return status >= 200 && status < 300;
+    };
+    hooks.onBody = [&](const char* data, size_t length) {
+        if (stop) {
+            return false;
+        }
+        if (!writeAt(fd, data, length, offset)) {
+            error = std::string("Write failed: ") + std::strerror(errno);
+            return false;
+        }
+        offset += length;
+        received += length;
+        return true;
+    };
+
+    auto res = httpService_->send(asGet(request), hooks);
+    if (stop || !error.empty()) {
+        return;
+    }
+    if (status != 0 && (status < 200 || status >= 300)) {
+        error = "Request failed with status " + std::to_string(status);
+    } else if (!res) {
+        error = httplib::to_string(res.error());
+    }
+}
+
+}
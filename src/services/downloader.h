@@ -0,0 +1,84 @@
+﻿#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "http_service.h"
+
+namespace lunarica {
+
+    struct DownloadOptions {
+        size_t connections = 4;
+    };
+
+    struct DownloadSegment {
+        uint64_t begin = 0;
+        uint64_t end = 0;
+        uint64_t done = 0;
+
+        uint64_t remaining() const {
+            return end - begin - done;
+        }
+    };
+
+    struct DownloadState {
+        std::string url;
+        uint64_t size = 0;
+        std::string validator;
+        std::vector<DownloadSegment> segments;
+
+        bool load(const std::string& path);
+        bool save(const std::string& path) const;
+        uint64_t completed() const;
+
+        static std::vector<DownloadSegment> split(uint64_t size, size_t parts);
+    };
+
+    struct DownloadProgress {
+        uint64_t total = 0;
+        uint64_t received = 0;
+        uint64_t resumed = 0;
+        size_t connections = 0;
+        std::chrono::nanoseconds elapsed{0};
+
+        double throughput() const;
+    };
+
+    struct DownloadReport {
+        bool completed = false;
+        bool interrupted = false;
+        bool ranged = false;
+        std::string error;
+        DownloadProgress progress;
+    };
+
+    class Downloader {
+    public:
+        using Clock = std::chrono::steady_clock;
+        using ProgressCallback = std::function<void(const DownloadProgress&)>;
+
+        explicit Downloader(std::shared_ptr<HttpService> httpService);
+
+        DownloadReport run(const HttpRequest& request, const std::string& path,
+                           const DownloadOptions& options, const ProgressCallback& progress);
+
+        static std::string statePath(const std::string& path) {
+            return path + ".download";
+        }
+
+    private:
+        std::shared_ptr<HttpService> httpService_;
+
+        bool probe(const HttpRequest& request, DownloadState& state, bool& ranged, std::string& error);
+        void fetchRange(const HttpRequest& request, int fd, DownloadSegment segment,
+                        std::atomic<uint64_t>& done, std::atomic<uint64_t>& received,
+                        const std::atomic<bool>& stop, std::string& error);
+        void fetchWhole(const HttpRequest& request, int fd, std::atomic<uint64_t>& received,
+                        const std::atomic<bool>& stop, std::string& error);
+    };
+
+}
@@ -0,0 +1,1172 @@
+﻿#include "event_loop_engine.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <cerrno>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include "io_uring.h"
+#endif
+
+namespace lunarica {
+
+namespace {
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+        return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+    });
+}
+
+std::string_view trim(std::string_view value) {
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) {
+        value.remove_prefix(1);
+    }
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) {
+        value.remove_suffix(1);
+    }
+    return value;
+}
+
+bool hasToken(std::string_view value, std::string_view token) {
+    while (!value.empty()) {
+        size_t comma = value.find(',');
+        if (equalsIgnoreCase(trim(value.substr(0, comma)), token)) {
+            return true;
+        }
+        if (comma == std::string_view::npos) {
+            break;
+        }
+        value.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+}
+
+void ResponseFramer::reset(bool headRequest) {
+    state_ = State::Head;
+    buffer_.clear();
+    remaining_ = 0;
+    bodyBytes_ = 0;
+    status_ = 0;
+    keepAlive_ = true;
+    headRequest_ = headRequest;
+    started_ = false;
+}
+
+size_t ResponseFramer::feed(const char* data, size_t size) {
+    started_ = started_ || size > 0;
+
+    size_t offset = 0;
+    while (offset < size && state_ != State::Done && state_ != State::Failed) {
+        switch (state_) {
+            case State::Head: {
+                size_t previous = buffer_.size();
+                size_t take = std::min(size - offset, kMaxHeadSize + 1 - previous);
+                buffer_.append(data + offset, take);
+
+                size_t end = buffer_.find("\r\n\r\n", previous > 3 ? previous - 3 : 0);
+                if (end == std::string::npos) {
+                    offset += take;
+                    if (buffer_.size() > kMaxHeadSize) {
+                        state_ = State::Failed;
+                    }
+                    break;
+                }
+
+                offset += end + 4 - previous;
+                buffer_.resize(end + 4);
+                if (!parseHead()) {
+                    state_ = State::Failed;
+                }
+                buffer_.clear();
+                break;
+            }
+            case State::Body:
+                consumeBody(size, offset, State::Done);
+                break;
+            case State::ChunkData:
+                consumeBody(size, offset, State::ChunkEnd);
+                break;
+            case State::ChunkSize:
+                if (readLine(data, size, offset)) {
+                    size_t length = 0;
+                    size_t digits = 0;
+                    for (char c : buffer_) {
+                        int value = hexValue(c);
+                        if (value < 0) {
+                            break;
+                        }
+                        if (length > (SIZE_MAX >> 4)) {
+                            digits = 0;
+                            break;
+                        }
+                        length = (length << 4) | static_cast<size_t>(value);
+                        digits++;
+                    }
+                    buffer_.clear();
+
+                    if (digits == 0) {
+                        state_ = State::Failed;
+                    } else if (length == 0) {
+                        state_ = State::Trailer;
+                    } else {
+                        remaining_ = length;
+                        state_ = State::ChunkData;
+                    }
+                }
+                break;
+            case State::ChunkEnd:
+                if (readLine(data, size, offset)) {
+                    state_ = buffer_.empty() ? State::ChunkSize : State::Failed;
+                    buffer_.clear();
+                }
+                break;
+            case State::Trailer:
+                if (readLine(data, size, offset)) {
+                    if (buffer_.empty()) {
+                        state_ = State::Done;
+                    }
+                    buffer_.clear();
+                }
+                break;
+            case State::UntilClose:
+                bodyBytes_ += size - offset;
+                offset = size;
+                break;
+            default:
+                break;
+        }
+    }
+    return offset;
+}
+
+bool ResponseFramer::finishAtEof() {
+    if (state_ == State::UntilClose) {
+        state_ = State::Done;
+    }
+    return state_ == State::Done;
+}
+
+bool ResponseFramer::parseHead() {
+    std::string_view head(buffer_);
+    size_t lineEnd = head.find("\r\n");
+    std::string_view statusLine = head.substr(0, lineEnd);
+
+    size_t space = statusLine.find(' ');
+    if (statusLine.compare(0, 5, "HTTP/") != 0 || space == std::string_view::npos || space + 4 > statusLine.size()) {
+        return false;
+    }
+    auto [end, ec] = std::from_chars(statusLine.data() + space + 1, statusLine.data() + space + 4, status_);
+    if (ec != std::errc() || end != statusLine.data() + space + 4 || status_ < 100) {
+        return false;
+    }
+
+    keepAlive_ = statusLine.compare(5, 3, "1.0") != 0;
+    bool chunked = false;
+    bool hasLength = false;
+    size_t length = 0;
+
+    for (size_t pos = lineEnd + 2; pos < head.size();) {
+        size_t next = head.find("\r\n", pos);
+        std::string_view line = head.substr(pos, next - pos);
+        pos = next + 2;
+
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) {
+            continue;
+        }
+        std::string_view name = trim(line.substr(0, colon));
+        std::string_view value = trim(line.substr(colon + 1));
+
+        if (equalsIgnoreCase(name, "Content-Length")) {
+            auto [lengthEnd, lengthEc] = std::from_chars(value.data(), value.data() + value.size(), length);
+            if (lengthEc != std::errc() || lengthEnd != value.data() + value.size()) {
+                return false;
+            }
+            hasLength = true;
+        } else if (equalsIgnoreCase(name, "Transfer-Encoding")) {
+            chunked = hasToken(value, "chunked");
+        } else if (equalsIgnoreCase(name, "Connection")) {
+            if (hasToken(value, "close")) {
+                keepAlive_ = false;
+            } else if (hasToken(value, "keep-alive")) {
+                keepAlive_ = true;
+            }
+        }
+    }
+
+    if (status_ < 200 && status_ != 101) {
+        state_ = State::Head;
+    } else if (headRequest_ || status_ == 101 || status_ == 204 || status_ == 304) {
+        keepAlive_ = keepAlive_ && status_ != 101;
+        state_ = State::Done;
+    } else if (chunked) {
+        state_ = State::ChunkSize;
+    } else if (hasLength) {
+        remaining_ = length;
+        state_ = length == 0 ? State::Done : State::Body;
+    } else {
+        keepAlive_ = false;
+        state_ = State::UntilClose;
+    }
+    return true;
+}
+
+bool ResponseFramer::readLine(const char* data, size_t size, size_t& offset) {
+    const char* start = data + offset;
+    const char* newline = static_cast<const char*>(std::memchr(start, '\n', size - offset));
+    size_t length = newline ? static_cast<size_t>(newline - start) + 1 : size - offset;
+
+    if (buffer_.size() + length > kMaxLineSize) {
+        state_ = State::Failed;
+        return false;
+    }
+    buffer_.append(start, length);
+    offset += length;
+    if (!newline) {
+        return false;
+    }
+
+    buffer_.pop_back();
+    if (!buffer_.empty() && buffer_.back() == '\r') {
+        buffer_.pop_back();
+    }
+    return true;
+}
+
+void ResponseFramer::consumeBody(size_t size, size_t& offset, State next) {
+    size_t take = std::min(remaining_, size - offset);
+    bodyBytes_ += take;
+    remaining_ -= take;
+    offset += take;
+    if (remaining_ == 0) {
+        state_ = next;
+    }
+}
+
+#ifdef __linux__
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kReadBufferSize = 64 * 1024;
+constexpr int kMaxEvents = 1024;
+constexpr uint64_t kTimerToken = UINT64_MAX;
+constexpr rlim_t kSpareDescriptors = 64;
+
+struct SharedState {
+    const EventLoopEngine::Target& target;
+    const sockaddr_storage& address;
+    socklen_t addressLength;
+    const EngineOptions& options;
+    const EventLoopEngine::Observer& observer;
+    std::atomic<size_t> issued{0};
+};
+
+class Loop {
+public:
+    Loop(size_t index, size_t connections, SharedState& shared)
+        : shared_(shared), connections_(connections), index_(index) {
+    }
+
+    virtual ~Loop() {
+        for (auto& connection : connections_) {
+            if (connection.fd >= 0) {
+                ::close(connection.fd);
+            }
+        }
+    }
+
+    Loop(const Loop&) = delete;
+    Loop& operator=(const Loop&) = delete;
+
+    bool run(std::string& error);
+
+protected:
+    enum class Phase { Closed, Connecting, Writing, Reading, Idle };
+
+    struct Connection {
+        int fd = -1;
+        uint32_t socket = 0;
+        Phase phase = Phase::Closed;
+        bool busy = false;
+        bool retried = false;
+        bool timed = false;
+        bool writePending = false;
+        size_t served = 0;
+        size_t written = 0;
+        Clock::time_point intended;
+        Clock::time_point sent;
+        Clock::time_point deadline;
+        Clock::time_point timerAt;
+        ResponseFramer framer;
+    };
+
+    SharedState& shared_;
+    std::vector<Connection> connections_;
+
+    virtual bool setup(std::string& error) = 0;
+    virtual bool open(size_t id) = 0;
+    virtual void write(size_t id) = 0;
+    virtual void release(Connection& connection) = 0;
+    virtual bool poll(Clock::time_point deadline, std::string& error) = 0;
+    virtual void dispatch() = 0;
+
+    void connected(size_t id);
+    void wrote(size_t id, size_t bytes);
+    void received(size_t id, const char* data, size_t size);
+    void hangup(size_t id, httplib::Error error);
+    void fail(size_t id, httplib::Error error);
+    void close(size_t id);
+
+private:
+    struct Timer {
+        Clock::time_point deadline;
+        size_t connection;
+
+        bool operator>(const Timer& other) const {
+            return deadline > other.deadline;
+        }
+    };
+
+    size_t index_;
+    Clock::time_point now_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    std::vector<size_t> ready_;
+    std::vector<size_t> available_;
+    std::deque<Clock::time_point> backlog_;
+    Clock::time_point nextSend_;
+    bool scheduled_ = false;
+    size_t busy_ = 0;
+
+    bool openLoop() const {
+        return static_cast<bool>(shared_.options.schedule);
+    }
+
+    bool finished() const {
+        return busy_ == 0 && ready_.empty() && (!openLoop() || (!scheduled_ && backlog_.empty()));
+    }
+
+    void next(size_t id);
+    void assign(size_t id, Clock::time_point intended);
+    bool connect(size_t id);
+    void complete(size_t id);
+    void record(const Connection& connection, int status, httplib::Error error);
+    void extend(size_t id, Clock::time_point deadline);
+    Clock::time_point nextDeadline() const;
+    void expireTimers();
+    void fireSchedule();
+};
+
+bool Loop::run(std::string& error) {
+    if (!setup(error)) {
+        return false;
+    }
+
+    now_ = Clock::now();
+    for (size_t id = connections_.size(); id-- > 0;) {
+        (openLoop() ? available_ : ready_).push_back(id);
+    }
+    if (openLoop()) {
+        scheduled_ = shared_.options.schedule(nextSend_);
+        fireSchedule();
+    }
+
+    while (true) {
+        while (!ready_.empty()) {
+            size_t id = ready_.back();
+            ready_.pop_back();
+            next(id);
+        }
+        if (finished()) {
+            return true;
+        }
+
+        if (!poll(nextDeadline(), error)) {
+            return false;
+        }
+        now_ = Clock::now();
+        dispatch();
+
+        expireTimers();
+        if (openLoop()) {
+            fireSchedule();
+        }
+    }
+}
+
+void Loop::next(size_t id) {
+    if (openLoop()) {
+        if (backlog_.empty()) {
+            available_.push_back(id);
+        } else {
+            Clock::time_point intended = backlog_.front();
+            backlog_.pop_front();
+            assign(id, intended);
+        }
+        return;
+    }
+
+    if (shared_.issued.fetch_add(1, std::memory_order_relaxed) < shared_.options.requests) {
+        assign(id, now_);
+    } else {
+        close(id);
+    }
+}
+
+void Loop::assign(size_t id, Clock::time_point intended) {
+    Connection& connection = connections_[id];
+    connection.busy = true;
+    connection.intended = intended;
+    connection.sent = now_;
+    connection.written = 0;
+    connection.framer.reset(shared_.target.headRequest);
+    busy_++;
+
+    if (connection.phase == Phase::Idle) {
+        connection.phase = Phase::Writing;
+        extend(id, now_ + shared_.options.readTimeout);
+        write(id);
+    } else if (!connect(id)) {
+        fail(id, httplib::Error::Connection);
+    }
+}
+
+bool Loop::connect(size_t id) {
+    if (!open(id)) {
+        return false;
+    }
+
+    Connection& connection = connections_[id];
+    connection.phase = Phase::Connecting;
+    connection.served = 0;
+    extend(id, now_ + shared_.options.connectTimeout);
+    return true;
+}
+
+void Loop::connected(size_t id) {
+    Connection& connection = connections_[id];
+    connection.phase = connection.busy ? Phase::Writing : Phase::Idle;
+    if (connection.phase == Phase::Writing) {
+        extend(id, now_ + shared_.options.readTimeout);
+        write(id);
+    }
+}
+
+void Loop::wrote(size_t id, size_t bytes) {
+    Connection& connection = connections_[id];
+    connection.written += bytes;
+    connection.deadline = now_ + shared_.options.readTimeout;
+    if (connection.written >= shared_.target.request.size()) {
+        connection.phase = Phase::Reading;
+    }
+}
+
+void Loop::received(size_t id, const char* data, size_t size) {
+    Connection& connection = connections_[id];
+    if (!connection.busy) {
+        close(id);
+        return;
+    }
+
+    connection.deadline = now_ + shared_.options.readTimeout;
+    size_t used = connection.framer.feed(data, size);
+    if (connection.framer.failed()) {
+        fail(id, httplib::Error::Read);
+    } else if (connection.framer.done()) {
+        complete(id);
+        if (used < size) {
+            close(id);
+        }
+    }
+}
+
+void Loop::hangup(size_t id, httplib::Error error) {
+    Connection& connection = connections_[id];
+    if (!connection.busy) {
+        close(id);
+        return;
+    }
+
+    if (connection.framer.started() && connection.framer.finishAtEof()) {
+        complete(id);
+        close(id);
+        return;
+    }
+
+    if (!connection.framer.started() && connection.served > 0 && !connection.retried) {
+        close(id);
+        connection.retried = true;
+        connection.written = 0;
+        connection.framer.reset(shared_.target.headRequest);
+        if (!connect(id)) {
+            fail(id, httplib::Error::Connection);
+        }
+        return;
+    }
+
+    fail(id, error);
+}
+
+void Loop::complete(size_t id) {
+    Connection& connection = connections_[id];
+    record(connection, connection.framer.status(), httplib::Error::Success);
+
+    connection.busy = false;
+    connection.retried = false;
+    connection.served++;
+    busy_--;
+
+    if (connection.framer.keepAlive()) {
+        connection.phase = Phase::Idle;
+    } else {
+        close(id);
+    }
+    ready_.push_back(id);
+}
+
+void Loop::fail(size_t id, httplib::Error error) {
+    Connection& connection = connections_[id];
+    record(connection, 0, error);
+
+    connection.busy = false;
+    connection.retried = false;
+    busy_--;
+
+    close(id);
+    ready_.push_back(id);
+}
+
+void Loop::close(size_t id) {
+    Connection& connection = connections_[id];
+    if (connection.fd >= 0) {
+        release(connection);
+        connection.fd = -1;
+    }
+    connection.phase = Phase::Closed;
+    connection.writePending = false;
+}
+
+void Loop::record(const Connection& connection, int status, httplib::Error error) {
+    EngineSample sample;
+    sample.status = status;
+    sample.error = error;
+    sample.intended = connection.intended;
+    sample.sent = connection.sent;
+    sample.received = now_;
+    shared_.observer(index_, sample);
+}
+
+void Loop::extend(size_t id, Clock::time_point deadline) {
+    Connection& connection = connections_[id];
+    connection.deadline = deadline;
+    if (!connection.timed || deadline < connection.timerAt) {
+        timers_.push({deadline, id});
+        connection.timed = true;
+        connection.timerAt = deadline;
+    }
+}
+
+Clock::time_point Loop::nextDeadline() const {
+    Clock::time_point next = timers_.empty() ? Clock::time_point::max() : timers_.top().deadline;
+    if (openLoop() && scheduled_) {
+        next = std::min(next, nextSend_);
+    }
+    return next;
+}
+
+void Loop::expireTimers() {
+    while (!timers_.empty() && timers_.top().deadline <= now_) {
+        Timer timer = timers_.top();
+        timers_.pop();
+
+        Connection& connection = connections_[timer.connection];
+        if (!connection.timed || timer.deadline != connection.timerAt) {
+            continue;
+        }
+        connection.timed = false;
+
+        if (connection.phase == Phase::Closed || connection.phase == Phase::Idle) {
+            continue;
+        }
+        if (connection.deadline > now_) {
+            extend(timer.connection, connection.deadline);
+            continue;
+        }
+        fail(timer.connection,
+             connection.phase == Phase::Connecting ? httplib::Error::Connection : httplib::Error::Read);
+    }
+}
+
+void Loop::fireSchedule() {
+    while (scheduled_ && nextSend_ <= now_) {
+        if (available_.empty()) {
+            backlog_.push_back(nextSend_);
+        } else {
+            size_t id = available_.back();
+            available_.pop_back();
+            assign(id, nextSend_);
+        }
+        scheduled_ = shared_.options.schedule(nextSend_);
+    }
+}
+
+class EpollLoop : public Loop {
+public:
+    using Loop::Loop;
+
+    ~EpollLoop() override {
+        if (timer_ >= 0) {
+            ::close(timer_);
+        }
+        if (epoll_ >= 0) {
+            ::close(epoll_);
+        }
+    }
+
+private:
+    int epoll_ = -1;
+    int timer_ = -1;
+    Clock::time_point armed_ = Clock::time_point::max();
+    std::vector<epoll_event> events_;
+    int count_ = 0;
+    std::vector<char> buffer_;
+
+    bool setup(std::string& error) override;
+    bool open(size_t id) override;
+    void write(size_t id) override;
+    void release(Connection& connection) override;
+    bool poll(Clock::time_point deadline, std::string& error) override;
+    void dispatch() override;
+
+    void onEvent(size_t id, uint32_t events);
+    void receive(size_t id);
+};
+
+bool EpollLoop::setup(std::string& error) {
+    epoll_ = epoll_create1(EPOLL_CLOEXEC);
+    timer_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (epoll_ < 0 || timer_ < 0) {
+        error = std::strerror(errno);
+        return false;
+    }
+
+    epoll_event timerEvent{};
+    timerEvent.events = EPOLLIN;
+    timerEvent.data.u64 = kTimerToken;
+    if (epoll_ctl(epoll_, EPOLL_CTL_ADD, timer_, &timerEvent) < 0) {
+        error = std::strerror(errno);
+        return false;
+    }
+
+    events_.resize(kMaxEvents);
+    buffer_.resize(kReadBufferSize);
+    return true;
+}
+
+bool EpollLoop::open(size_t id) {
+    Connection& connection = connections_[id];
+    int fd = ::socket(shared_.address.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&shared_.address), shared_.addressLength) < 0 &&
+        errno != EINPROGRESS) {
+        ::close(fd);
+        return false;
+    }
+
+    connection.socket++;
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.u64 = (static_cast<uint64_t>(connection.socket) << 32) | id;
+    if (epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &event) < 0) {
+        ::close(fd);
+        return false;
+    }
+
+    connection.fd = fd;
+    return true;
+}
+
+void EpollLoop::write(size_t id) {
+    Connection& connection = connections_[id];
+    const std::string& request = shared_.target.request;
+
+    while (connection.phase == Phase::Writing) {
+        ssize_t sent = ::send(connection.fd, request.data() + connection.written,
+                              request.size() - connection.written, MSG_NOSIGNAL);
+        if (sent > 0) {
+            wrote(id, static_cast<size_t>(sent));
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        } else {
+            hangup(id, httplib::Error::Write);
+            return;
+        }
+    }
+}
+
+void EpollLoop::release(Connection& connection) {
+    ::close(connection.fd);
+}
+
+bool EpollLoop::poll(Clock::time_point deadline, std::string& error) {
+    if (deadline != armed_) {
+        armed_ = deadline;
+        itimerspec spec{};
+        if (deadline != Clock::time_point::max()) {
+            auto ns = std::max<int64_t>(
+                1, std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count());
+            spec.it_value.tv_sec = static_cast<time_t>(ns / 1000000000);
+            spec.it_value.tv_nsec = static_cast<long>(ns % 1000000000);
+        }
+        timerfd_settime(timer_, TFD_TIMER_ABSTIME, &spec, nullptr);
+    }
+
+    count_ = epoll_wait(epoll_, events_.data(), kMaxEvents, -1);
+    if (count_ < 0) {
+        count_ = 0;
+        if (errno != EINTR) {
+            error = std::strerror(errno);
+            return false;
+        }
+    }
+    return true;
+}
+
+void EpollLoop::dispatch() {
+    for (int i = 0; i < count_; ++i) {
+        uint64_t token = events_[i].data.u64;
+        if (token == kTimerToken) {
+            uint64_t expirations = 0;
+            [[maybe_unused]] ssize_t drained = ::read(timer_, &expirations, sizeof(expirations));
+            armed_ = Clock::time_point::max();
+            continue;
+        }
+
+        size_t id = static_cast<size_t>(token & 0xffffffffu);
+        if (id < connections_.size() && connections_[id].fd >= 0 &&
+            connections_[id].socket == static_cast<uint32_t>(token >> 32)) {
+            onEvent(id, events_[i].events);
+        }
+    }
+}
+
+void EpollLoop::onEvent(size_t id, uint32_t events) {
+    Connection& connection = connections_[id];
+
+    if (connection.phase == Phase::Connecting) {
+        if (!(events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+            return;
+        }
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (getsockopt(connection.fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0 ||
+            (events & (EPOLLERR | EPOLLHUP))) {
+            fail(id, httplib::Error::Connection);
+            return;
+        }
+        connected(id);
+    } else if (connection.phase == Phase::Writing && (events & EPOLLOUT)) {
+        write(id);
+    }
+
+    if (connection.fd >= 0 && (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+        receive(id);
+    }
+}
+
+void EpollLoop::receive(size_t id) {
+    Connection& connection = connections_[id];
+
+    while (connection.fd >= 0) {
+        ssize_t received = ::recv(connection.fd, buffer_.data(), buffer_.size(), 0);
+        if (received > 0) {
+            Loop::received(id, buffer_.data(), static_cast<size_t>(received));
+        } else if (received < 0 && errno == EINTR) {
+            continue;
+        } else if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        } else {
+            hangup(id, httplib::Error::Read);
+            return;
+        }
+    }
+}
+
+#ifdef LUNARICA_IO_URING_SUPPORT
+
+constexpr unsigned kRingEntries = 4096;
+constexpr unsigned kRingBuffers = 4096;
+constexpr size_t kRingBufferSize = 4096;
+constexpr uint16_t kBufferGroup = 0;
+
+enum class RingOp : uint64_t { Connect = 1, Send = 2, Receive = 3 };
+
+class UringLoop : public Loop {
+public:
+    using Loop::Loop;
+
+    ~UringLoop() override {
+        for (int fd : closing_) {
+            ::close(fd);
+        }
+    }
+
+private:
+    IoUring ring_;
+    std::vector<int> closing_;
+
+    bool setup(std::string& error) override;
+    bool open(size_t id) override;
+    void write(size_t id) override;
+    void release(Connection& connection) override;
+    bool poll(Clock::time_point deadline, std::string& error) override;
+    void dispatch() override;
+
+    void receive(size_t id);
+    void onCompletion(const io_uring_cqe& cqe);
+
+    static uint64_t token(size_t id, uint32_t socket, RingOp op) {
+        return (static_cast<uint64_t>(socket) << 32) | (static_cast<uint64_t>(op) << 24) | id;
+    }
+};
+
+bool UringLoop::setup(std::string& error) {
+    if (connections_.size() >= (size_t(1) << 24)) {
+        error = "too many connections for one io_uring loop";
+        return false;
+    }
+    return ring_.init(kRingEntries, error) &&
+           ring_.provideBuffers(kBufferGroup, kRingBuffers, kRingBufferSize, error);
+}
+
+bool UringLoop::open(size_t id) {
+    Connection& connection = connections_[id];
+    int fd = ::socket(shared_.address.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    io_uring_sqe* sqe = ring_.nextSqe();
+    if (!sqe) {
+        ::close(fd);
+        return false;
+    }
+
+    connection.fd = fd;
+    connection.socket++;
+    sqe->opcode = IORING_OP_CONNECT;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(&shared_.address);
+    sqe->off = shared_.addressLength;
+    sqe->user_data = token(id, connection.socket, RingOp::Connect);
+    return true;
+}
+
+void UringLoop::write(size_t id) {
+    Connection& connection = connections_[id];
+    if (connection.writePending) {
+        return;
+    }
+
+    io_uring_sqe* sqe = ring_.nextSqe();
+    if (!sqe) {
+        fail(id, httplib::Error::Write);
+        return;
+    }
+
+    const std::string& request = shared_.target.request;
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = connection.fd;
+    sqe->addr = reinterpret_cast<uint64_t>(request.data() + connection.written);
+    sqe->len = static_cast<uint32_t>(std::min<size_t>(request.size() - connection.written, UINT32_MAX));
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = token(id, connection.socket, RingOp::Send);
+    connection.writePending = true;
+}
+
+void UringLoop::receive(size_t id) {
+    Connection& connection = connections_[id];
+    io_uring_sqe* sqe = ring_.nextSqe();
+    if (!sqe) {
+        hangup(id, httplib::Error::Read);
+        return;
+    }
+
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = connection.fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufferGroup;
+    sqe->user_data = token(id, connection.socket, RingOp::Receive);
+}
+
+void UringLoop::release(Connection& connection) {
+    ::shutdown(connection.fd, SHUT_RDWR);
+    closing_.push_back(connection.fd);
+}
+
+bool UringLoop::poll(Clock::time_point deadline, std::string& error) {
+    auto timeout = std::chrono::nanoseconds(-1);
+    if (deadline != Clock::time_point::max()) {
+        timeout = std::max(std::chrono::nanoseconds(0), deadline - Clock::now());
+    }
+
+    int result = ring_.submitAndWait(timeout);
+    for (int fd : closing_) {
+        ::close(fd);
+    }
+    closing_.clear();
+
+    if (result < 0 && result != -EBUSY) {
+        error = std::string("io_uring_enter: ") + std::strerror(-result);
+        return false;
+    }
+    return true;
+}
+
+void UringLoop::dispatch() {
+    while (ring_.drain([this](const io_uring_cqe& cqe) { onCompletion(cqe); }) > 0) {
+    }
+}
+
+void UringLoop::onCompletion(const io_uring_cqe& cqe) {
+    if (cqe.user_data == 0) {
+        return;
+    }
+
+    size_t id = static_cast<size_t>(cqe.user_data & 0xffffff);
+    auto op = static_cast<RingOp>((cqe.user_data >> 24) & 0xff);
+    auto socket = static_cast<uint32_t>(cqe.user_data >> 32);
+    Connection& connection = connections_[id];
+    auto current = [&] {
+        return connection.fd >= 0 && connection.socket == socket;
+    };
+
+    if (op == RingOp::Receive) {
+        if (current()) {
+            if (cqe.res > 0 && (cqe.flags & IORING_CQE_F_BUFFER)) {
+                received(id, ring_.buffer(static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT)),
+                         static_cast<size_t>(cqe.res));
+            } else if (cqe.res != -ENOBUFS) {
+                hangup(id, httplib::Error::Read);
+            }
+            if (!(cqe.flags & IORING_CQE_F_MORE) && current()) {
+                receive(id);
+            }
+        }
+        if (cqe.flags & IORING_CQE_F_BUFFER) {
+            ring_.recycle(static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+        }
+        return;
+    }
+
+    if (!current()) {
+        return;
+    }
+
+    if (op == RingOp::Connect) {
+        if (cqe.res < 0) {
+            fail(id, httplib::Error::Connection);
+            return;
+        }
+        // Failing to arm the receive closes the connection; it must not
+        // then be marked idle and handed the next request on fd -1.
+        receive(id);
+        if (current()) {
+            connected(id);
+        }
+    } else if (op == RingOp::Send) {
+        connection.writePending = false;
+        if (cqe.res < 0) {
+            hangup(id, httplib::Error::Write);
+            return;
+        }
+        wrote(id, static_cast<size_t>(cqe.res));
+        if (connection.phase == Phase::Writing) {
+            write(id);
+        }
+    }
+}
+
+#endif
+
+bool raiseDescriptorLimit(size_t connections, std::string& error) {
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) < 0) {
+        return true;
+    }
+
+    rlim_t needed = static_cast<rlim_t>(connections) + kSpareDescriptors;
+    if (limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur < needed) {
+        limit.rlim_cur = limit.rlim_max == RLIM_INFINITY ? needed : std::min(needed, limit.rlim_max);
+        setrlimit(RLIMIT_NOFILE, &limit);
+        getrlimit(RLIMIT_NOFILE, &limit);
+    }
+    if (limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur < needed) {
+        error = "open file limit is " + std::to_string(limit.rlim_cur) + ", " + std::to_string(needed) +
+                " descriptors are needed for " + std::to_string(connections) + " connections";
+        return false;
+    }
+    return true;
+}
+
+}
+
+#endif
+
+EventLoopEngine::EventLoopEngine(Target target)
+    : target_(std::move(target)) {
+}
+
+bool EventLoopEngine::available() {
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+EngineBackend EventLoopEngine::resolveBackend(EngineBackend requested) {
+#ifdef LUNARICA_IO_URING_SUPPORT
+    if (requested == EngineBackend::IoUring && IoUring::supported()) {
+        return EngineBackend::IoUring;
+    }
+#else
+    (void)requested;
+#endif
+    return EngineBackend::Epoll;
+}
+
+const char* EventLoopEngine::backendName(EngineBackend backend) {
+    return backend == EngineBackend::IoUring ? "io_uring" : "epoll";
+}
+
+bool EventLoopEngine::run(const EngineOptions& options, const Observer& observer, std::string& error) {
+#ifdef __linux__
+    addrinfo hints{};
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+    addrinfo* resolved = nullptr;
+    std::string port = std::to_string(target_.port);
+    if (getaddrinfo(target_.address.c_str(), port.c_str(), &hints, &resolved) != 0 || !resolved) {
+        error = "invalid address " + target_.address;
+        return false;
+    }
+
+    sockaddr_storage address{};
+    socklen_t addressLength = static_cast<socklen_t>(resolved->ai_addrlen);
+    std::memcpy(&address, resolved->ai_addr, resolved->ai_addrlen);
+    freeaddrinfo(resolved);
+
+    size_t connections = std::max<size_t>(1, options.connections);
+    size_t threads = std::clamp<size_t>(options.threads, 1, connections);
+    if (!raiseDescriptorLimit(connections, error)) {
+        return false;
+    }
+
+    SharedState shared{target_, address, addressLength, options, observer};
+    EngineBackend backend = resolveBackend(options.backend);
+    std::vector<std::unique_ptr<Loop>> loops;
+    for (size_t i = 0; i < threads; ++i) {
+        size_t share = connections / threads + (i < connections % threads ? 1 : 0);
+#ifdef LUNARICA_IO_URING_SUPPORT
+        if (backend == EngineBackend::IoUring) {
+            loops.push_back(std::make_unique<UringLoop>(i, share, shared));
+            continue;
+        }
+#endif
+        loops.push_back(std::make_unique<EpollLoop>(i, share, shared));
+    }
+
+    std::vector<std::string> errors(threads);
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([&, i]() {
+            loops[i]->run(errors[i]);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (const auto& loopError : errors) {
+        if (!loopError.empty()) {
+            error = loopError;
+            return false;
+        }
+    }
+    return true;
+#else
+    (void)options;
+    (void)observer;
+    error = "the event loop engine requires Linux epoll";
+    return false;
+#endif
+}
+
+std::string EventLoopEngine::serialize(const HttpRequest& request) {
+    std::string wire = request.method + " " + (request.path.empty() ? "/" : request.path) + " HTTP/1.1\r\n";
+    wire += "Host: " + request.host + "\r\n";
+
+    bool hasAccept = false;
+    for (const auto& [name, value] : request.headers) {
+        if (equalsIgnoreCase(name, "Host") || equalsIgnoreCase(name, "Content-Length") ||
+            equalsIgnoreCase(name, "Connection") || equalsIgnoreCase(name, "Transfer-Encoding")) {
+            continue;
+        }
+        hasAccept = hasAccept || equalsIgnoreCase(name, "Accept");
+        wire += name + ": " + value + "\r\n";
+    }
+    if (!hasAccept) {
+        wire += "Accept: */*\r\n";
+    }
+    if (!request.body.empty() || HttpService::methodHasBody(request.method)) {
+        wire += "Content-Length: " + std::to_string(request.body.size()) + "\r\n";
+    }
+    wire += "Connection: keep-alive\r\n\r\n";
+    wire += request.body;
+    return wire;
+}
+
+}
@@ -0,0 +1,111 @@
+﻿#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <httplib.h>
+#include "http_service.h"
+
+namespace lunarica {
+
+    class ResponseFramer {
+    public:
+        static constexpr size_t kMaxHeadSize = 64 * 1024;
+        static constexpr size_t kMaxLineSize = 4096;
+
+        void reset(bool headRequest);
+        size_t feed(const char* data, size_t size);
+        bool finishAtEof();
+
+        bool started() const {
+            return started_;
+        }
+
+        bool done() const {
+            return state_ == State::Done;
+        }
+
+        bool failed() const {
+            return state_ == State::Failed;
+        }
+
+        int status() const {
+            return status_;
+        }
+
+        bool keepAlive() const {
+            return keepAlive_;
+        }
+
+        size_t bodyBytes() const {
+            return bodyBytes_;
+        }
+
+    private:
+        enum class State { Head, Body, ChunkSize, ChunkData, ChunkEnd, Trailer, UntilClose, Done, Failed };
+
+        State state_ = State::Head;
+        std::string buffer_;
+        size_t remaining_ = 0;
+        size_t bodyBytes_ = 0;
+        int status_ = 0;
+        bool keepAlive_ = true;
+        bool headRequest_ = false;
+        bool started_ = false;
+
+        bool parseHead();
+        bool readLine(const char* data, size_t size, size_t& offset);
+        void consumeBody(size_t size, size_t& offset, State next);
+    };
+
+    struct EngineSample {
+        using Clock = std::chrono::steady_clock;
+
+        int status = 0;
+        httplib::Error error = httplib::Error::Success;
+        Clock::time_point intended;
+        Clock::time_point sent;
+        Clock::time_point received;
+    };
+
+    enum class EngineBackend { Epoll, IoUring };
+
+    struct EngineOptions {
+        using Clock = std::chrono::steady_clock;
+
+        size_t requests = 0;
+        size_t connections = 1;
+        size_t threads = 1;
+        EngineBackend backend = EngineBackend::Epoll;
+        std::function<bool(Clock::time_point&)> schedule;
+        std::chrono::milliseconds connectTimeout{3000};
+        std::chrono::milliseconds readTimeout{5000};
+    };
+
+    class EventLoopEngine {
+    public:
+        using Observer = std::function<void(size_t loop, const EngineSample& sample)>;
+
+        struct Target {
+            std::string address;
+            uint16_t port = 0;
+            std::string request;
+            bool headRequest = false;
+        };
+
+        explicit EventLoopEngine(Target target);
+
+        bool run(const EngineOptions& options, const Observer& observer, std::string& error);
+
+        static bool available();
+        static EngineBackend resolveBackend(EngineBackend requested);
+        static const char* backendName(EngineBackend backend);
+        static std::string serialize(const HttpRequest& request);
+
+    private:
+        Target target_;
+    };
+
+}
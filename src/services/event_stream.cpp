@@ -0,0 +1,138 @@
+﻿#include "event_stream.h"
+
+#include <cstring>
+
+namespace lunarica {
+
+EventStreamDecoder::EventStreamDecoder(Format format) : format_(format) {
+}
+
+EventStreamDecoder::Format EventStreamDecoder::detect(const std::string& contentType) {
+    return contentType.find("text/event-stream") != std::string::npos ? Format::Sse : Format::Lines;
+}
+
+bool EventStreamDecoder::feed(const char* data, size_t length, const Handler& handler) {
+    size_t offset = 0;
+    if (skipLineFeed_ && length > 0) {
+        skipLineFeed_ = false;
+        if (data[0] == '\n') {
+            offset = 1;
+        }
+    }
+
+    while (offset < length) {
+        const char* start = data + offset;
+        size_t remaining = length - offset;
+        const char* end = static_cast<const char*>(std::memchr(start, '\n', remaining));
+        if (format_ == Format::Sse) {
+            const char* carriage = static_cast<const char*>(std::memchr(start, '\r', end ? end - start : remaining));
+            if (carriage) {
+                end = carriage;
+            }
+        }
+
+        if (!end) {
+            line_.append(start, remaining);
+            return true;
+        }
+
+        std::string_view line(start, static_cast<size_t>(end - start));
+        if (!line_.empty()) {
+            line_.append(line.data(), line.size());
+            line = line_;
+        }
+
+        offset = static_cast<size_t>(end - data) + 1;
+        if (*end == '\r') {
+            if (offset == length) {
+                skipLineFeed_ = true;
+            } else if (data[offset] == '\n') {
+                offset++;
+            }
+        }
+
+        bool keepGoing = processLine(line, handler);
+        line_.clear();
+        if (!keepGoing) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool EventStreamDecoder::finish(const Handler& handler) {
+    bool keepGoing = true;
+    if (!line_.empty()) {
+        std::string line = std::move(line_);
+        line_.clear();
+        keepGoing = processLine(line, handler);
+    }
+    if (keepGoing && format_ == Format::Sse) {
+        keepGoing = dispatch(handler);
+    }
+    return keepGoing;
+}
+
+bool EventStreamDecoder::processLine(std::string_view line, const Handler& handler) {
+    if (format_ == Format::Lines) {
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (line.find_first_not_of(" \t") == std::string_view::npos) {
+            return true;
+        }
+        StreamEvent event;
+        event.data = line;
+        return handler(event);
+    }
+
+    if (line.empty()) {
+        return dispatch(handler);
+    }
+    if (line[0] == ':') {
+        return true;
+    }
+
+    size_t colon = line.find(':');
+    std::string_view field = line.substr(0, colon);
+    std::string_view value;
+    if (colon != std::string_view::npos) {
+        value = line.substr(colon + 1);
+        if (!value.empty() && value[0] == ' ') {
+            value.remove_prefix(1);
+        }
+    }
+
+    if (field == "data") {
+        if (pendingData_) {
+            data_ += '\n';
+        }
+        data_.append(value.data(), value.size());
+        pendingData_ = true;
+    } else if (field == "event") {
+        type_.assign(value.data(), value.size());
+    } else if (field == "id" && value.find('\0') == std::string_view::npos) {
+        id_.assign(value.data(), value.size());
+    }
+    return true;
+}
+
+bool EventStreamDecoder::dispatch(const Handler& handler) {
+    if (!pendingData_) {
+        type_.clear();
+        return true;
+    }
+
+    StreamEvent event;
+    event.type = type_.empty() ? std::string_view("message") : std::string_view(type_);
+    event.id = id_;
+    event.data = data_;
+    bool keepGoing = handler(event);
+
+    data_.clear();
+    type_.clear();
+    pendingData_ = false;
+    return keepGoing;
+}
+
+}
@@ -0,0 +1,50 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace lunarica {
+
+    struct StreamEvent {
+        std::string_view type;
+        std::string_view id;
+        std::string_view data;
+    };
+
+    class EventStreamDecoder {
+    public:
+        enum class Format { Sse, Lines };
+
+        using Handler = std::function<bool(const StreamEvent&)>;
+
+        explicit EventStreamDecoder(Format format);
+
+        static Format detect(const std::string& contentType);
+
+        bool feed(const char* data, size_t length, const Handler& handler);
+        bool finish(const Handler& handler);
+
+        Format format() const {
+            return format_;
+        }
+
+        size_t buffered() const {
+            return line_.capacity() + data_.capacity() + type_.capacity() + id_.capacity();
+        }
+
+    private:
+        Format format_;
+        std::string line_;
+        std::string data_;
+        std::string type_;
+        std::string id_;
+        bool skipLineFeed_ = false;
+        bool pendingData_ = false;
+
+        bool processLine(std::string_view line, const Handler& handler);
+        bool dispatch(const Handler& handler);
+    };
+
+}
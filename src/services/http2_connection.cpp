@@ -0,0 +1,687 @@
+﻿#include "http2_connection.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <deque>
+#include <nghttp2/nghttp2.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+#endif
+
+namespace lunarica {
+
+namespace {
+
+#ifdef _WIN32
+using socket_t = SOCKET;
+constexpr socket_t kInvalidSocket = INVALID_SOCKET;
+#else
+using socket_t = int;
+constexpr socket_t kInvalidSocket = -1;
+#endif
+
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+constexpr int32_t kStreamWindow = 16 * 1024 * 1024;
+constexpr int32_t kConnectionWindow = 64 * 1024 * 1024;
+constexpr int kPollInterval = 20;
+constexpr int kWriteTimeout = 30 * 1000;
+
+bool wouldBlock() {
+#ifdef _WIN32
+    int error = WSAGetLastError();
+    return error == WSAEWOULDBLOCK || error == WSAEINPROGRESS;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINPROGRESS;
+#endif
+}
+
+void closeSocket(socket_t fd) {
+#ifdef _WIN32
+    closesocket(fd);
+#else
+    close(fd);
+#endif
+}
+
+bool pollSocket(socket_t fd, short events, int timeout) {
+#ifdef _WIN32
+    WSAPOLLFD descriptor = {fd, events, 0};
+    return WSAPoll(&descriptor, 1, timeout) > 0;
+#else
+    struct pollfd descriptor = {fd, events, 0};
+    return poll(&descriptor, 1, timeout) > 0;
+#endif
+}
+
+std::string lowercase(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::tolower(c); });
+    return text;
+}
+
+bool isConnectionSpecific(const std::string& name) {
+    return name == "connection" || name == "keep-alive" || name == "proxy-connection" ||
+           name == "transfer-encoding" || name == "upgrade" || name == "host";
+}
+
+nghttp2_nv makeHeader(const std::string& name, const std::string& value) {
+    return {reinterpret_cast<uint8_t*>(const_cast<char*>(name.data())),
+            reinterpret_cast<uint8_t*>(const_cast<char*>(value.data())),
+            name.size(), value.size(), NGHTTP2_NV_FLAG_NONE};
+}
+
+}
+
+struct Http2Connection::Socket {
+    socket_t fd = kInvalidSocket;
+    TlsSessionCache* sessions = nullptr;
+    std::string sessionKey;
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+    SSL_CTX* ctx = nullptr;
+    SSL* ssl = nullptr;
+#endif
+
+    ~Socket() {
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+        if (ssl) {
+            SSL_shutdown(ssl);
+            SSL_free(ssl);
+        }
+        if (ctx) {
+            SSL_CTX_free(ctx);
+        }
+#endif
+        if (fd != kInvalidSocket) {
+            closeSocket(fd);
+        }
+    }
+
+    bool wait(short events, int timeout) const {
+        return pollSocket(fd, events, timeout);
+    }
+
+    long read(char* buffer, size_t length, bool& blocked) {
+        blocked = false;
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+        if (ssl) {
+            int n = SSL_read(ssl, buffer, static_cast<int>(length));
+            if (n > 0) {
+                return n;
+            }
+            int error = SSL_get_error(ssl, n);
+            blocked = error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE;
+            return blocked ? -1 : 0;
+        }
+#endif
+        auto n = recv(fd, buffer, static_cast<int>(length), 0);
+        if (n < 0) {
+            blocked = wouldBlock();
+            return blocked ? -1 : 0;
+        }
+        return static_cast<long>(n);
+    }
+
+    bool writeAll(const uint8_t* data, size_t length) {
+        while (length > 0) {
+            long written = -1;
+            short waitFor = POLLOUT;
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+            if (ssl) {
+                int n = SSL_write(ssl, data, static_cast<int>(std::min<size_t>(length, 1 << 30)));
+                if (n <= 0) {
+                    int error = SSL_get_error(ssl, n);
+                    if (error != SSL_ERROR_WANT_READ && error != SSL_ERROR_WANT_WRITE) {
+                        return false;
+                    }
+                    waitFor = error == SSL_ERROR_WANT_READ ? POLLIN : POLLOUT;
+                } else {
+                    written = n;
+                }
+            } else
+#endif
+            {
+                auto n = send(fd, reinterpret_cast<const char*>(data), static_cast<int>(std::min<size_t>(length, 1 << 30)), kSendFlags);
+                if (n < 0 && !wouldBlock()) {
+                    return false;
+                }
+                written = static_cast<long>(n);
+            }
+
+            if (written > 0) {
+                data += written;
+                length -= static_cast<size_t>(written);
+            } else if (!wait(waitFor, kWriteTimeout)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+struct Http2Connection::Stream {
+    const Http2Handlers* handlers = nullptr;
+    std::function<std::string_view(size_t)> body;
+    size_t offset = 0;
+    Http2Result result;
+    Clock::time_point lastActivity;
+    std::deque<std::string> chunks;
+    bool headersDone = false;
+    bool headersPending = false;
+    bool closed = false;
+    bool canceled = false;
+    uint32_t errorCode = 0;
+};
+
+struct Http2Callbacks {
+    using Stream = Http2Connection::Stream;
+    using Clock = Http2Connection::Clock;
+
+    static Stream* streamOf(nghttp2_session* session, int32_t id) {
+        return static_cast<Stream*>(nghttp2_session_get_stream_user_data(session, id));
+    }
+
+    static void cancel(nghttp2_session* session, int32_t id, Stream* stream) {
+        stream->canceled = true;
+        nghttp2_submit_rst_stream(session, NGHTTP2_FLAG_NONE, id, NGHTTP2_CANCEL);
+    }
+
+    static int onHeader(nghttp2_session* session, const nghttp2_frame* frame, const uint8_t* name, size_t nameLength,
+                        const uint8_t* value, size_t valueLength, uint8_t, void*) {
+        Stream* stream = streamOf(session, frame->hd.stream_id);
+        if (!stream || frame->hd.type != NGHTTP2_HEADERS || stream->headersDone) {
+            return 0;
+        }
+
+        std::string_view key(reinterpret_cast<const char*>(name), nameLength);
+        std::string_view text(reinterpret_cast<const char*>(value), valueLength);
+        if (key == ":status") {
+            stream->result.response.status = std::atoi(std::string(text).c_str());
+        } else if (!key.empty() && key[0] != ':') {
+            stream->result.response.headers.emplace_back(key, text);
+        }
+        return 0;
+    }
+
+    static int onFrame(nghttp2_session* session, const nghttp2_frame* frame, void* user) {
+        auto* connection = static_cast<Http2Connection*>(user);
+        if (frame->hd.type == NGHTTP2_SETTINGS && !(frame->hd.flags & NGHTTP2_FLAG_ACK)) {
+            uint32_t limit = nghttp2_session_get_remote_settings(session, NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS);
+            connection->maxStreams_ = std::max<uint32_t>(1, std::min<uint32_t>(limit, 1000));
+            return 0;
+        }
+
+        Stream* stream = streamOf(session, frame->hd.stream_id);
+        if (!stream || frame->hd.type != NGHTTP2_HEADERS || !(frame->hd.flags & NGHTTP2_FLAG_END_HEADERS)) {
+            return 0;
+        }
+
+        stream->lastActivity = Clock::now();
+        Http2Response& response = stream->result.response;
+        if (stream->headersDone) {
+            return 0;
+        }
+        if (response.status < 200) {
+            response.status = 0;
+            response.headers.clear();
+            return 0;
+        }
+
+        stream->headersDone = true;
+        stream->result.headersAt = stream->lastActivity;
+        stream->headersPending = static_cast<bool>(stream->handlers->onHeaders);
+        return 0;
+    }
+
+    // Handlers run on the thread that issued the request, outside the
+    // connection lock (see Http2Connection::deliver). Bytes queued for a
+    // handler are only acknowledged to the peer once it has seen them, so
+    // a slow consumer throttles its own stream and not the connection.
+    static int onData(nghttp2_session* session, uint8_t, int32_t id, const uint8_t* data, size_t length, void*) {
+        Stream* stream = streamOf(session, id);
+        if (!stream || stream->canceled || !stream->handlers->onBody) {
+            if (stream && !stream->canceled) {
+                stream->lastActivity = Clock::now();
+                stream->result.response.body.append(reinterpret_cast<const char*>(data), length);
+            }
+            nghttp2_session_consume(session, id, length);
+            return 0;
+        }
+
+        stream->lastActivity = Clock::now();
+        stream->chunks.emplace_back(reinterpret_cast<const char*>(data), length);
+        return 0;
+    }
+
+    static int onClose(nghttp2_session* session, int32_t id, uint32_t errorCode, void* user) {
+        Stream* stream = streamOf(session, id);
+        if (stream) {
+            stream->closed = true;
+            stream->errorCode = errorCode;
+            stream->result.finished = Clock::now();
+        }
+        static_cast<Http2Connection*>(user)->progress_.notify_all();
+        return 0;
+    }
+
+    static ssize_t readBody(nghttp2_session*, int32_t, uint8_t* buffer, size_t length, uint32_t* flags,
+                            nghttp2_data_source* source, void*) {
+        auto* stream = static_cast<Stream*>(source->ptr);
+        if (stream->offset == 0) {
+            stream->result.uploadStarted = Clock::now();
+        }
+
+        std::string_view chunk = stream->body(stream->offset);
+        size_t count = std::min(length, chunk.size());
+        std::memcpy(buffer, chunk.data(), count);
+        stream->offset += count;
+        stream->result.uploaded = stream->offset;
+        if (count == 0) {
+            stream->result.uploadFinished = Clock::now();
+            *flags |= NGHTTP2_DATA_FLAG_EOF;
+        }
+        return static_cast<ssize_t>(count);
+    }
+
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+    static int onNewSession(SSL* ssl, SSL_SESSION* session) {
+        auto* socket = static_cast<Http2Connection::Socket*>(SSL_get_app_data(ssl));
+        if (socket && socket->sessions) {
+            socket->sessions->store(socket->sessionKey, session);
+        }
+        return 0;
+    }
+#endif
+};
+
+Http2Connection::Http2Connection() = default;
+
+Http2Connection::~Http2Connection() {
+    if (session_) {
+        nghttp2_session_del(session_);
+    }
+}
+
+std::shared_ptr<Http2Connection> Http2Connection::open(const Endpoint& endpoint, DnsCache& dns, TlsSessionCache& sessions,
+                                                       int connectionTimeout, std::string& error, bool& refused) {
+    refused = false;
+    std::shared_ptr<Http2Connection> connection(new Http2Connection());
+    Http2Result& established = connection->established_;
+    established.newConnection = true;
+
+    std::string address = endpoint.host;
+    if (!DnsResolver::isNumericAddress(address)) {
+        ResolveResult resolved = dns.resolve(endpoint.host);
+        established.dns = resolved.elapsed;
+        if (!resolved.ok) {
+            error = "could not resolve " + endpoint.host + ": " + resolved.error;
+            return nullptr;
+        }
+        address = resolved.address;
+    }
+
+    struct addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICHOST;
+    struct addrinfo* info = nullptr;
+    if (getaddrinfo(address.c_str(), std::to_string(endpoint.port).c_str(), &hints, &info) != 0 || !info) {
+        error = "invalid address " + address;
+        return nullptr;
+    }
+
+    auto connectStarted = Clock::now();
+    auto socket = std::make_unique<Socket>();
+    socket->fd = ::socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+    if (socket->fd == kInvalidSocket) {
+        freeaddrinfo(info);
+        error = "could not create socket";
+        return nullptr;
+    }
+
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    ioctlsocket(socket->fd, FIONBIO, &nonBlocking);
+#else
+    fcntl(socket->fd, F_SETFL, fcntl(socket->fd, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    int noDelay = 1;
+    setsockopt(socket->fd, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+
+    int rc = ::connect(socket->fd, info->ai_addr, static_cast<int>(info->ai_addrlen));
+    freeaddrinfo(info);
+    if (rc != 0 && !wouldBlock()) {
+        error = "could not connect to " + endpoint.host;
+        return nullptr;
+    }
+    if (rc != 0) {
+        int socketError = 0;
+        socklen_t length = sizeof(socketError);
+        if (!socket->wait(POLLOUT, connectionTimeout * 1000) ||
+            getsockopt(socket->fd, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&socketError), &length) != 0 ||
+            socketError != 0) {
+            error = "could not connect to " + endpoint.host;
+            return nullptr;
+        }
+    }
+    established.connect = Clock::now() - connectStarted;
+
+    if (endpoint.tls) {
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+        auto tlsStarted = Clock::now();
+        static const unsigned char kAlpn[] = "\x02h2\x08http/1.1";
+
+        socket->sessions = &sessions;
+        socket->sessionKey = "https://" + lowercase(endpoint.host) + ":" + std::to_string(endpoint.port);
+        socket->ctx = SSL_CTX_new(TLS_client_method());
+        SSL_CTX_set_min_proto_version(socket->ctx, TLS1_2_VERSION);
+        SSL_CTX_set_default_verify_paths(socket->ctx);
+        SSL_CTX_set_verify(socket->ctx, SSL_VERIFY_PEER, nullptr);
+        SSL_CTX_set_alpn_protos(socket->ctx, kAlpn, sizeof(kAlpn) - 1);
+        SSL_CTX_set_mode(socket->ctx, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+        SSL_CTX_set_session_cache_mode(socket->ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_sess_set_new_cb(socket->ctx, &Http2Callbacks::onNewSession);
+
+        socket->ssl = SSL_new(socket->ctx);
+        SSL_set_app_data(socket->ssl, socket.get());
+        SSL_set_fd(socket->ssl, static_cast<int>(socket->fd));
+        if (DnsResolver::isNumericAddress(endpoint.host)) {
+            X509_VERIFY_PARAM_set1_ip_asc(SSL_get0_param(socket->ssl), endpoint.host.c_str());
+        } else {
+            SSL_set_tlsext_host_name(socket->ssl, endpoint.host.c_str());
+            SSL_set1_host(socket->ssl, endpoint.host.c_str());
+        }
+        if (SSL_SESSION* session = sessions.lookup(socket->sessionKey)) {
+            SSL_set_session(socket->ssl, session);
+            SSL_SESSION_free(session);
+        }
+
+        while (true) {
+            int result = SSL_connect(socket->ssl);
+            if (result == 1) {
+                break;
+            }
+            int sslError = SSL_get_error(socket->ssl, result);
+            short events = sslError == SSL_ERROR_WANT_READ ? POLLIN : POLLOUT;
+            if ((sslError != SSL_ERROR_WANT_READ && sslError != SSL_ERROR_WANT_WRITE) ||
+                !socket->wait(events, connectionTimeout * 1000)) {
+                long verify = SSL_get_verify_result(socket->ssl);
+                error = "TLS handshake with " + endpoint.host + " failed" +
+                        (verify != X509_V_OK ? std::string(": ") + X509_verify_cert_error_string(verify) : "");
+                return nullptr;
+            }
+        }
+
+        const unsigned char* protocol = nullptr;
+        unsigned int protocolLength = 0;
+        SSL_get0_alpn_selected(socket->ssl, &protocol, &protocolLength);
+        if (protocolLength != 2 || std::memcmp(protocol, "h2", 2) != 0) {
+            refused = true;
+            error = endpoint.host + " did not negotiate h2";
+            return nullptr;
+        }
+        established.tls = Clock::now() - tlsStarted;
+        established.tlsResumed = SSL_session_reused(socket->ssl) == 1;
+#else
+        (void)sessions;
+        refused = true;
+        error = "TLS is not available in this build";
+        return nullptr;
+#endif
+    }
+
+    connection->socket_ = std::move(socket);
+
+    nghttp2_session_callbacks* callbacks = nullptr;
+    nghttp2_session_callbacks_new(&callbacks);
+    nghttp2_session_callbacks_set_on_header_callback(callbacks, &Http2Callbacks::onHeader);
+    nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks, &Http2Callbacks::onFrame);
+    nghttp2_session_callbacks_set_on_data_chunk_recv_callback(callbacks, &Http2Callbacks::onData);
+    nghttp2_session_callbacks_set_on_stream_close_callback(callbacks, &Http2Callbacks::onClose);
+    nghttp2_option* options = nullptr;
+    nghttp2_option_new(&options);
+    nghttp2_option_set_no_auto_window_update(options, 1);
+    int created = nghttp2_session_client_new2(&connection->session_, callbacks, connection.get(), options);
+    nghttp2_option_del(options);
+    nghttp2_session_callbacks_del(callbacks);
+    if (created != 0) {
+        error = nghttp2_strerror(created);
+        return nullptr;
+    }
+
+    nghttp2_settings_entry settings[] = {
+        {NGHTTP2_SETTINGS_ENABLE_PUSH, 0},
+        {NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, 100},
+        {NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE, kStreamWindow},
+    };
+    nghttp2_submit_settings(connection->session_, NGHTTP2_FLAG_NONE, settings, sizeof(settings) / sizeof(settings[0]));
+    nghttp2_session_set_local_window_size(connection->session_, NGHTTP2_FLAG_NONE, 0, kConnectionWindow);
+
+    std::lock_guard<std::mutex> lock(connection->mutex_);
+    if (!connection->flush()) {
+        error = connection->error_;
+        return nullptr;
+    }
+    return connection;
+}
+
+Http2Result Http2Connection::execute(const Http2Request& request, const Http2Handlers& handlers, int readTimeout) {
+    auto stream = std::make_shared<Stream>();
+    stream->handlers = &handlers;
+    stream->body = request.body;
+
+    std::vector<std::pair<std::string, std::string>> fields = {
+        {":method", request.method},
+        {":scheme", request.scheme},
+        {":authority", request.authority},
+        {":path", request.path},
+    };
+    for (const auto& [name, value] : request.headers) {
+        std::string key = lowercase(name);
+        if (!isConnectionSpecific(key)) {
+            fields.emplace_back(std::move(key), value);
+        }
+    }
+    std::vector<nghttp2_nv> headers;
+    for (const auto& [name, value] : fields) {
+        headers.push_back(makeHeader(name, value));
+    }
+
+    nghttp2_data_provider provider;
+    provider.source.ptr = stream.get();
+    provider.read_callback = &Http2Callbacks::readBody;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    Http2Result& result = stream->result;
+    if (fresh_) {
+        fresh_ = false;
+        result = established_;
+    }
+
+    result.submitted = stream->lastActivity = Clock::now();
+    int32_t id = alive_ ? nghttp2_submit_request(session_, nullptr, headers.data(), headers.size(),
+                                                 request.body ? &provider : nullptr, stream.get())
+                        : -1;
+    if (id < 0) {
+        result.status = Http2Result::Status::Connection;
+        result.error = alive_ ? nghttp2_strerror(id) : error_;
+        return result;
+    }
+    streams_[id] = stream;
+    flush();
+
+    auto timeout = std::chrono::seconds(readTimeout);
+    while (true) {
+        deliver(id, *stream, lock);
+        if (stream->closed || !alive_) {
+            break;
+        }
+        if (Clock::now() - stream->lastActivity > timeout) {
+            break;
+        }
+        if (!driving_) {
+            driving_ = true;
+            lock.unlock();
+            bool readable = socket_->wait(POLLIN, kPollInterval);
+            lock.lock();
+            driving_ = false;
+            if (readable) {
+                receive();
+            } else {
+                flush();
+            }
+            progress_.notify_all();
+        } else {
+            progress_.wait_for(lock, std::chrono::milliseconds(kPollInterval));
+        }
+    }
+
+    if (!stream->closed) {
+        result.finished = Clock::now();
+        if (alive_) {
+            nghttp2_submit_rst_stream(session_, NGHTTP2_FLAG_NONE, id, NGHTTP2_CANCEL);
+            nghttp2_session_set_stream_user_data(session_, id, nullptr);
+            flush();
+            result.status = Http2Result::Status::Timeout;
+            result.error = "timed out waiting for the response";
+        } else {
+            result.status = Http2Result::Status::Connection;
+            result.error = error_;
+        }
+    } else if (stream->canceled) {
+        result.status = Http2Result::Status::Canceled;
+    } else if (stream->errorCode != NGHTTP2_NO_ERROR || !stream->headersDone) {
+        result.status = Http2Result::Status::Reset;
+        result.error = std::string("stream reset: ") + nghttp2_http2_strerror(stream->errorCode);
+    } else {
+        result.status = Http2Result::Status::Ok;
+    }
+
+    streams_.erase(id);
+    return result;
+}
+
+void Http2Connection::deliver(int32_t id, Stream& stream, std::unique_lock<std::mutex>& lock) {
+    size_t consumed = 0;
+    while (!stream.canceled && (stream.headersPending || !stream.chunks.empty())) {
+        bool keep = true;
+        if (stream.headersPending) {
+            stream.headersPending = false;
+            Http2Result snapshot = stream.result;
+            lock.unlock();
+            keep = stream.handlers->onHeaders(snapshot);
+            lock.lock();
+        } else {
+            std::string chunk = std::move(stream.chunks.front());
+            stream.chunks.pop_front();
+            lock.unlock();
+            keep = stream.handlers->onBody(chunk.data(), chunk.size());
+            lock.lock();
+            consumed += chunk.size();
+        }
+        stream.lastActivity = Clock::now();
+
+        if (!keep && alive_ && !stream.closed) {
+            Http2Callbacks::cancel(session_, id, &stream);
+        }
+        stream.canceled = stream.canceled || !keep;
+    }
+
+    for (const auto& chunk : stream.chunks) {
+        consumed += chunk.size();
+    }
+    stream.chunks.clear();
+    if (consumed > 0 && alive_) {
+        nghttp2_session_consume(session_, id, consumed);
+        flush();
+    }
+}
+
+bool Http2Connection::usable() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return alive_ && nghttp2_session_check_request_allowed(session_);
+}
+
+size_t Http2Connection::activeStreams() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return streams_.size();
+}
+
+size_t Http2Connection::maxStreams() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return maxStreams_;
+}
+
+bool Http2Connection::flush() {
+    while (alive_) {
+        const uint8_t* data = nullptr;
+        ssize_t length = nghttp2_session_mem_send(session_, &data);
+        if (length < 0) {
+            fail(nghttp2_strerror(static_cast<int>(length)));
+            return false;
+        }
+        if (length == 0) {
+            break;
+        }
+        if (!socket_->writeAll(data, static_cast<size_t>(length))) {
+            fail("connection closed while sending");
+            return false;
+        }
+    }
+
+    if (alive_ && !nghttp2_session_want_read(session_) && !nghttp2_session_want_write(session_)) {
+        fail("connection closed by server");
+    }
+    return alive_;
+}
+
+bool Http2Connection::receive() {
+    char buffer[64 * 1024];
+    while (alive_) {
+        bool blocked = false;
+        long length = socket_->read(buffer, sizeof(buffer), blocked);
+        if (length > 0) {
+            ssize_t consumed = nghttp2_session_mem_recv(session_, reinterpret_cast<const uint8_t*>(buffer),
+                                                        static_cast<size_t>(length));
+            if (consumed < 0) {
+                fail(nghttp2_strerror(static_cast<int>(consumed)));
+                return false;
+            }
+        } else if (blocked) {
+            break;
+        } else {
+            fail("connection closed by server");
+            return false;
+        }
+    }
+    return flush();
+}
+
+void Http2Connection::fail(const std::string& error) {
+    alive_ = false;
+    error_ = error;
+    progress_.notify_all();
+}
+
+}
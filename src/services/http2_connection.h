@@ -0,0 +1,117 @@
+﻿#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "dns_cache.h"
+#include "tls_session_cache.h"
+
+struct nghttp2_session;
+
+namespace lunarica {
+
+    using Http2Headers = std::vector<std::pair<std::string, std::string>>;
+
+    struct Http2Request {
+        std::string method;
+        std::string scheme;
+        std::string authority;
+        std::string path;
+        Http2Headers headers;
+        std::function<std::string_view(size_t)> body;
+    };
+
+    struct Http2Response {
+        int status = 0;
+        Http2Headers headers;
+        std::string body;
+    };
+
+    struct Http2Result {
+        using Clock = std::chrono::steady_clock;
+
+        enum class Status { Ok, Connection, Timeout, Reset, Canceled };
+
+        Status status = Status::Connection;
+        std::string error;
+        Http2Response response;
+        bool newConnection = false;
+        bool tlsResumed = false;
+        std::chrono::nanoseconds dns{0};
+        std::chrono::nanoseconds connect{0};
+        std::chrono::nanoseconds tls{0};
+        Clock::time_point submitted;
+        Clock::time_point headersAt;
+        Clock::time_point finished;
+        Clock::time_point uploadStarted;
+        Clock::time_point uploadFinished;
+        uint64_t uploaded = 0;
+
+        bool ok() const {
+            return status == Status::Ok;
+        }
+    };
+
+    struct Http2Handlers {
+        std::function<bool(const Http2Result&)> onHeaders;
+        std::function<bool(const char*, size_t)> onBody;
+    };
+
+    class Http2Connection {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        struct Endpoint {
+            std::string host;
+            int port = 0;
+            bool tls = false;
+        };
+
+        ~Http2Connection();
+        Http2Connection(const Http2Connection&) = delete;
+        Http2Connection& operator=(const Http2Connection&) = delete;
+
+        static std::shared_ptr<Http2Connection> open(const Endpoint& endpoint, DnsCache& dns, TlsSessionCache& sessions,
+                                                     int connectionTimeout, std::string& error, bool& refused);
+
+        Http2Result execute(const Http2Request& request, const Http2Handlers& handlers, int readTimeout);
+
+        bool usable() const;
+        size_t activeStreams() const;
+        size_t maxStreams() const;
+
+    private:
+        struct Stream;
+        struct Socket;
+
+        Http2Connection();
+
+        std::unique_ptr<Socket> socket_;
+        nghttp2_session* session_ = nullptr;
+        mutable std::mutex mutex_;
+        std::condition_variable progress_;
+        std::map<int32_t, std::shared_ptr<Stream>> streams_;
+        bool driving_ = false;
+        bool alive_ = true;
+        bool fresh_ = true;
+        size_t maxStreams_ = 100;
+        std::string error_;
+        Http2Result established_;
+
+        bool flush();
+        bool receive();
+        void deliver(int32_t id, Stream& stream, std::unique_lock<std::mutex>& lock);
+        void fail(const std::string& error);
+
+        friend struct Http2Callbacks;
+    };
+
+}
@@ -0,0 +1,120 @@
+﻿#include "http2_transport.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace lunarica {
+
+Http2Transport::Http2Transport(DnsCache& dns, TlsSessionCache& sessions) : dns_(dns), sessions_(sessions) {
+}
+
+bool Http2Transport::execute(const Http2Connection::Endpoint& endpoint, const Http2Request& request,
+                             const Http2Handlers& handlers, int connectionTimeout, int readTimeout, Http2Result& result) {
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        bool refused = false;
+        auto connection = acquire(endpoint, connectionTimeout, result, refused);
+        if (refused) {
+            return false;
+        }
+        if (!connection) {
+            return true;
+        }
+
+        result = connection->execute(request, handlers, readTimeout);
+        bool retry = result.status == Http2Result::Status::Connection && !result.newConnection &&
+                     result.response.status == 0 && result.uploaded == 0;
+        if (!retry) {
+            break;
+        }
+    }
+    return true;
+}
+
+bool Http2Transport::speaksHttp1Only(const Http2Connection::Endpoint& endpoint) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return http1Only_.count(keyOf(endpoint)) > 0;
+}
+
+size_t Http2Transport::connectionCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (const auto& [_, connections] : connections_) {
+        count += connections.size();
+    }
+    return count;
+}
+
+void Http2Transport::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    connections_.clear();
+    http1Only_.clear();
+}
+
+std::shared_ptr<Http2Connection> Http2Transport::acquire(const Http2Connection::Endpoint& endpoint, int connectionTimeout,
+                                                         Http2Result& result, bool& refused) {
+    std::string key = keyOf(endpoint);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        if (http1Only_.count(key) > 0) {
+            refused = true;
+            return nullptr;
+        }
+
+        auto& connections = connections_[key];
+        connections.erase(std::remove_if(connections.begin(), connections.end(), [](const auto& connection) {
+            return !connection->usable();
+        }), connections.end());
+
+        std::shared_ptr<Http2Connection> best;
+        size_t bestLoad = 0;
+        for (const auto& connection : connections) {
+            size_t load = connection->activeStreams();
+            if (!best || load < bestLoad) {
+                best = connection;
+                bestLoad = load;
+            }
+        }
+        size_t opening = opening_.count(key) > 0 ? opening_[key] : 0;
+        if (best && (bestLoad < best->maxStreams() || connections.size() + opening >= kMaxConnections)) {
+            return best;
+        }
+        if (opening == 0) {
+            break;
+        }
+        // Another request is already connecting to this host; its connection
+        // will most likely have room for this stream as well.
+        opened_.wait(lock);
+    }
+
+    // Connecting can take up to the connect timeout, so it happens outside
+    // the lock and only this host's requests wait for it.
+    opening_[key]++;
+    lock.unlock();
+    std::string error;
+    auto connection = Http2Connection::open(endpoint, dns_, sessions_, connectionTimeout, error, refused);
+    lock.lock();
+    if (--opening_[key] == 0) {
+        opening_.erase(key);
+    }
+    opened_.notify_all();
+
+    if (refused) {
+        http1Only_.insert(key);
+        return nullptr;
+    }
+    if (!connection) {
+        result = Http2Result();
+        result.error = error;
+        return nullptr;
+    }
+    connections_[key].push_back(connection);
+    return connection;
+}
+
+std::string Http2Transport::keyOf(const Http2Connection::Endpoint& endpoint) {
+    std::string host = endpoint.host;
+    std::transform(host.begin(), host.end(), host.begin(), [](unsigned char c) { return std::tolower(c); });
+    return std::string(endpoint.tls ? "https://" : "http://") + host + ":" + std::to_string(endpoint.port);
+}
+
+}
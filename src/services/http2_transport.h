@@ -0,0 +1,42 @@
+﻿#pragma once
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include "http2_connection.h"
+
+namespace lunarica {
+
+    class Http2Transport {
+    public:
+        static constexpr size_t kMaxConnections = 4;
+
+        Http2Transport(DnsCache& dns, TlsSessionCache& sessions);
+
+        bool execute(const Http2Connection::Endpoint& endpoint, const Http2Request& request,
+                     const Http2Handlers& handlers, int connectionTimeout, int readTimeout, Http2Result& result);
+
+        bool speaksHttp1Only(const Http2Connection::Endpoint& endpoint) const;
+        size_t connectionCount() const;
+        void clear();
+
+    private:
+        DnsCache& dns_;
+        TlsSessionCache& sessions_;
+        mutable std::mutex mutex_;
+        std::condition_variable opened_;
+        std::map<std::string, std::vector<std::shared_ptr<Http2Connection>>> connections_;
+        std::map<std::string, size_t> opening_;
+        std::set<std::string> http1Only_;
+
+        std::shared_ptr<Http2Connection> acquire(const Http2Connection::Endpoint& endpoint, int connectionTimeout,
+                                                 Http2Result& result, bool& refused);
+
+        static std::string keyOf(const Http2Connection::Endpoint& endpoint);
+    };
+
+}
@@ -1,69 +1,634 @@
 ﻿#include "http_service.h"
 
+#include <cctype>
+#include <thread>
+#include <fmt/core.h>
+#include "utils/interrupt_guard.h"
+#include "utils/latency_histogram.h"
+
 namespace lunarica {
 
-HttpService::HttpService(std::shared_ptr<Context> context, std::shared_ptr<JsonFormatter> formatter)
-    : context_(std::move(context)), formatter_(std::move(formatter)) {
+namespace {
+
+constexpr size_t kUploadSlice = 256 * 1024;
+constexpr size_t kMaxRedirects = 20;
+
+struct UploadMeter {
+    ConnectionProbe::Clock::time_point started;
+    ConnectionProbe::Clock::time_point finished;
+    uint64_t bytes = 0;
+    uint64_t source = 0;
+    std::unique_ptr<ContentEncoder> encoder;
+};
+
+RequestTiming http2Timing(const Http2Result& result, Http2Result::Clock::time_point now) {
+    RequestTiming timing;
+    timing.http2 = true;
+    timing.newConnection = result.newConnection;
+    timing.dns = result.dns;
+    timing.connect = result.connect;
+    timing.tls = result.tls;
+    timing.tlsHandshake = result.tls.count() > 0;
+    timing.tlsResumed = result.tlsResumed;
+
+    bool headersSeen = result.headersAt != Http2Result::Clock::time_point();
+    auto headersAt = headersSeen ? result.headersAt : now;
+    timing.ttfb = headersAt - result.submitted;
+    if (headersSeen && result.finished > headersAt) {
+        timing.transfer = result.finished - headersAt;
+    }
+    if (result.uploaded > 0 && result.uploadFinished > result.uploadStarted) {
+        timing.uploaded = result.uploaded;
+        timing.upload = result.uploadFinished - result.uploadStarted;
+    }
+    return timing;
+}
+
+}
+
+HttpService::HttpService(std::shared_ptr<Context> context,
+                         std::shared_ptr<JsonFormatter> formatter,
+                         std::shared_ptr<OutputSink> sink)
+    : context_(std::move(context)),
+      formatter_(std::move(formatter)),
+      sink_(std::move(sink)),
+      connectionPool_(context_),
+      http2_(connectionPool_.getDnsCache(), connectionPool_.getTlsSessions()) {
 }
 
 void HttpService::get(const std::string& path) {
-    makeRequest(path, "GET", [](httplib::Client& client, const std::string& path, const httplib::Headers& headers) {
-        return client.Get(path.c_str(), headers);
-    });
+    makeRequest(path, "GET");
 }
 
 void HttpService::post(const std::string& path) {
-    makeRequestWithBody(path, "POST", [](httplib::Client& client, const std::string& path,
-                                      const httplib::Headers& headers, const std::string& body, const std::string& contentType) {
-        return client.Post(path.c_str(), headers, body, contentType);
-    });
+    makeRequestWithBody(path, "POST");
 }
 
 void HttpService::put(const std::string& path) {
-    makeRequestWithBody(path, "PUT", [](httplib::Client& client, const std::string& path,
-                                     const httplib::Headers& headers, const std::string& body, const std::string& contentType) {
-        return client.Put(path.c_str(), headers, body, contentType);
-    });
+    makeRequestWithBody(path, "PUT");
 }
 
 void HttpService::del(const std::string& path) {
-    makeRequest(path, "DELETE", [](httplib::Client& client, const std::string& path, const httplib::Headers& headers) {
-        return client.Delete(path.c_str(), headers);
+    makeRequest(path, "DELETE");
+}
+
+void HttpService::upload(const std::string& method, const std::string& path, const std::string& file, bool chunked) {
+    HttpRequest request = buildRequest(path, method);
+    if (!attachFile(request, file, chunked)) {
+        return;
+    }
+
+    *sink_ << "\nMaking " << method << " request to: " << request.url << '\n';
+    *sink_ << "Uploading " << file << " (" << request.bodyFile->size() << " bytes"
+           << (chunked ? ", chunked" : "") << ")\n";
+    compressBody(request);
+    sink_->flush();
+
+    streamResponse(request);
+}
+
+void HttpService::uploadForm(const std::string& method, const std::string& path, const std::vector<FormField>& fields) {
+    std::vector<FormField> parts;
+    for (const auto& [name, value] : context_->getBodyParams()) {
+        parts.push_back({name, value, ""});
+    }
+    parts.insert(parts.end(), fields.begin(), fields.end());
+
+    std::string error;
+    HttpRequest request = buildRequest(path, method);
+    request.form = MultipartBody::build(parts, error);
+    if (!request.form) {
+        *sink_ << "Error: " << error << '\n';
+        return;
+    }
+    request.contentType = request.form->contentType();
+    request.headers.erase("Content-Type");
+    request.headers.emplace("Content-Type", request.contentType);
+
+    *sink_ << "\nMaking " << method << " request to: " << request.url << '\n';
+    *sink_ << "Uploading " << parts.size() << " form " << (parts.size() == 1 ? "part" : "parts")
+           << " (" << request.form->size() << " bytes)\n";
+    compressBody(request);
+    sink_->flush();
+
+    streamResponse(request);
+}
+
+void HttpService::show(const std::string& reference) {
+    size_t number = 1;
+    std::vector<JsonPathStep> steps;
+    if (!ResponseStore::parseReference(reference, number, steps)) {
+        *sink_ << "Invalid path: " << reference << '\n';
+        return;
+    }
+
+    auto response = responses_.get(number);
+    if (!response) {
+        *sink_ << "No stored response $" << number << '\n';
+        return;
+    }
+
+    std::string label = "$" + std::to_string(number) + JsonPath::toString(steps).substr(1);
+    std::string_view value = response->body.view();
+    if (!steps.empty()) {
+        JsonDocumentIndex& structure = response->structure();
+        value = structure.value(structure.resolve(steps));
+        if (value.empty()) {
+            *sink_ << "Path not found: " << label << '\n';
+            return;
+        }
+    }
+
+    *sink_ << label << '\n';
+    formatter_->setLimits(renderLimits());
+    formatter_->format(value);
+}
+
+void HttpService::query(const std::string& expression) {
+    size_t number = 1;
+    std::string_view text = expression;
+    if (text.size() > 1 && text[0] == '$' && std::isdigit(static_cast<unsigned char>(text[1]))) {
+        size_t digits = 1;
+        number = 0;
+        while (digits < text.size() && std::isdigit(static_cast<unsigned char>(text[digits]))) {
+            number = number * 10 + static_cast<size_t>(text[digits] - '0');
+            digits++;
+        }
+        text.remove_prefix(digits);
+    }
+
+    JsonQuery compiled;
+    if (!compiled.parse(text)) {
+        *sink_ << "Invalid query: " << compiled.error() << '\n';
+        return;
+    }
+
+    auto response = responses_.get(number);
+    if (!response) {
+        *sink_ << "No stored response $" << number << '\n';
+        return;
+    }
+
+    formatter_->setLimits(renderLimits());
+    size_t results = compiled.run(response->body.view(), [this](std::string_view value) {
+        formatter_->format(value);
     });
+    *sink_ << results << (results == 1 ? " result" : " results") << " from $" << number << '\n';
 }
 
-void HttpService::makeRequest(const std::string& path,
-                             const std::string& method,
-                             const std::function<httplib::Result(httplib::Client&, const std::string&, const httplib::Headers&)>& requestFunc) {
-    std::string url = parseUrl(context_->getUrl(), path);
-    std::string host = extractHost(url);
-    std::string queryString = buildQueryString();
+void HttpService::stream(const std::string& path, size_t limit) {
+    using Clock = std::chrono::steady_clock;
 
-    if (!queryString.empty() && url.find('?') == std::string::npos) {
-        url += "?" + queryString;
-    } else if (!queryString.empty()) {
-        url += "&" + queryString;
+    HttpRequest request = buildRequest(path, "GET");
+    if (request.headers.find("Accept") == request.headers.end()) {
+        request.headers.emplace("Accept", "text/event-stream, application/x-ndjson");
     }
 
-    std::cout << "\nMaking " << method << " request to: " << url << std::endl;
+    *sink_ << "\nStreaming from: " << request.url << '\n';
+    sink_->flush();
+
+    RequestTiming timing;
+    std::unique_ptr<EventStreamDecoder> decoder;
+    LatencyHistogram gaps;
+    Clock::time_point opened;
+    Clock::time_point previous;
+    double averageGap = 0.0;
+    size_t events = 0;
+    size_t received = 0;
+    bool stopped = false;
+    InterruptGuard interrupt;
+
+    auto onEvent = [&](const StreamEvent& event) {
+        auto now = Clock::now();
+        auto gap = now - previous;
+        previous = now;
+        events++;
+        gaps.record(std::chrono::duration_cast<std::chrono::microseconds>(gap).count());
+
+        double seconds = std::chrono::duration<double>(gap).count();
+        averageGap = events == 1 ? seconds : averageGap * 0.8 + seconds * 0.2;
+
+        *sink_ << fmt::format("#{} +{} | {:.1f} events/s", events, RequestTiming::formatDuration(gap),
+                              averageGap > 0.0 ? 1.0 / averageGap : 0.0);
+        if (event.type != "message" && !event.type.empty()) {
+            *sink_ << " | event " << event.type;
+        }
+        if (!event.id.empty()) {
+            *sink_ << " | id " << event.id;
+        }
+        *sink_ << '\n';
+        formatter_->format(event.data);
+
+        stopped = (limit > 0 && events >= limit) || interrupt.triggered();
+        return !stopped;
+    };
+
+    ResponseHooks hooks;
+    hooks.onHeaders = [&](const httplib::Response& response) {
+        printResponseHead(response, timing);
+        decoder = std::make_unique<EventStreamDecoder>(
+            EventStreamDecoder::detect(response.get_header_value("Content-Type")));
+        formatter_->setLimits(renderLimits());
+        sink_->flush();
+        opened = previous = Clock::now();
+        return true;
+    };
+    hooks.onBody = [&](const char* data, size_t length) {
+        received += length;
+        stopped = stopped || interrupt.triggered();
+        bool more = !stopped && decoder->feed(data, length, onEvent);
+        // Once per read rather than per event: a burst of events costs one
+        // write, and the last event of a burst is never held back.
+        sink_->flush();
+        return more;
+    };
+
+    auto res = send(request, &timing, hooks);
+
+    if (decoder) {
+        if (!stopped) {
+            decoder->finish(onEvent);
+        }
+        double elapsed = std::chrono::duration<double>(Clock::now() - opened).count();
+        *sink_ << std::string(50, '=') << '\n';
+        *sink_ << fmt::format("{} {} ({} bytes) in {:.2f} s | {:.1f} events/s", events,
+                              events == 1 ? "event" : "events", received, elapsed,
+                              elapsed > 0.0 ? events / elapsed : 0.0);
+        if (gaps.count() > 0) {
+            auto gap = [&](double percentile) {
+                return RequestTiming::formatDuration(std::chrono::microseconds(gaps.valueAtPercentile(percentile)));
+            };
+            *sink_ << " | gap p50 " << gap(50) << " p99 " << gap(99)
+                   << " max " << RequestTiming::formatDuration(std::chrono::microseconds(gaps.max()));
+        }
+        *sink_ << '\n';
+    }
 
-    std::string requestPath;
-    httplib::Client client = prepareClient(url, requestPath);
+    if (!res && !stopped) {
+        printError(res.error());
+    }
+}
 
-    httplib::Headers headers;
-    for (const auto& [name, value] : context_->getHeaders()) {
-        headers.emplace(name, value);
+HttpRequest HttpService::prepareRequest(const std::string& method, const std::string& path) {
+    HttpRequest request = buildRequest(path, method);
+    if (methodHasBody(method)) {
+        attachBody(request);
+    }
+    return request;
+}
+
+httplib::Result HttpService::send(const HttpRequest& request) {
+    return send(request, nullptr, ResponseHooks());
+}
+
+httplib::Result HttpService::send(const HttpRequest& request, const ResponseHooks& hooks) {
+    return send(request, nullptr, hooks);
+}
+
+bool HttpService::methodHasBody(const std::string& method) {
+    return method == "POST" || method == "PUT";
+}
+
+void HttpService::makeRequest(const std::string& path, const std::string& method) {
+    HttpRequest request = buildRequest(path, method);
+
+    *sink_ << "\nMaking " << method << " request to: " << request.url << '\n';
+    sink_->flush();
+
+    streamResponse(request, method == "GET");
+}
+
+void HttpService::makeRequestWithBody(const std::string& path, const std::string& method) {
+    HttpRequest request = buildRequest(path, method);
+    attachBody(request);
+
+    *sink_ << "\nMaking " << method << " request to: " << request.url << '\n';
+    compressBody(request);
+    sink_->flush();
+
+    streamResponse(request);
+}
+
+httplib::Result HttpService::send(const HttpRequest& request, RequestTiming* timing, const ResponseHooks& hooks,
+                                  HedgeRace::Leg* leg) {
+    if (auto result = sendHttp2(request, timing, hooks)) {
+        return std::move(*result);
+    }
+
+    auto started = ConnectionProbe::Clock::now();
+    ConnectionPool::Lease client = connectionPool_.acquire(request.scheme, request.host);
+    ConnectionProbe& probe = client.probe();
+
+    // A failed lookup (possibly a cached one) would only make httplib run
+    // getaddrinfo again on its own; fail the request with it instead.
+    if (!client.resolveError().empty()) {
+        client.discard();
+        return httplib::Result(nullptr, httplib::Error::Connection);
+    }
+
+    httplib::Request req;
+    req.method = request.method;
+    req.path = request.path;
+    req.headers = request.headers;
+    req.body = request.body;
+
+    UploadMeter upload;
+    if (request.bodyFile || request.form) {
+        std::function<std::string_view(size_t)> slice;
+        if (request.form) {
+            auto form = request.form;
+            req.content_length_ = form->size();
+            slice = [form](size_t offset) {
+                return form->slice(offset, kUploadSlice);
+            };
+        } else {
+            auto file = request.bodyFile;
+            req.content_length_ = file->size();
+            slice = [file](size_t offset) {
+                return file->view().substr(offset, kUploadSlice);
+            };
+        }
+
+        size_t total = req.content_length_;
+        req.is_chunked_content_provider_ = request.chunked;
+        if (request.chunked) {
+            req.headers.emplace("Transfer-Encoding", "chunked");
+        }
+        int level = request.compressLevel;
+        req.content_provider_ = [slice, total, level, &upload](size_t offset, size_t, httplib::DataSink& sink) {
+            if (offset == 0 && upload.source == 0) {
+                upload.started = ConnectionProbe::Clock::now();
+                if (level > 0) {
+                    std::string error;
+                    upload.encoder = ContentEncoder::create(level, error);
+                    if (!upload.encoder) {
+                        return false;
+                    }
+                }
+            }
+
+            std::string_view data = slice(upload.source);
+            upload.source += data.size();
+            if (upload.encoder) {
+                auto write = [&](const char* chunk, size_t length) {
+                    upload.bytes += length;
+                    return sink.write(chunk, length);
+                };
+                if (!upload.encoder->feed(data.data(), data.size(), write) ||
+                    (upload.source == total && !upload.encoder->finish(write))) {
+                    return false;
+                }
+            } else {
+                if (!data.empty() && !sink.write(data.data(), data.size())) {
+                    return false;
+                }
+                upload.bytes = offset + data.size();
+            }
+
+            if (upload.source == total) {
+                upload.finished = ConnectionProbe::Clock::now();
+                if (sink.done) {
+                    sink.done();
+                }
+            }
+            return true;
+        };
+    }
+    req.response_handler = [&](const httplib::Response& response) {
+        probe.markHeaders();
+        if (timing) {
+            *timing = probe.finish(ConnectionProbe::Clock::now());
+        }
+        return hooks.onHeaders ? hooks.onHeaders(response) : true;
+    };
+    if (hooks.onBody) {
+        req.content_receiver = [&hooks](const char* data, size_t length, uint64_t, uint64_t) {
+            return hooks.onBody(data, length);
+        };
+    }
+
+    if (leg && !leg->attach(client.client())) {
+        return httplib::Result(nullptr, httplib::Error::Canceled);
+    }
+
+    probe.beginRequest(started);
+    auto res = client->send(req);
+
+    while (!res && res.error() == httplib::Error::Connection && !(leg && leg->cancelled()) && client.unpin()) {
+        upload = UploadMeter();
+        probe.beginRequest(started);
+        res = client->send(req);
+    }
+
+    if (timing) {
+        *timing = probe.finish(ConnectionProbe::Clock::now());
+        if (upload.bytes > 0) {
+            timing->uploaded = upload.bytes;
+            timing->uploadedRaw = upload.source;
+            timing->upload = upload.finished - upload.started;
+        }
+    }
+
+    if (leg) {
+        leg->detach();
+    }
+    if (!res) {
+        client.discard();
+    }
+    return res;
+}
+
+httplib::Result HttpService::sendHedged(const HttpRequest& request, RequestTiming* timing,
+                                        const ResponseHooks& hooks, HedgeOutcome& outcome) {
+    auto started = HedgeRace::Clock::now();
+    bool hedge = hedger_.delayFor(request.host, context_->getHedgeMode(), context_->getHedgeDelay(), outcome.delay);
+
+    HedgeRace race;
+    HedgeRace::Leg legs[2] = {HedgeRace::Leg(race, 0), HedgeRace::Leg(race, 1)};
+    RequestTiming timings[2];
+    auto legHooks = [&](size_t index) {
+        ResponseHooks wrapped;
+        wrapped.onHeaders = [&, index](const httplib::Response& response) {
+            if (!legs[index].claim()) {
+                return false;
+            }
+            if (timing) {
+                *timing = timings[index];
+            }
+            return hooks.onHeaders ? hooks.onHeaders(response) : true;
+        };
+        wrapped.onBody = hooks.onBody;
+        return wrapped;
+    };
+
+    // The duplicate goes out from a helper thread once the delay passes
+    // without headers on the original; whichever leg loses is stopped by
+    // HedgeRace so that neither thread outlives this call for long.
+    std::optional<httplib::Result> duplicate;
+    std::thread hedgeThread;
+    if (hedge) {
+        hedgeThread = std::thread([&] {
+            if (race.waitForHeaders(started + outcome.delay)) {
+                return;
+            }
+            outcome.fired = true;
+            duplicate = send(request, &timings[1], legHooks(1), &legs[1]);
+        });
+    }
+
+    auto res = send(request, &timings[0], legHooks(0), &legs[0]);
+    legs[0].finish();
+    if (hedgeThread.joinable()) {
+        hedgeThread.join();
+    }
+
+    int winner = race.winner();
+    if (winner == 1 && duplicate) {
+        res = std::move(*duplicate);
+    }
+    if (winner >= 0 && timing) {
+        *timing = timings[winner];
+    }
+    // Only the original leg running alone measures the host's own latency.
+    if (!hedge && winner == 0) {
+        hedger_.record(request.host,
+                       std::chrono::duration_cast<std::chrono::microseconds>(race.decidedAt() - started));
+    }
+    outcome.won = winner == 1;
+    hedger_.count(outcome.fired, outcome.won);
+    return res;
+}
+
+bool HttpService::usesHttp2(const HttpRequest& request) const {
+    Http2Mode mode = context_->getHttp2Mode();
+    bool tls = request.scheme == "https";
+    return mode != Http2Mode::Off && (tls || mode == Http2Mode::PriorKnowledge) && request.compressLevel == 0;
+}
+
+std::optional<httplib::Result> HttpService::sendHttp2(const HttpRequest& request, RequestTiming* timing,
+                                                      const ResponseHooks& hooks, size_t redirects) {
+    if (!usesHttp2(request)) {
+        return std::nullopt;
+    }
+
+    bool tls = request.scheme == "https";
+    std::string key = ConnectionPool::makeKey(request.scheme, request.host);
+    Http2Connection::Endpoint endpoint;
+    endpoint.host = DnsResolver::hostnameOf(request.host);
+    endpoint.port = std::atoi(key.c_str() + key.rfind(':') + 1);
+    endpoint.tls = tls;
+
+    Http2Request h2;
+    h2.method = request.method;
+    h2.scheme = tls ? "https" : "http";
+    h2.authority = request.host;
+    h2.path = request.path;
+    h2.headers.assign(request.headers.begin(), request.headers.end());
+    if (request.headers.find("Accept") == request.headers.end()) {
+        h2.headers.emplace_back("accept", "*/*");
+    }
+
+    size_t length = request.body.size();
+    if (request.form) {
+        auto form = request.form;
+        length = form->size();
+        h2.body = [form](size_t offset) {
+            return form->slice(offset, kUploadSlice);
+        };
+    } else if (request.bodyFile) {
+        auto file = request.bodyFile;
+        length = file->size();
+        h2.body = [file](size_t offset) {
+            return file->view().substr(offset, kUploadSlice);
+        };
+    } else if (!request.body.empty()) {
+        h2.body = [&request](size_t offset) {
+            return std::string_view(request.body).substr(offset, kUploadSlice);
+        };
+    }
+    if (h2.body) {
+        h2.headers.emplace_back("content-length", std::to_string(length));
+    }
+
+    httplib::Response response;
+    bool redirecting = false;
+    Http2Handlers handlers;
+    handlers.onHeaders = [&](const Http2Result& head) {
+        response.status = head.response.status;
+        for (const auto& [name, value] : head.response.headers) {
+            response.headers.emplace(name, value);
+        }
+        if (timing) {
+            *timing = http2Timing(head, Http2Result::Clock::now());
+        }
+        // Mirror httplib's follow_location: redirect hops never reach the hooks.
+        redirecting = response.status > 300 && response.status < 400 && response.has_header("location");
+        if (redirecting) {
+            return true;
+        }
+        return hooks.onHeaders ? hooks.onHeaders(response) : true;
+    };
+    if (hooks.onBody) {
+        handlers.onBody = [&](const char* data, size_t length) {
+            return redirecting || hooks.onBody(data, length);
+        };
+    }
+
+    Http2Result result;
+    if (!http2_.execute(endpoint, h2, handlers, context_->getConnectionTimeout(), context_->getReadTimeout(), result)) {
+        return std::nullopt;
+    }
+    if (timing) {
+        *timing = http2Timing(result, Http2Result::Clock::now());
+    }
+
+    if (result.status == Http2Result::Status::Ok && redirecting) {
+        if (redirects >= kMaxRedirects) {
+            return httplib::Result(nullptr, httplib::Error::ExceedRedirectCount);
+        }
+        HttpRequest next = redirectRequest(request, response.status, response.get_header_value("location"));
+        if (auto followed = sendHttp2(next, timing, hooks, redirects + 1)) {
+            return followed;
+        }
+        return send(next, timing, hooks);
     }
 
-    auto res = requestFunc(client, requestPath, headers);
-    processResponse(res);
+    switch (result.status) {
+        case Http2Result::Status::Ok:
+            response.body = std::move(result.response.body);
+            return httplib::Result(std::make_unique<httplib::Response>(std::move(response)), httplib::Error::Success);
+        case Http2Result::Status::Canceled:
+            return httplib::Result(nullptr, httplib::Error::Canceled);
+        case Http2Result::Status::Connection:
+            return httplib::Result(nullptr, httplib::Error::Connection);
+        default:
+            return httplib::Result(nullptr, httplib::Error::Read);
+    }
+}
+
+HttpRequest HttpService::redirectRequest(const HttpRequest& request, int status, const std::string& location) {
+    HttpRequest next = request;
+    std::string base = request.scheme + "://" + request.host + request.path.substr(0, request.path.rfind('/') + 1);
+    next.url = parseUrl(base, location);
+    next.scheme = extractScheme(next.url);
+    next.host = extractHost(next.url);
+    next.path = extractPath(next.url);
+    if (status == 303 && request.method != "GET" && request.method != "HEAD") {
+        next.method = "GET";
+        next.headers.clear();
+        next.body.clear();
+        next.contentType.clear();
+        next.bodyFile.reset();
+        next.form.reset();
+    }
+    return next;
 }
 
-void HttpService::makeRequestWithBody(const std::string& path,
-                                    const std::string& method,
-                                    const std::function<httplib::Result(httplib::Client&, const std::string&, const httplib::Headers&, const std::string&, const std::string&)>& requestFunc) {
+HttpRequest HttpService::buildRequest(const std::string& path, const std::string& method) {
+    HttpRequest request;
+    request.method = method;
+
     std::string url = parseUrl(context_->getUrl(), path);
-    std::string host = extractHost(url);
     std::string queryString = buildQueryString();
 
     if (!queryString.empty() && url.find('?') == std::string::npos) {
@@ -72,77 +637,236 @@ void HttpService::makeRequestWithBody(const std::string& path,
         url += "&" + queryString;
     }
 
-    std::cout << "\nMaking " << method << " request to: " << url << std::endl;
+    request.url = url;
+    request.scheme = extractScheme(url);
+    request.host = extractHost(url);
+    request.path = extractPath(url);
 
-    std::string requestPath;
-    httplib::Client client = prepareClient(url, requestPath);
-
-    httplib::Headers headers;
     for (const auto& [name, value] : context_->getHeaders()) {
-        headers.emplace(name, value);
+        request.headers.emplace(name, value);
+    }
+
+    return request;
+}
+
+void HttpService::attachBody(HttpRequest& request) {
+    request.body = buildRequestBody();
+    request.contentType = "application/json";
+
+    auto it = request.headers.find("Content-Type");
+    if (it == request.headers.end()) {
+        request.headers.emplace("Content-Type", request.contentType);
+    } else {
+        request.contentType = it->second;
     }
+}
 
-    std::string body = buildRequestBody();
-    std::string contentType = "application/json";
+void HttpService::compressBody(HttpRequest& request) {
+    int level = context_->getCompressLevel();
+    size_t size = request.form ? request.form->size() : request.bodyFile ? request.bodyFile->size() : request.body.size();
+    if (level == 0 || size < context_->getCompressThreshold() ||
+        request.headers.find("Content-Encoding") != request.headers.end()) {
+        return;
+    }
 
-    if (headers.find("Content-Type") == headers.end()) {
-        headers.emplace("Content-Type", contentType);
+    if (request.bodyFile || request.form) {
+        request.compressLevel = level;
+        request.chunked = true;
+        *sink_ << "Compressing on the fly with gzip level " << level << '\n';
     } else {
-        auto it = headers.find("Content-Type");
-        contentType = it->second;
+        std::string error;
+        std::string compressed = ContentEncoder::compress(request.body, level, error);
+        if (!error.empty()) {
+            *sink_ << "Error: " << error << ", sending the body uncompressed\n";
+            return;
+        }
+        *sink_ << "Compressed body with gzip level " << level << ": " << size << " -> "
+               << compressed.size() << " bytes\n";
+        request.body = std::move(compressed);
+    }
+    request.headers.emplace("Content-Encoding", "gzip");
+}
+
+bool HttpService::attachFile(HttpRequest& request, const std::string& file, bool chunked) {
+    std::string error;
+    request.bodyFile = MappedFile::open(file, error);
+    if (!request.bodyFile) {
+        *sink_ << "Error: " << error << '\n';
+        return false;
     }
+    request.chunked = chunked;
 
-    auto res = requestFunc(client, requestPath, headers, body, contentType);
-    processResponse(res);
+    auto it = request.headers.find("Content-Type");
+    if (it != request.headers.end()) {
+        request.contentType = it->second;
+    } else {
+        request.contentType = MultipartBody::contentTypeFor(file);
+        request.headers.emplace("Content-Type", request.contentType);
+    }
+    return true;
 }
 
-void HttpService::processResponse(const httplib::Result& res) {
-    if (res) {
-        std::cout << "\n" << std::string(50, '=') << std::endl;
-        std::cout << "STATUS: " << res->status << std::endl;
-        std::cout << std::string(50, '=') << std::endl;
+void HttpService::streamResponse(HttpRequest& request, bool hedgeable) {
+    std::string acceptEncoding = ContentDecoder::acceptEncoding();
+    if (!acceptEncoding.empty() && request.headers.find("Accept-Encoding") == request.headers.end()) {
+        request.headers.emplace("Accept-Encoding", acceptEncoding);
+    }
 
-        std::cout << "HEADERS:" << std::endl;
-        std::cout << std::string(50, '-') << std::endl;
-        for (const auto& [name, value] : res->headers) {
-            std::cout << "  " << name << ": " << value << std::endl;
+    RequestTiming timing;
+    RequestTiming::Duration renderTime{0};
+    std::unique_ptr<ContentDecoder> decoder;
+    std::string decodeError;
+    size_t wire = 0;
+    size_t received = 0;
+    size_t rendered = 0;
+    size_t inlineLimit = context_->getInlineLimit();
+    bool headPrinted = false;
+
+    auto stored = responses_.create(request.method, request.url);
+
+    ResponseHooks hooks;
+    hooks.onHeaders = [&](const httplib::Response& response) {
+        stored->status = response.status;
+        stored->contentType = response.get_header_value("Content-Type");
+        stored->headers.assign(response.headers.begin(), response.headers.end());
+        printResponseHead(response, timing);
+        std::string encoding = response.get_header_value("Content-Encoding");
+        decoder = ContentDecoder::create(encoding, decodeError);
+        if (!decodeError.empty()) {
+            *sink_ << "Note: " << decodeError << ", showing raw bytes\n";
+            decodeError.clear();
+        }
+        formatter_->setLimits(renderLimits());
+        formatter_->beginStream(stored->contentType, context_->getStreamWindow());
+        sink_->flush();
+        headPrinted = true;
+        return true;
+    };
+    auto consume = [&](const char* data, size_t length) {
+        stored->body.append(data, length);
+        auto renderStarted = std::chrono::steady_clock::now();
+        if (inlineLimit == 0 || rendered < inlineLimit) {
+            size_t visible = inlineLimit == 0 ? length : std::min(length, inlineLimit - rendered);
+            formatter_->feed(data, visible);
+            sink_->flushIfDue();
+            rendered += visible;
+        }
+        renderTime += std::chrono::steady_clock::now() - renderStarted;
+        received += length;
+        return true;
+    };
+    hooks.onBody = [&](const char* data, size_t length) {
+        wire += length;
+        if (!decoder) {
+            return consume(data, length);
         }
-        std::cout << std::string(50, '=') << std::endl;
+        if (!decoder->feed(data, length, consume)) {
+            decodeError = decoder->error();
+            return false;
+        }
+        return true;
+    };
 
-        std::cout << "BODY:" << std::endl;
-        std::cout << std::string(50, '-') << std::endl;
-        if (res->body.empty()) {
-            std::cout << "(Empty response)" << std::endl;
-        } else {
-            formatter_->format(res->body);
+    HedgeOutcome hedge;
+    bool hedged = hedgeable && context_->getHedgeMode() != HedgeMode::Off && !usesHttp2(request);
+    auto res = hedged ? sendHedged(request, &timing, hooks, hedge) : send(request, &timing, hooks);
+
+    if (decoder && res && decodeError.empty() && !decoder->finish(consume)) {
+        decodeError = decoder->error();
+    }
+
+    if (headPrinted) {
+        auto renderStarted = std::chrono::steady_clock::now();
+        if (received == 0) {
+            *sink_ << "(Empty response)\n";
         }
-        std::cout << std::string(50, '=') << std::endl;
-    } else {
-        auto err = res.error();
-        if (err == httplib::Error::Connection) {
-            std::cout << "Error: Could not connect to the server." << std::endl;
-            std::cout << "Please check your internet connection or try again later." << std::endl;
-        } else if (err == httplib::Error::Read) {
-            std::cout << "Error: Server took too long to respond or connection was interrupted." << std::endl;
-        } else {
-            std::cout << "Error making request: " << httplib::to_string(err) << std::endl;
+        formatter_->endStream();
+        renderTime += std::chrono::steady_clock::now() - renderStarted;
+        if (rendered < received) {
+            *sink_ << "... " << received - rendered << " more bytes not shown, use 'page' to browse the full response\n";
+        }
+        responses_.add(stored);
+        *sink_ << std::string(50, '=') << '\n';
+
+        timing.render = renderTime;
+        timing.transfer = timing.transfer > renderTime ? timing.transfer - renderTime : RequestTiming::Duration(0);
+        if (timing.uploaded > 0) {
+            double seconds = std::chrono::duration<double>(timing.upload).count();
+            *sink_ << "Sent " << timing.uploaded << " bytes";
+            if (timing.uploadedRaw > timing.uploaded) {
+                *sink_ << fmt::format(" (gzip from {} bytes, {:.1f}x)", timing.uploadedRaw,
+                                      static_cast<double>(timing.uploadedRaw) / timing.uploaded);
+            }
+            *sink_ << " in " << RequestTiming::formatDuration(timing.upload)
+                   << fmt::format(" | {:.1f} MB/s", seconds > 0.0 ? timing.uploaded / seconds / (1024.0 * 1024.0) : 0.0)
+                   << '\n';
+        }
+        if (!decodeError.empty()) {
+            *sink_ << "Error: " << decodeError << '\n';
+        }
+        *sink_ << "Received " << received << " bytes";
+        if (decoder) {
+            *sink_ << fmt::format(" ({} {} bytes on the wire, {:.1f}x)", decoder->name(), wire,
+                                  wire > 0 ? static_cast<double>(received) / wire : 0.0);
+        }
+        *sink_ << " | transfer " << RequestTiming::formatDuration(timing.transfer)
+               << " | rendered in " << RequestTiming::formatDuration(timing.render)
+               << " | total " << RequestTiming::formatDuration(timing.network()) << '\n';
+        if (hedge.fired) {
+            *sink_ << "Hedged after " << RequestTiming::formatDuration(hedge.delay) << ", "
+                   << (hedge.won ? "the duplicate" : "the original") << " answered first\n";
         }
+        lastTiming_ = timing;
     }
+
+    if (!res && decodeError.empty()) {
+        printError(res.error());
+    }
+}
+
+JsonRenderLimits HttpService::renderLimits() const {
+    JsonRenderLimits limits;
+    limits.depth = context_->getCollapseDepth();
+    limits.items = context_->getCollapseItems();
+    return limits;
 }
 
-httplib::Client HttpService::prepareClient(const std::string& url, std::string& path) {
+void HttpService::printResponseHead(const httplib::Response& response, const RequestTiming& timing) {
+    *sink_ << "\n" << std::string(50, '=') << '\n';
+    *sink_ << "STATUS: " << response.status << '\n';
+    *sink_ << "TIMING: " << timing.headSummary() << '\n';
+    *sink_ << std::string(50, '=') << '\n';
+
+    *sink_ << "HEADERS:\n";
+    *sink_ << std::string(50, '-') << '\n';
+    for (const auto& [name, value] : response.headers) {
+        *sink_ << "  " << name << ": " << value << '\n';
+    }
+    *sink_ << std::string(50, '=') << '\n';
+
+    *sink_ << "BODY:\n";
+    *sink_ << std::string(50, '-') << '\n';
+}
+
+void HttpService::printError(httplib::Error error) {
+    if (error == httplib::Error::Connection) {
+        *sink_ << "Error: Could not connect to the server.\n";
+        *sink_ << "Please check your internet connection or try again later.\n";
+    } else if (error == httplib::Error::Read) {
+        *sink_ << "Error: Server took too long to respond or connection was interrupted.\n";
+    } else {
+        *sink_ << "Error making request: " << httplib::to_string(error) << '\n';
+    }
+}
+
+std::string HttpService::extractPath(const std::string& url) {
     std::string host = extractHost(url);
 
     size_t pathStart = url.find(host) + host.length();
-    path = url.substr(pathStart);
+    std::string path = url.substr(pathStart);
     if (path.empty()) path = "/";
 
-    httplib::Client client(host);
-    client.set_connection_timeout(context_->getConnectionTimeout());
-    client.set_read_timeout(context_->getReadTimeout());
-    client.set_follow_location(true);
-
-    return client;
+    return path;
 }
 
 std::string HttpService::buildQueryString() {
@@ -209,6 +933,15 @@ std::string HttpService::extractHost(const std::string& url) {
     return host;
 }
 
+std::string HttpService::extractScheme(const std::string& url) {
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+    if (url.find("https://") == 0) {
+        return "https";
+    }
+#endif
+    return "http";
+}
+
 std::string HttpService::buildRequestBody() {
     Json::Value jsonBody;
 
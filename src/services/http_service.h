@@ -1,43 +1,142 @@
-#pragma once
+﻿#pragma once
 
 #include <functional>
+#include <optional>
 #include <httplib.h>
-#include <iostream>
 #include <memory>
 #include <string>
 #include <json/json.h>
+#include "connection_pool.h"
+#include "content_decoder.h"
+#include "content_encoder.h"
+#include "event_stream.h"
+#include "http2_transport.h"
 #include "json_formatter.h"
+#include "json_query.h"
+#include "mapped_file.h"
+#include "multipart_body.h"
+#include "request_hedger.h"
+#include "request_timing.h"
+#include "response_store.h"
 #include "core/context.h"
+#include "core/output_sink.h"
 
 namespace lunarica {
 
+    struct HttpRequest {
+        std::string method;
+        std::string url;
+        std::string scheme;
+        std::string host;
+        std::string path;
+        httplib::Headers headers;
+        std::string body;
+        std::string contentType;
+        std::shared_ptr<MappedFile> bodyFile;
+        std::shared_ptr<MultipartBody> form;
+        bool chunked = false;
+        int compressLevel = 0;
+    };
+
+    struct ResponseHooks {
+        std::function<bool(const httplib::Response&)> onHeaders;
+        std::function<bool(const char*, size_t)> onBody;
+    };
+
     class HttpService {
     public:
-        explicit HttpService(std::shared_ptr<Context> context, std::shared_ptr<JsonFormatter> formatter);
+        explicit HttpService(std::shared_ptr<Context> context,
+                             std::shared_ptr<JsonFormatter> formatter,
+                             std::shared_ptr<OutputSink> sink);
         ~HttpService() = default;
 
         void get(const std::string& path);
         void post(const std::string& path);
         void put(const std::string& path);
         void del(const std::string& path);
+        void upload(const std::string& method, const std::string& path, const std::string& file, bool chunked = false);
+        void uploadForm(const std::string& method, const std::string& path, const std::vector<FormField>& fields);
+        void show(const std::string& reference);
+        void query(const std::string& expression);
+        void stream(const std::string& path, size_t limit = 0);
+
+        HttpRequest prepareRequest(const std::string& method, const std::string& path);
+        httplib::Result send(const HttpRequest& request);
+        httplib::Result send(const HttpRequest& request, const ResponseHooks& hooks);
+
+        static bool methodHasBody(const std::string& method);
 
         std::string extractHost(const std::string& url);
+        std::string extractScheme(const std::string& url);
+
+        ConnectionPool& getConnectionPool() {
+            return connectionPool_;
+        }
+
+        Http2Transport& getHttp2Transport() {
+            return http2_;
+        }
+
+        RequestHedger& getHedger() {
+            return hedger_;
+        }
+
+        const RequestTiming& getLastTiming() const {
+            return lastTiming_;
+        }
+
+        ResponseStore& getResponses() {
+            return responses_;
+        }
+
+        OutputSink& getOutput() {
+            return *sink_;
+        }
 
     private:
         std::shared_ptr<Context> context_;
         std::shared_ptr<JsonFormatter> formatter_;
+        std::shared_ptr<OutputSink> sink_;
+        ConnectionPool connectionPool_;
+        Http2Transport http2_;
+        RequestTiming lastTiming_;
+        ResponseStore responses_;
+        RequestHedger hedger_;
+
+        void makeRequest(const std::string& path, const std::string& method);
+
+        void makeRequestWithBody(const std::string& path, const std::string& method);
+
+        httplib::Result send(const HttpRequest& request, RequestTiming* timing, const ResponseHooks& hooks,
+                             HedgeRace::Leg* leg = nullptr);
+
+        httplib::Result sendHedged(const HttpRequest& request, RequestTiming* timing, const ResponseHooks& hooks,
+                                   HedgeOutcome& outcome);
+
+        bool usesHttp2(const HttpRequest& request) const;
+
+        std::optional<httplib::Result> sendHttp2(const HttpRequest& request, RequestTiming* timing, const ResponseHooks& hooks,
+                                                 size_t redirects = 0);
+
+        HttpRequest redirectRequest(const HttpRequest& request, int status, const std::string& location);
+
+        HttpRequest buildRequest(const std::string& path, const std::string& method);
+
+        void attachBody(HttpRequest& request);
+
+        bool attachFile(HttpRequest& request, const std::string& file, bool chunked);
+
+        void compressBody(HttpRequest& request);
+
+        void streamResponse(HttpRequest& request, bool hedgeable = false);
 
-        void makeRequest(const std::string& path,
-                        const std::string& method,
-                        const std::function<httplib::Result(httplib::Client&, const std::string&, const httplib::Headers&)>& requestFunc);
+        JsonRenderLimits renderLimits() const;
 
-        void makeRequestWithBody(const std::string& path,
-                               const std::string& method,
-                               const std::function<httplib::Result(httplib::Client&, const std::string&, const httplib::Headers&, const std::string&, const std::string&)>& requestFunc);
+        void printResponseHead(const httplib::Response& response, const RequestTiming& timing);
 
-        void processResponse(const httplib::Result& result);
+        void printError(httplib::Error error);
 
-        httplib::Client prepareClient(const std::string& url, std::string& path);
+        std::string extractPath(const std::string& url);
 
         std::string buildQueryString();
 
@@ -0,0 +1,241 @@
+﻿#include "io_uring.h"
+
+#ifdef LUNARICA_IO_URING_SUPPORT
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <linux/time_types.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+namespace lunarica {
+
+namespace {
+
+void* mapRing(int fd, size_t size, unsigned long long offset) {
+    void* ring = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, static_cast<off_t>(offset));
+    return ring == MAP_FAILED ? nullptr : ring;
+}
+
+bool kernelAtLeast(int major, int minor) {
+    utsname name{};
+    int kernelMajor = 0;
+    int kernelMinor = 0;
+    if (uname(&name) != 0 || std::sscanf(name.release, "%d.%d", &kernelMajor, &kernelMinor) != 2) {
+        return false;
+    }
+    return kernelMajor > major || (kernelMajor == major && kernelMinor >= minor);
+}
+
+}
+
+IoUring::~IoUring() {
+    if (buffers_) {
+        munmap(buffers_, buffersSize_);
+    }
+    if (sqes_) {
+        munmap(sqes_, sqesSize_);
+    }
+    if (cqRing_ && cqRing_ != sqRing_) {
+        munmap(cqRing_, cqRingSize_);
+    }
+    if (sqRing_) {
+        munmap(sqRing_, sqRingSize_);
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+bool IoUring::init(unsigned entries, std::string& error) {
+    io_uring_params params{};
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = entries * 4;
+
+    fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd_ < 0) {
+        error = std::string("io_uring_setup: ") + std::strerror(errno);
+        return false;
+    }
+
+    const unsigned required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if ((params.features & required) != required) {
+        error = "io_uring is missing required features";
+        return false;
+    }
+
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    sqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+    sqRing_ = mapRing(fd_, sqRingSize_, IORING_OFF_SQ_RING);
+    cqRing_ = sqRing_;
+    sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(mapRing(fd_, sqesSize_, IORING_OFF_SQES));
+    if (!sqRing_ || !sqes_) {
+        error = std::string("io_uring mmap: ") + std::strerror(errno);
+        return false;
+    }
+
+    auto* sq = static_cast<char*>(sqRing_);
+    sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sqEntries_ = params.sq_entries;
+    sqLocalTail_ = *sqTail_;
+
+    auto* cq = static_cast<char*>(cqRing_);
+    cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+}
+
+io_uring_sqe* IoUring::nextSqe() {
+    if (sqLocalTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= sqEntries_) {
+        if (pending_ == 0 || enter(pending_, 0, 0, nullptr, 0) < 0 ||
+            sqLocalTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= sqEntries_) {
+            return nullptr;
+        }
+    }
+
+    unsigned index = sqLocalTail_ & *sqMask_;
+    sqArray_[index] = index;
+    io_uring_sqe* sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqLocalTail_++;
+    pending_++;
+    return sqe;
+}
+
+int IoUring::submitAndWait(std::chrono::nanoseconds timeout) {
+    __kernel_timespec ts{};
+    io_uring_getevents_arg arg{};
+    arg.sigmask_sz = _NSIG / 8;
+    if (timeout.count() >= 0) {
+        ts.tv_sec = timeout.count() / 1000000000;
+        ts.tv_nsec = timeout.count() % 1000000000;
+        arg.ts = reinterpret_cast<uint64_t>(&ts);
+    }
+
+    while (!deferredRecycles_.empty() && queueRecycle(deferredRecycles_.back())) {
+        deferredRecycles_.pop_back();
+    }
+
+    int result = enter(pending_, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    return result < 0 && (result == -ETIME || result == -EINTR) ? 0 : result;
+}
+
+int IoUring::enter(unsigned submit, unsigned wait, unsigned flags, const void* arg, size_t argSize) {
+    __atomic_store_n(sqTail_, sqLocalTail_, __ATOMIC_RELEASE);
+    long result = syscall(__NR_io_uring_enter, fd_, submit, wait, flags, arg, argSize);
+    if (result < 0) {
+        return -errno;
+    }
+    pending_ -= std::min(pending_, static_cast<unsigned>(result));
+    return static_cast<int>(result);
+}
+
+bool IoUring::provideBuffers(uint16_t group, unsigned count, size_t size, std::string& error) {
+    buffersSize_ = count * size;
+    void* buffers = mmap(nullptr, buffersSize_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffers == MAP_FAILED) {
+        error = std::string("buffer pool mmap: ") + std::strerror(errno);
+        return false;
+    }
+    buffers_ = static_cast<char*>(buffers);
+    bufferSize_ = size;
+    bufferGroup_ = group;
+
+    io_uring_sqe* sqe = nextSqe();
+    if (!sqe) {
+        error = "io_uring submission queue is full";
+        return false;
+    }
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = static_cast<int>(count);
+    sqe->addr = reinterpret_cast<uint64_t>(buffers_);
+    sqe->len = static_cast<uint32_t>(size);
+    sqe->buf_group = group;
+
+    int result = submitAndWait(std::chrono::nanoseconds(-1));
+    drain([&](const io_uring_cqe& cqe) { result = cqe.res; });
+    if (result < 0) {
+        error = std::string("IORING_OP_PROVIDE_BUFFERS: ") + std::strerror(-result);
+        return false;
+    }
+    return true;
+}
+
+void IoUring::recycle(uint16_t id) {
+    // A buffer that is not handed back is lost to the group for good, so one
+    // that finds the submission queue full waits for the next submitAndWait.
+    if (!queueRecycle(id)) {
+        deferredRecycles_.push_back(id);
+    }
+}
+
+bool IoUring::queueRecycle(uint16_t id) {
+    // Rides along with the next io_uring_enter; a completion is only posted
+    // if the kernel refuses the buffer.
+    io_uring_sqe* sqe = nextSqe();
+    if (!sqe) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+    sqe->fd = 1;
+    sqe->addr = reinterpret_cast<uint64_t>(buffer(id));
+    sqe->len = static_cast<uint32_t>(bufferSize_);
+    sqe->buf_group = bufferGroup_;
+    sqe->off = id;
+    return true;
+}
+
+bool IoUring::supported() {
+    static const bool available = [] {
+        if (!kernelAtLeast(6, 0)) {
+            return false;
+        }
+
+        // Some kernels accept the setup but still fail buffer-selected
+        // multishot receives, so probe with a real one.
+        IoUring ring;
+        std::string error;
+        int pair[2];
+        if (!ring.init(8, error) || !ring.provideBuffers(0, 2, 64, error) ||
+            socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) < 0) {
+            return false;
+        }
+
+        bool received = false;
+        io_uring_sqe* sqe = ring.nextSqe();
+        if (sqe && ::write(pair[1], "x", 1) == 1) {
+            sqe->opcode = IORING_OP_RECV;
+            sqe->fd = pair[0];
+            sqe->ioprio = IORING_RECV_MULTISHOT;
+            sqe->flags = IOSQE_BUFFER_SELECT;
+            sqe->buf_group = 0;
+            sqe->user_data = 1;
+            ring.submitAndWait(std::chrono::milliseconds(100));
+            ring.drain([&](const io_uring_cqe& cqe) {
+                received = received || (cqe.res == 1 && (cqe.flags & IORING_CQE_F_BUFFER));
+            });
+        }
+        close(pair[0]);
+        close(pair[1]);
+        return received;
+    }();
+    return available;
+}
+
+}
+
+#endif
@@ -0,0 +1,84 @@
+﻿#pragma once
+
+#ifdef LUNARICA_IO_URING_SUPPORT
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <linux/io_uring.h>
+
+namespace lunarica {
+
+    class IoUring {
+    public:
+        IoUring() = default;
+        ~IoUring();
+
+        IoUring(const IoUring&) = delete;
+        IoUring& operator=(const IoUring&) = delete;
+
+        bool init(unsigned entries, std::string& error);
+
+        io_uring_sqe* nextSqe();
+        int submitAndWait(std::chrono::nanoseconds timeout);
+
+        template <typename Handler>
+        unsigned drain(Handler&& handler) {
+            unsigned head = *cqHead_;
+            unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+            unsigned count = 0;
+            for (; head != tail; ++head, ++count) {
+                handler(cqes_[head & *cqMask_]);
+            }
+            __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+            return count;
+        }
+
+        bool provideBuffers(uint16_t group, unsigned count, size_t size, std::string& error);
+
+        const char* buffer(uint16_t id) const {
+            return buffers_ + static_cast<size_t>(id) * bufferSize_;
+        }
+
+        void recycle(uint16_t id);
+
+        static bool supported();
+
+    private:
+        int fd_ = -1;
+
+        void* sqRing_ = nullptr;
+        size_t sqRingSize_ = 0;
+        void* cqRing_ = nullptr;
+        size_t cqRingSize_ = 0;
+        io_uring_sqe* sqes_ = nullptr;
+        size_t sqesSize_ = 0;
+
+        unsigned* sqHead_ = nullptr;
+        unsigned* sqTail_ = nullptr;
+        unsigned* sqMask_ = nullptr;
+        unsigned* sqArray_ = nullptr;
+        unsigned sqEntries_ = 0;
+        unsigned sqLocalTail_ = 0;
+        unsigned pending_ = 0;
+
+        unsigned* cqHead_ = nullptr;
+        unsigned* cqTail_ = nullptr;
+        unsigned* cqMask_ = nullptr;
+        io_uring_cqe* cqes_ = nullptr;
+
+        char* buffers_ = nullptr;
+        size_t buffersSize_ = 0;
+        size_t bufferSize_ = 0;
+        uint16_t bufferGroup_ = 0;
+        std::vector<uint16_t> deferredRecycles_;
+
+        bool queueRecycle(uint16_t id);
+        int enter(unsigned submit, unsigned wait, unsigned flags, const void* arg, size_t argSize);
+    };
+
+}
+
+#endif
@@ -0,0 +1,110 @@
+﻿#include "json_document_index.h"
+#include "json_structural_index.h"
+
+namespace lunarica {
+
+JsonDocumentIndex::JsonDocumentIndex(std::string_view json)
+    : json_(json) {
+    size_t offset = json_.find_first_not_of(" \t\r\n");
+    if (offset != std::string_view::npos) {
+        root_ = offset;
+    }
+}
+
+size_t JsonDocumentIndex::child(size_t container, const JsonPathStep& step) {
+    if (container >= json_.size() || json_[container] != (step.isIndex ? '[' : '{')) {
+        return npos;
+    }
+
+    const Container& entry = this->container(container);
+    if (step.isIndex) {
+        return step.index < entry.values.size() ? entry.values[step.index] : npos;
+    }
+
+    auto it = entry.keys.find(step.key);
+    return it == entry.keys.end() ? npos : entry.values[it->second];
+}
+
+size_t JsonDocumentIndex::resolve(const std::vector<JsonPathStep>& steps) {
+    size_t offset = root_;
+    for (const auto& step : steps) {
+        if (offset == npos) {
+            break;
+        }
+        offset = child(offset, step);
+    }
+    return offset;
+}
+
+size_t JsonDocumentIndex::childCount(size_t container) {
+    if (container >= json_.size() || (json_[container] != '{' && json_[container] != '[')) {
+        return 0;
+    }
+    return this->container(container).values.size();
+}
+
+std::string_view JsonDocumentIndex::value(size_t offset) {
+    if (offset >= json_.size()) {
+        return {};
+    }
+
+    size_t end = offset;
+    char c = json_[offset];
+    if (c == '{' || c == '[') {
+        end = container(offset).end;
+    } else if (c == '"') {
+        JsonTokenCursor cursor(json_, offset);
+        if (!cursor.next(end) || !cursor.next(end)) {
+            end = npos;
+        }
+    } else {
+        return json_.substr(offset, JsonTokenCursor::scalarEnd(json_, offset) - offset);
+    }
+
+    return end == npos ? json_.substr(offset) : json_.substr(offset, end + 1 - offset);
+}
+
+const JsonDocumentIndex::Container& JsonDocumentIndex::container(size_t offset) {
+    auto it = containers_.find(offset);
+    if (it != containers_.end()) {
+        return it->second;
+    }
+
+    Container& entry = containers_[offset];
+    bool object = json_[offset] == '{';
+
+    JsonTokenCursor cursor(json_, offset);
+    size_t token = 0;
+    cursor.next(token);
+
+    while (cursor.next(token)) {
+        char c = json_[token];
+        if (c == '}' || c == ']') {
+            entry.end = token;
+            break;
+        }
+        if (c == ',') {
+            continue;
+        }
+
+        if (object) {
+            size_t close = 0;
+            size_t colon = 0;
+            if (c != '"' || !cursor.next(close) || !cursor.next(colon) || json_[colon] != ':') {
+                break;
+            }
+            entry.keys.emplace(json_.substr(token + 1, close - token - 1), entry.values.size());
+            if (!cursor.next(token)) {
+                break;
+            }
+        }
+
+        entry.values.push_back(token);
+        if (!cursor.skipValue(token)) {
+            break;
+        }
+    }
+    return entry;
+}
+
+}
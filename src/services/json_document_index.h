@@ -0,0 +1,44 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "json_path.h"
+
+namespace lunarica {
+
+    class JsonDocumentIndex {
+    public:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        explicit JsonDocumentIndex(std::string_view json);
+
+        size_t root() const {
+            return root_;
+        }
+
+        size_t child(size_t container, const JsonPathStep& step);
+        size_t resolve(const std::vector<JsonPathStep>& steps);
+        size_t childCount(size_t container);
+        std::string_view value(size_t offset);
+
+        size_t indexedContainers() const {
+            return containers_.size();
+        }
+
+    private:
+        struct Container {
+            size_t end = npos;
+            std::vector<size_t> values;
+            std::unordered_map<std::string_view, size_t> keys;
+        };
+
+        std::string_view json_;
+        size_t root_ = npos;
+        std::unordered_map<size_t, Container> containers_;
+
+        const Container& container(size_t offset);
+    };
+
+}
@@ -2,237 +2,38 @@
 
 namespace lunarica {
 
-void JsonFormatter::format(const std::string& json) {
-    try {
-        Json::Value parsedJson;
-        Json::CharReaderBuilder builder;
-        builder["collectComments"] = false;
-
-        std::string errs;
-        std::istringstream jsonStream(json);
-        bool parseSuccess = Json::parseFromStream(builder, jsonStream, &parsedJson, &errs);
-
-        if (parseSuccess) {
-            Json::StyledWriter styledWriter;
-            std::string formattedJson = styledWriter.write(parsedJson);
-            highlightAndPrintJson(formattedJson);
-        } else {
-            std::cout << json << std::endl;
-        }
-    } catch (const std::exception&) {
-        std::cout << json << std::endl;
-    }
+JsonFormatter::JsonFormatter(std::shared_ptr<OutputSink> sink)
+    : sink_(std::move(sink)) {
 }
 
-void JsonFormatter::highlightAndPrintJson(const std::string& json) {
-    const std::string COLOR_RESET = "\033[0m";
-    const std::string COLOR_KEY = "\033[38;5;208m";
-    const std::string COLOR_STRING = "\033[1;32m";
-    const std::string COLOR_NUMBER = "\033[1;33m";
-    const std::string COLOR_BOOL = "\033[1;35m";
-    const std::string COLOR_NULL = "\033[1;31m";
-    const std::string COLOR_BRACKET = "\033[1;37m";
-    const std::string COLOR_COMMA = "\033[1;37m";
-    const std::string COLOR_COLON = "\033[1;37m";
-
-    std::string result;
-    bool inString = false;
-    bool escapeNext = false;
-    std::stack<char> brackets;
-    int indentLevel = 0;
-    int terminalWidth = getTerminalWidth();
-
-    for (size_t i = 0; i < json.length(); ++i) {
-        char c = json[i];
-
-        if (inString) {
-            if (escapeNext) {
-                result += c;
-                escapeNext = false;
-                continue;
-            }
-
-            if (c == '\\') {
-                result += c;
-                escapeNext = true;
-                continue;
-            }
-
-            if (c == '"') {
-                inString = false;
-                result += COLOR_STRING + "\"" + COLOR_RESET;
-                continue;
-            }
-
-            result += c;
-            continue;
-        }
-
-        switch (c) {
-            case '"': {
-                inString = true;
-
-                size_t j = i + 1;
-                bool foundClosingQuote = false;
-                bool isKey = false;
-
-                while (j < json.length() && !foundClosingQuote) {
-                    if (json[j] == '\\') {
-                        j += 2;
-                        continue;
-                    }
-
-                    if (json[j] == '"') {
-                        foundClosingQuote = true;
-
-                        size_t k = j + 1;
-                        while (k < json.length() && std::isspace(static_cast<unsigned char>(json[k]))) {
-                            k++;
-                        }
-
-                        if (k < json.length() && json[k] == ':') {
-                            isKey = true;
-                        }
-                    }
-                    j++;
-                }
-
-                result += isKey ? COLOR_KEY + "\"" : COLOR_STRING + "\"";
-                break;
-            }
-            case '{':
-            case '[': {
-                brackets.push(c);
-                indentLevel++;
-                result += COLOR_BRACKET + c + COLOR_RESET + "\n" + std::string(indentLevel * 2, ' ');
-                break;
-            }
-            case '}':
-            case ']': {
-                if (!brackets.empty()) {
-                    brackets.pop();
-                }
-                indentLevel = std::max(0, indentLevel - 1);
-                result += "\n" + std::string(indentLevel * 2, ' ') + COLOR_BRACKET + c + COLOR_RESET;
-                break;
-            }
-            case ':': {
-                result += COLOR_COLON + c + COLOR_RESET + " ";
-                break;
-            }
-            case ',': {
-                result += COLOR_COMMA + c + COLOR_RESET + "\n" + std::string(indentLevel * 2, ' ');
-                break;
-            }
-            case 't':
-            case 'f': {
-                if (i + 3 < json.length() && json.substr(i, 4) == "true") {
-                    result += COLOR_BOOL + "true" + COLOR_RESET;
-                    i += 3;
-                } else if (i + 4 < json.length() && json.substr(i, 5) == "false") {
-                    result += COLOR_BOOL + "false" + COLOR_RESET;
-                    i += 4;
-                } else {
-                    result += c;
-                }
-                break;
-            }
-            case 'n': {
-                if (i + 3 < json.length() && json.substr(i, 4) == "null") {
-                    result += COLOR_NULL + "null" + COLOR_RESET;
-                    i += 3;
-                } else {
-                    result += c;
-                }
-                break;
-            }
-            default: {
-                if (std::isdigit(static_cast<unsigned char>(c)) || c == '-' || c == '+' || c == '.') {
-                    std::string number;
-                    size_t j = i;
-
-                    while (j < json.length() &&
-                           (std::isdigit(static_cast<unsigned char>(json[j])) || json[j] == '-' || json[j] == '+' ||
-                            json[j] == '.' || json[j] == 'e' || json[j] == 'E')) {
-                        number += json[j];
-                        j++;
-                    }
-
-                    if (isNumber(number)) {
-                        result += COLOR_NUMBER + number + COLOR_RESET;
-                        i = j - 1;
-                    } else {
-                        result += c;
-                    }
-                } else if (std::isspace(static_cast<unsigned char>(c))) {
-                    if (c == '\n') {
-                        result += "\n" + std::string(indentLevel * 2, ' ');
-                    }
-                } else {
-                    result += c;
-                }
-                break;
-            }
-        }
-    }
-
-    std::istringstream resultStream(result);
-    std::string line;
-
-    while (std::getline(resultStream, line)) {
-        size_t contentWidth = stripANSI(line).length();
-
-        if (contentWidth > static_cast<size_t>(terminalWidth - 5)) {
-            printWrappedLine(line, countLeadingSpaces(line), terminalWidth);
-        } else {
-            std::cout << line << std::endl;
-        }
-    }
+void JsonFormatter::format(std::string_view json) {
+    JsonStreamRenderer renderer(*sink_, false, getTerminalWidth());
+    renderer.setLimits(limits_);
+    renderer.feed(json.data(), json.size());
+    renderer.finish();
 }
 
-bool JsonFormatter::isNumber(const std::string& s) {
-    if (s.empty()) return false;
-
-    char* end = nullptr;
-    std::strtod(s.c_str(), &end);
-
-    return end != s.c_str() && *end == '\0' &&
-           s.find_first_not_of("-+.eE0123456789") == std::string::npos;
+void JsonFormatter::setLimits(const JsonRenderLimits& limits) {
+    limits_ = limits;
 }
 
-bool JsonFormatter::isValidNumberChar(char c, char prev) {
-    if (std::isdigit(static_cast<unsigned char>(c))) {
-        return true;
-    }
-
-    switch (c) {
-        case '.':
-            return prev != '.';
-        case 'e':
-        case 'E':
-            return true;
-        case '+':
-        case '-':
-            return prev == 'e' || prev == 'E';
-        default:
-            return false;
-    }
+void JsonFormatter::beginStream(const std::string& contentType, size_t window) {
+    bool jsonHint = contentType.find("json") != std::string::npos;
+    stream_ = std::make_unique<JsonStreamRenderer>(*sink_, jsonHint, getTerminalWidth(), window);
+    stream_->setLimits(limits_);
 }
 
-size_t JsonFormatter::countLeadingSpaces(const std::string& s) {
-    size_t count = 0;
-    while (count < s.size() && std::isspace(static_cast<unsigned char>(s[count]))) {
-        count++;
+void JsonFormatter::feed(const char* data, size_t length) {
+    if (stream_) {
+        stream_->feed(data, length);
     }
-    return count;
 }
 
-std::string JsonFormatter::trimLeft(const std::string& s) {
-    size_t start = 0;
-    while (start < s.size() && std::isspace(static_cast<unsigned char>(s[start]))) {
-        start++;
+void JsonFormatter::endStream() {
+    if (stream_) {
+        stream_->finish();
+        stream_.reset();
     }
-    return s.substr(start);
 }
 
 int JsonFormatter::getTerminalWidth() {
@@ -253,57 +54,4 @@ int JsonFormatter::getTerminalWidth() {
 #endif
 }
 
-void JsonFormatter::printWrappedLine(const std::string& line, size_t indent, int maxWidth) {
-    const int indentWidth = static_cast<int>(indent * 2);
-    const int contentWidth = maxWidth - indentWidth - 5;
-
-    size_t pos = 0;
-    while (pos < line.length()) {
-        size_t chunkSize = std::min(static_cast<size_t>(contentWidth), line.length() - pos);
-
-        if (chunkSize < line.length() - pos) {
-            size_t breakPos = pos + chunkSize;
-            while (breakPos > pos && !std::isspace(static_cast<unsigned char>(line[breakPos]))) {
-                breakPos--;
-            }
-
-            if (breakPos == pos) {
-                breakPos = pos + chunkSize;
-            } else {
-                chunkSize = breakPos - pos;
-            }
-        }
-
-        std::cout << std::string(indentWidth, ' ') << line.substr(pos, chunkSize) << std::endl;
-        pos += chunkSize;
-
-        while (pos < line.length() && std::isspace(static_cast<unsigned char>(line[pos]))) {
-            pos++;
-        }
-    }
-}
-
-std::string JsonFormatter::stripANSI(const std::string& input) {
-    std::string result;
-    bool inEscapeCode = false;
-
-    for (char c : input) {
-        if (c == '\033') {
-            inEscapeCode = true;
-            continue;
-        }
-
-        if (inEscapeCode) {
-            if (c == 'm') {
-                inEscapeCode = false;
-            }
-            continue;
-        }
-
-        result += c;
-    }
-
-    return result;
-}
-
 }
\ No newline at end of file
@@ -1,12 +1,10 @@
 ﻿#pragma once
 
-#include <iostream>
-#include <sstream>
+#include <memory>
 #include <string>
-#include <vector>
-#include <stack>
-#include <json/json.h>
-#include <algorithm>
+#include <string_view>
+#include "json_stream_renderer.h"
+#include "core/output_sink.h"
 
 #define NOMINMAX
 
@@ -21,20 +19,26 @@ namespace lunarica {
 
     class JsonFormatter {
     public:
-        JsonFormatter() = default;
+        explicit JsonFormatter(std::shared_ptr<OutputSink> sink);
         ~JsonFormatter() = default;
 
-        void format(const std::string& json);
+        void format(std::string_view json);
+        void setLimits(const JsonRenderLimits& limits);
+
+        void beginStream(const std::string& contentType, size_t window);
+        void feed(const char* data, size_t length);
+        void endStream();
+
+        OutputSink& getSink() {
+            return *sink_;
+        }
 
     private:
-        void highlightAndPrintJson(const std::string& json);
-        bool isNumber(const std::string& s);
-        bool isValidNumberChar(char c, char prev);
-        size_t countLeadingSpaces(const std::string& s);
-        std::string trimLeft(const std::string& s);
+        std::shared_ptr<OutputSink> sink_;
+        std::unique_ptr<JsonStreamRenderer> stream_;
+        JsonRenderLimits limits_;
+
         int getTerminalWidth();
-        void printWrappedLine(const std::string& line, size_t indent, int maxWidth);
-        std::string stripANSI(const std::string& input);
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,250 @@
+﻿#include "json_line_index.h"
+
+#include <algorithm>
+
+namespace lunarica {
+
+namespace {
+
+bool isJsonSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+}
+
+JsonLineIndex::JsonLineIndex(std::string_view body, bool jsonHint)
+    : body_(body),
+      checkpoints_{initialCheckpoint(body, jsonHint)},
+      scanner_(body, checkpoints_.front()) {
+}
+
+JsonLineIndex::Checkpoint JsonLineIndex::initialCheckpoint(std::string_view body, bool jsonHint) {
+    Checkpoint start;
+    while (start.offset < body.size() && isJsonSpace(body[start.offset])) {
+        start.offset++;
+    }
+    start.raw = start.offset == body.size() ||
+                !(jsonHint || body[start.offset] == '{' || body[start.offset] == '[');
+    return start;
+}
+
+void JsonLineIndex::extendToLine(size_t line) {
+    while (!complete_ && scanner_.line() <= line) {
+        step();
+    }
+}
+
+void JsonLineIndex::extendToOffset(size_t offset) {
+    while (!complete_ && scanner_.lineOffset() <= offset) {
+        step();
+    }
+}
+
+void JsonLineIndex::extendAll() {
+    while (!complete_) {
+        step();
+    }
+}
+
+size_t JsonLineIndex::lineCount() const {
+    if (complete_ && scanner_.lineEmpty()) {
+        return scanner_.line();
+    }
+    return scanner_.line() + 1;
+}
+
+size_t JsonLineIndex::lineOffset(size_t line) {
+    extendToLine(line);
+
+    const Checkpoint& start = checkpoint(line);
+    Scanner scanner(body_, start);
+    while (scanner.line() < line && scanner.advance()) {
+    }
+    return scanner.line() == line ? scanner.lineOffset() : body_.size();
+}
+
+size_t JsonLineIndex::lineOfOffset(size_t offset) {
+    extendToOffset(offset);
+
+    auto it = std::upper_bound(checkpoints_.begin(), checkpoints_.end(), offset,
+                               [](size_t value, const Checkpoint& checkpoint) { return value < checkpoint.offset; });
+    if (it != checkpoints_.begin()) {
+        --it;
+    }
+
+    Scanner scanner(body_, *it);
+    size_t line = it->line;
+    while (scanner.advance() && scanner.lineOffset() <= offset) {
+        line = scanner.line();
+    }
+    return line;
+}
+
+const JsonLineIndex::Checkpoint& JsonLineIndex::checkpoint(size_t line) const {
+    return checkpoints_[std::min(line / kCheckpointInterval, checkpoints_.size() - 1)];
+}
+
+void JsonLineIndex::step() {
+    if (!scanner_.advance()) {
+        complete_ = true;
+    } else if (scanner_.line() % kCheckpointInterval == 0) {
+        checkpoints_.push_back(scanner_.checkpoint());
+    }
+}
+
+JsonLineIndex::Scanner::Scanner(std::string_view body, const Checkpoint& start)
+    : body_(body),
+      cursor_(body, start.offset),
+      line_(start.line),
+      lineOffset_(start.offset),
+      lineEmpty_(!start.raw || start.offset == body.size()),
+      raw_(start.raw),
+      rawOffset_(start.offset),
+      state_(start.state) {
+}
+
+JsonLineIndex::Checkpoint JsonLineIndex::Scanner::checkpoint() const {
+    Checkpoint result;
+    result.line = line_;
+    result.offset = lineOffset_;
+    result.raw = raw_;
+    if (!raw_) {
+        result.state = state_;
+    }
+    return result;
+}
+
+bool JsonLineIndex::Scanner::advance() {
+    if (raw_) {
+        return advanceRaw();
+    }
+
+    while (true) {
+        size_t position = 0;
+        if (pending_) {
+            position = pendingPosition_;
+            pending_ = false;
+        } else if (!cursor_.next(position)) {
+            return false;
+        }
+
+        char c = body_[position];
+        if (!lineEmpty_ && startsLine(c)) {
+            pending_ = true;
+            pendingPosition_ = position;
+            line_++;
+            lineOffset_ = position;
+            lineEmpty_ = true;
+            return true;
+        }
+
+        if (!apply(position)) {
+            raw_ = true;
+            rawOffset_ = position;
+            lineEmpty_ = false;
+            return advanceRaw();
+        }
+        lineEmpty_ = false;
+
+        if (c == ',') {
+            line_++;
+            lineOffset_ = position + 1;
+            lineEmpty_ = true;
+            return true;
+        }
+    }
+}
+
+bool JsonLineIndex::Scanner::advanceRaw() {
+    size_t newline = body_.find('\n', rawOffset_);
+    if (newline == std::string_view::npos || newline + 1 >= body_.size()) {
+        rawOffset_ = body_.size();
+        return false;
+    }
+
+    rawOffset_ = newline + 1;
+    line_++;
+    lineOffset_ = rawOffset_;
+    lineEmpty_ = false;
+    return true;
+}
+
+bool JsonLineIndex::Scanner::startsLine(char c) const {
+    switch (c) {
+        case '}':
+        case ']':
+            return !state_.openPending && !state_.containers.empty() &&
+                   state_.containers.back() == (c == '}' ? '{' : '[');
+        case ',':
+        case ':':
+            return false;
+        default:
+            return state_.openPending || (state_.containers.empty() && state_.topLevelDone);
+    }
+}
+
+bool JsonLineIndex::Scanner::apply(size_t position) {
+    char c = body_[position];
+    switch (c) {
+        case '{':
+        case '[':
+            beginValue();
+            state_.containers.push_back(c);
+            state_.openPending = true;
+            state_.expectKey = c == '{';
+            return true;
+        case '}':
+        case ']':
+            if (state_.containers.empty() || state_.containers.back() != (c == '}' ? '{' : '[')) {
+                return false;
+            }
+            state_.containers.pop_back();
+            state_.openPending = false;
+            endValue();
+            return true;
+        case ',':
+            if (state_.containers.empty() || state_.openPending) {
+                return false;
+            }
+            state_.expectKey = state_.containers.back() == '{';
+            return true;
+        case ':':
+            if (state_.containers.empty() || state_.containers.back() != '{') {
+                return false;
+            }
+            state_.expectKey = false;
+            return true;
+        case '"': {
+            beginValue();
+            size_t close = 0;
+            if (cursor_.next(close)) {
+                endValue();
+            }
+            return true;
+        }
+        default: {
+            beginValue();
+            size_t end = JsonTokenCursor::scalarEnd(body_, position);
+            if (!JsonStreamRenderer::isScalar(body_.data() + position, end - position)) {
+                return false;
+            }
+            endValue();
+            return true;
+        }
+    }
+}
+
+void JsonLineIndex::Scanner::beginValue() {
+    state_.openPending = false;
+    if (state_.containers.empty()) {
+        state_.topLevelDone = false;
+    }
+}
+
+void JsonLineIndex::Scanner::endValue() {
+    if (state_.containers.empty()) {
+        state_.topLevelDone = true;
+    }
+}
+
+}
@@ -0,0 +1,90 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+#include "json_stream_renderer.h"
+#include "json_structural_index.h"
+
+namespace lunarica {
+
+    class JsonLineIndex {
+    public:
+        static constexpr size_t kCheckpointInterval = 256;
+
+        struct Checkpoint {
+            size_t line = 0;
+            size_t offset = 0;
+            bool raw = false;
+            JsonRenderState state;
+        };
+
+        JsonLineIndex(std::string_view body, bool jsonHint);
+
+        void extendToLine(size_t line);
+        void extendToOffset(size_t offset);
+        void extendAll();
+
+        bool complete() const {
+            return complete_;
+        }
+
+        size_t lineCount() const;
+        size_t lineOffset(size_t line);
+        size_t lineOfOffset(size_t offset);
+
+        const Checkpoint& checkpoint(size_t line) const;
+
+        std::string_view body() const {
+            return body_;
+        }
+
+    private:
+        class Scanner {
+        public:
+            Scanner(std::string_view body, const Checkpoint& start);
+
+            bool advance();
+            Checkpoint checkpoint() const;
+
+            size_t line() const {
+                return line_;
+            }
+
+            size_t lineOffset() const {
+                return lineOffset_;
+            }
+
+            bool lineEmpty() const {
+                return lineEmpty_;
+            }
+
+        private:
+            std::string_view body_;
+            JsonTokenCursor cursor_;
+            size_t line_;
+            size_t lineOffset_;
+            bool lineEmpty_ = true;
+            bool raw_;
+            size_t rawOffset_;
+            bool pending_ = false;
+            size_t pendingPosition_ = 0;
+            JsonRenderState state_;
+
+            bool advanceRaw();
+            bool startsLine(char c) const;
+            bool apply(size_t position);
+            void beginValue();
+            void endValue();
+        };
+
+        std::string_view body_;
+        std::vector<Checkpoint> checkpoints_;
+        Scanner scanner_;
+        bool complete_ = false;
+
+        static Checkpoint initialCheckpoint(std::string_view body, bool jsonHint);
+        void step();
+    };
+
+}
@@ -0,0 +1,153 @@
+﻿#include "json_path.h"
+
+namespace lunarica {
+
+namespace {
+
+bool isKeyTerminator(char c) {
+    return c == '.' || c == '[';
+}
+
+}
+
+bool JsonPath::parse(std::string_view text, std::vector<JsonPathStep>& steps) {
+    steps.clear();
+    size_t i = 0;
+    if (i < text.size() && text[i] == '$') {
+        i++;
+    }
+
+    bool first = true;
+    while (i < text.size()) {
+        JsonPathStep step;
+        if (text[i] == '[') {
+            size_t close = text.find(']', i);
+            if (close == std::string_view::npos) {
+                return false;
+            }
+            std::string_view inner = text.substr(i + 1, close - i - 1);
+            if (inner.size() >= 2 && inner.front() == '"' && inner.back() == '"') {
+                step.key = std::string(inner.substr(1, inner.size() - 2));
+            } else {
+                if (inner.empty()) {
+                    return false;
+                }
+                for (char c : inner) {
+                    if (c < '0' || c > '9') {
+                        return false;
+                    }
+                    step.index = step.index * 10 + static_cast<size_t>(c - '0');
+                }
+                step.isIndex = true;
+            }
+            i = close + 1;
+        } else {
+            if (text[i] == '.') {
+                i++;
+            } else if (!first) {
+                return false;
+            }
+            size_t end = i;
+            while (end < text.size() && !isKeyTerminator(text[end])) {
+                end++;
+            }
+            if (end == i) {
+                return false;
+            }
+            step.key = std::string(text.substr(i, end - i));
+            i = end;
+        }
+        steps.push_back(std::move(step));
+        first = false;
+    }
+    return true;
+}
+
+size_t JsonPath::find(std::string_view json, const std::vector<JsonPathStep>& steps) {
+    JsonTokenCursor cursor(json);
+    return locate(cursor, steps);
+}
+
+std::string_view JsonPath::extract(std::string_view json, const std::vector<JsonPathStep>& steps) {
+    JsonTokenCursor cursor(json);
+    size_t start = locate(cursor, steps);
+    if (start == npos) {
+        return {};
+    }
+
+    size_t end = start;
+    char c = json[start];
+    if (c == '{' || c == '[' || c == '"') {
+        if (!cursor.skipValue(end)) {
+            return json.substr(start);
+        }
+        end++;
+    } else {
+        end = JsonTokenCursor::scalarEnd(json, start);
+    }
+    return json.substr(start, end - start);
+}
+
+size_t JsonPath::locate(JsonTokenCursor& cursor, const std::vector<JsonPathStep>& steps) {
+    std::string_view json = cursor.text();
+    size_t position = 0;
+    if (!cursor.next(position)) {
+        return npos;
+    }
+
+    for (const auto& step : steps) {
+        if (json[position] != (step.isIndex ? '[' : '{')) {
+            return npos;
+        }
+
+        size_t index = 0;
+        while (true) {
+            size_t token = 0;
+            if (!cursor.next(token) || json[token] == '}' || json[token] == ']') {
+                return npos;
+            }
+
+            bool match = false;
+            if (step.isIndex) {
+                match = index++ == step.index;
+            } else {
+                size_t close = 0;
+                size_t colon = 0;
+                if (json[token] != '"' || !cursor.next(close) || !cursor.next(colon) || json[colon] != ':') {
+                    return npos;
+                }
+                match = json.substr(token + 1, close - token - 1) == step.key;
+                if (!cursor.next(token)) {
+                    return npos;
+                }
+            }
+
+            if (match) {
+                position = token;
+                break;
+            }
+
+            size_t separator = 0;
+            if (!cursor.skipValue(token) || !cursor.next(separator) || json[separator] != ',') {
+                return npos;
+            }
+        }
+    }
+    return position;
+}
+
+std::string JsonPath::toString(const std::vector<JsonPathStep>& steps) {
+    std::string result = "$";
+    for (const auto& step : steps) {
+        if (step.isIndex) {
+            result += "[" + std::to_string(step.index) + "]";
+        } else if (step.key.find_first_of(".[]") != std::string::npos) {
+            result += "[\"" + step.key + "\"]";
+        } else {
+            result += "." + step.key;
+        }
+    }
+    return result;
+}
+
+}
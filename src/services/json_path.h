@@ -0,0 +1,30 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "json_structural_index.h"
+
+namespace lunarica {
+
+    struct JsonPathStep {
+        std::string key;
+        size_t index = 0;
+        bool isIndex = false;
+    };
+
+    class JsonPath {
+    public:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        static bool parse(std::string_view text, std::vector<JsonPathStep>& steps);
+        static size_t find(std::string_view json, const std::vector<JsonPathStep>& steps);
+        static std::string_view extract(std::string_view json, const std::vector<JsonPathStep>& steps);
+        static std::string toString(const std::vector<JsonPathStep>& steps);
+
+    private:
+        static size_t locate(JsonTokenCursor& cursor, const std::vector<JsonPathStep>& steps);
+    };
+
+}
@@ -0,0 +1,519 @@
+﻿#include "json_query.h"
+
+#include <cstdlib>
+
+namespace lunarica {
+
+namespace {
+
+void skipSpace(std::string_view text, size_t& i) {
+    while (i < text.size() && (text[i] == ' ' || text[i] == '\t' || text[i] == '\n' || text[i] == '\r')) {
+        i++;
+    }
+}
+
+bool isIdentChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+bool isIdentStart(char c) {
+    return isIdentChar(c) && !(c >= '0' && c <= '9');
+}
+
+bool keyword(std::string_view text, size_t i, std::string_view word) {
+    return text.substr(i, word.size()) == word &&
+           (i + word.size() == text.size() || !isIdentChar(text[i + word.size()]));
+}
+
+bool consumeValue(JsonTokenCursor& cursor, size_t position, std::string_view& value) {
+    std::string_view json = cursor.text();
+    size_t end = position;
+    if (!cursor.skipValue(end)) {
+        return false;
+    }
+    char c = json[position];
+    if (c == '{' || c == '[' || c == '"') {
+        end++;
+    } else {
+        end = JsonTokenCursor::scalarEnd(json, position);
+    }
+    value = json.substr(position, end - position);
+    return true;
+}
+
+int rank(std::string_view value) {
+    switch (value.empty() ? '\0' : value[0]) {
+        case 'n': return 0;
+        case 'f': return 1;
+        case 't': return 2;
+        case '"': return 4;
+        case '[': return 5;
+        case '{': return 6;
+        default: return 3;
+    }
+}
+
+unsigned parseHex(std::string_view text, size_t i) {
+    unsigned code = 0;
+    for (size_t end = i + 4; i < end && i < text.size(); ++i) {
+        char c = text[i];
+        code <<= 4;
+        if (c >= '0' && c <= '9') {
+            code |= static_cast<unsigned>(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            code |= static_cast<unsigned>(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            code |= static_cast<unsigned>(c - 'A' + 10);
+        }
+    }
+    return code;
+}
+
+void appendUtf8(std::string& out, unsigned code) {
+    if (code < 0x80) {
+        out += static_cast<char>(code);
+    } else if (code < 0x800) {
+        out += static_cast<char>(0xC0 | (code >> 6));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        out += static_cast<char>(0xE0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (code >> 18));
+        out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+}
+
+std::string decodeString(std::string_view quoted) {
+    std::string_view text = quoted.substr(1, quoted.size() - 2);
+    std::string out;
+    out.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] != '\\' || i + 1 == text.size()) {
+            out += text[i];
+            continue;
+        }
+        char c = text[++i];
+        switch (c) {
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'r': out += '\r'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'u': {
+                unsigned code = parseHex(text, i + 1);
+                i += 4;
+                if (code >= 0xD800 && code < 0xDC00 && i + 6 < text.size() && text.substr(i + 1, 2) == "\\u") {
+                    unsigned low = parseHex(text, i + 3);
+                    if (low >= 0xDC00 && low < 0xE000) {
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
+                    }
+                }
+                appendUtf8(out, code);
+                break;
+            }
+            default: out += c;
+        }
+    }
+    return out;
+}
+
+int sign(int value) {
+    return value < 0 ? -1 : (value > 0 ? 1 : 0);
+}
+
+}
+
+bool JsonQuery::parse(std::string_view text) {
+    ops_.clear();
+    conditions_.clear();
+    error_.clear();
+
+    size_t i = 0;
+    while (true) {
+        if (!parseStage(text, i)) {
+            return false;
+        }
+        skipSpace(text, i);
+        if (i == text.size()) {
+            return true;
+        }
+        if (text[i] != '|') {
+            return fail("Expected '|'", i);
+        }
+        i++;
+    }
+}
+
+size_t JsonQuery::run(std::string_view json, const Emit& emit) {
+    size_t count = 0;
+    Emit counted = [&](std::string_view value) {
+        count++;
+        emit(value);
+    };
+
+    JsonTokenCursor cursor(json);
+    size_t position = 0;
+    while (cursor.next(position)) {
+        char c = json[position];
+        if (c == ',' || c == ':' || c == '}' || c == ']') {
+            break;
+        }
+        if (!apply(ops_, 0, cursor, position, counted)) {
+            break;
+        }
+    }
+    return count;
+}
+
+int JsonQuery::compare(std::string_view left, std::string_view right) {
+    int leftRank = rank(left);
+    int rightRank = rank(right);
+    if (leftRank != rightRank) {
+        return leftRank < rightRank ? -1 : 1;
+    }
+
+    if (leftRank == 3) {
+        double a = std::strtod(std::string(left).c_str(), nullptr);
+        double b = std::strtod(std::string(right).c_str(), nullptr);
+        return a < b ? -1 : (a > b ? 1 : 0);
+    }
+    if (leftRank == 4) {
+        // Compare the contents: on the raw tokens the closing quote would sort
+        // "a" after "a b" and "a!".
+        if (left.find('\\') != std::string_view::npos || right.find('\\') != std::string_view::npos) {
+            return sign(decodeString(left).compare(decodeString(right)));
+        }
+        return sign(left.substr(1, left.size() - 2).compare(right.substr(1, right.size() - 2)));
+    }
+    return sign(left.compare(right));
+}
+
+bool JsonQuery::apply(const std::vector<Op>& ops, size_t op, JsonTokenCursor& cursor, size_t position, const Emit& emit) {
+    std::string_view json = cursor.text();
+    if (op == ops.size()) {
+        std::string_view value;
+        if (!consumeValue(cursor, position, value)) {
+            return false;
+        }
+        emit(value);
+        return true;
+    }
+
+    const Op& current = ops[op];
+    if (current.type == OpType::Select) {
+        std::string_view value;
+        if (!consumeValue(cursor, position, value)) {
+            return false;
+        }
+        if (matches(conditions_[current.condition], value)) {
+            JsonTokenCursor inner(value);
+            size_t start = 0;
+            if (inner.next(start)) {
+                apply(ops, op + 1, inner, start, emit);
+            }
+        }
+        return true;
+    }
+
+    char c = json[position];
+    bool object = c == '{';
+    bool array = c == '[';
+    bool accepts = current.type == OpType::Iterate ? (object || array)
+                                                   : (current.type == OpType::Key ? object : array);
+    if (!accepts) {
+        return cursor.skipValue(position);
+    }
+
+    size_t token = 0;
+    if (!cursor.next(token)) {
+        return false;
+    }
+    if (json[token] == '}' || json[token] == ']') {
+        return true;
+    }
+
+    size_t index = 0;
+    while (true) {
+        bool match = current.type == OpType::Iterate;
+        if (object) {
+            size_t close = 0;
+            size_t colon = 0;
+            if (json[token] != '"' || !cursor.next(close) || !cursor.next(colon) || json[colon] != ':') {
+                return false;
+            }
+            match = match || json.substr(token + 1, close - token - 1) == current.key;
+            if (!cursor.next(token)) {
+                return false;
+            }
+        } else {
+            match = match || index == current.index;
+            index++;
+        }
+
+        if (match ? !apply(ops, op + 1, cursor, token, emit) : !cursor.skipValue(token)) {
+            return false;
+        }
+
+        size_t separator = 0;
+        if (!cursor.next(separator)) {
+            return false;
+        }
+        if (json[separator] != ',') {
+            return json[separator] == (object ? '}' : ']');
+        }
+        if (!cursor.next(token)) {
+            return false;
+        }
+    }
+}
+
+bool JsonQuery::matches(const Condition& condition, std::string_view value) {
+    for (const auto& terms : condition.anyOf) {
+        bool all = true;
+        for (const auto& term : terms) {
+            if (!matches(term, value)) {
+                all = false;
+                break;
+            }
+        }
+        if (all) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JsonQuery::matches(const Term& term, std::string_view value) {
+    bool matched = false;
+    bool produced = false;
+    auto test = [&](std::string_view result) {
+        produced = true;
+        if (matched) {
+            return;
+        }
+        if (term.comparison == Comparison::Truthy) {
+            matched = result != "false" && result != "null";
+            return;
+        }
+        int order = compare(result, term.literal);
+        switch (term.comparison) {
+            case Comparison::Equal: matched = order == 0; break;
+            case Comparison::NotEqual: matched = order != 0; break;
+            case Comparison::Less: matched = order < 0; break;
+            case Comparison::LessEqual: matched = order <= 0; break;
+            case Comparison::Greater: matched = order > 0; break;
+            case Comparison::GreaterEqual: matched = order >= 0; break;
+            default: break;
+        }
+    };
+
+    scratch_.reset(value);
+    size_t position = 0;
+    if (scratch_.next(position)) {
+        apply(term.path, 0, scratch_, position, test);
+    }
+
+    bool iterates = false;
+    for (const auto& op : term.path) {
+        iterates = iterates || op.type == OpType::Iterate;
+    }
+    if (!produced && !iterates) {
+        test("null");
+    }
+    return matched;
+}
+
+bool JsonQuery::parseStage(std::string_view text, size_t& i) {
+    skipSpace(text, i);
+    if (!keyword(text, i, "select")) {
+        return parsePath(text, i, ops_);
+    }
+
+    i += 6;
+    skipSpace(text, i);
+    if (i == text.size() || text[i] != '(') {
+        return fail("Expected '(' after select", i);
+    }
+    i++;
+
+    Condition condition;
+    if (!parseCondition(text, i, condition)) {
+        return false;
+    }
+    skipSpace(text, i);
+    if (i == text.size() || text[i] != ')') {
+        return fail("Expected ')'", i);
+    }
+    i++;
+
+    Op op;
+    op.type = OpType::Select;
+    op.condition = conditions_.size();
+    conditions_.push_back(std::move(condition));
+    ops_.push_back(std::move(op));
+    return true;
+}
+
+bool JsonQuery::parsePath(std::string_view text, size_t& i, std::vector<Op>& ops) {
+    skipSpace(text, i);
+    if (i == text.size() || text[i] != '.') {
+        return fail("Expected a path starting with '.'", i);
+    }
+    i++;
+
+    bool afterDot = true;
+    bool first = true;
+    while (i < text.size()) {
+        Op op;
+        char c = text[i];
+        if (afterDot && isIdentStart(c)) {
+            size_t end = i;
+            while (end < text.size() && isIdentChar(text[end])) {
+                end++;
+            }
+            op.type = OpType::Key;
+            op.key = std::string(text.substr(i, end - i));
+            i = end;
+        } else if (c == '[') {
+            i++;
+            skipSpace(text, i);
+            if (i < text.size() && text[i] == ']') {
+                op.type = OpType::Iterate;
+            } else if (i < text.size() && text[i] == '"') {
+                std::string literal;
+                if (!parseLiteral(text, i, literal)) {
+                    return false;
+                }
+                op.type = OpType::Key;
+                op.key = literal.substr(1, literal.size() - 2);
+            } else {
+                size_t start = i;
+                while (i < text.size() && text[i] >= '0' && text[i] <= '9') {
+                    op.index = op.index * 10 + static_cast<size_t>(text[i] - '0');
+                    i++;
+                }
+                if (i == start) {
+                    return fail("Expected an index, a quoted key or ']'", i);
+                }
+                op.type = OpType::Index;
+            }
+            skipSpace(text, i);
+            if (i == text.size() || text[i] != ']') {
+                return fail("Expected ']'", i);
+            }
+            i++;
+        } else if (c == '.' && !afterDot) {
+            i++;
+            afterDot = true;
+            first = false;
+            continue;
+        } else {
+            break;
+        }
+        ops.push_back(std::move(op));
+        afterDot = false;
+        first = false;
+    }
+
+    if (afterDot && !first) {
+        return fail("Expected a key after '.'", i);
+    }
+    return true;
+}
+
+bool JsonQuery::parseCondition(std::string_view text, size_t& i, Condition& condition) {
+    condition.anyOf.emplace_back();
+    while (true) {
+        Term term;
+        if (!parseTerm(text, i, term)) {
+            return false;
+        }
+        condition.anyOf.back().push_back(std::move(term));
+
+        skipSpace(text, i);
+        if (keyword(text, i, "and")) {
+            i += 3;
+        } else if (keyword(text, i, "or")) {
+            i += 2;
+            condition.anyOf.emplace_back();
+        } else {
+            return true;
+        }
+    }
+}
+
+bool JsonQuery::parseTerm(std::string_view text, size_t& i, Term& term) {
+    if (!parsePath(text, i, term.path)) {
+        return false;
+    }
+
+    skipSpace(text, i);
+    std::string_view rest = text.substr(i);
+    if (rest.substr(0, 2) == "==") {
+        term.comparison = Comparison::Equal;
+    } else if (rest.substr(0, 2) == "!=") {
+        term.comparison = Comparison::NotEqual;
+    } else if (rest.substr(0, 2) == "<=") {
+        term.comparison = Comparison::LessEqual;
+    } else if (rest.substr(0, 2) == ">=") {
+        term.comparison = Comparison::GreaterEqual;
+    } else if (rest.substr(0, 1) == "<") {
+        term.comparison = Comparison::Less;
+    } else if (rest.substr(0, 1) == ">") {
+        term.comparison = Comparison::Greater;
+    } else {
+        return true;
+    }
+
+    bool single = term.comparison == Comparison::Less || term.comparison == Comparison::Greater;
+    i += single ? 1 : 2;
+    return parseLiteral(text, i, term.literal);
+}
+
+bool JsonQuery::parseLiteral(std::string_view text, size_t& i, std::string& literal) {
+    skipSpace(text, i);
+    size_t start = i;
+    if (i < text.size() && text[i] == '"') {
+        i++;
+        while (i < text.size() && text[i] != '"') {
+            i += text[i] == '\\' ? 2 : 1;
+        }
+        if (i >= text.size()) {
+            return fail("Unterminated string", start);
+        }
+        i++;
+        literal = std::string(text.substr(start, i - start));
+        return true;
+    }
+
+    for (std::string_view word : {"true", "false", "null"}) {
+        if (keyword(text, i, word)) {
+            i += word.size();
+            literal = std::string(word);
+            return true;
+        }
+    }
+
+    while (i < text.size() && (isIdentChar(text[i]) || text[i] == '-' || text[i] == '+' || text[i] == '.')) {
+        i++;
+    }
+    literal = std::string(text.substr(start, i - start));
+    char* end = nullptr;
+    std::strtod(literal.c_str(), &end);
+    if (literal.empty() || *end != '\0') {
+        return fail("Expected a string, number, true, false or null", start);
+    }
+    return true;
+}
+
+bool JsonQuery::fail(const std::string& message, size_t position) {
+    error_ = message + " at column " + std::to_string(position + 1);
+    return false;
+}
+
+}
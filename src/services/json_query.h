@@ -0,0 +1,63 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "json_structural_index.h"
+
+namespace lunarica {
+
+    class JsonQuery {
+    public:
+        using Emit = std::function<void(std::string_view)>;
+
+        bool parse(std::string_view text);
+        size_t run(std::string_view json, const Emit& emit);
+
+        const std::string& error() const {
+            return error_;
+        }
+
+        static int compare(std::string_view left, std::string_view right);
+
+    private:
+        enum class OpType { Key, Index, Iterate, Select };
+        enum class Comparison { Truthy, Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual };
+
+        struct Op {
+            OpType type = OpType::Iterate;
+            std::string key;
+            size_t index = 0;
+            size_t condition = 0;
+        };
+
+        struct Term {
+            std::vector<Op> path;
+            Comparison comparison = Comparison::Truthy;
+            std::string literal;
+        };
+
+        struct Condition {
+            std::vector<std::vector<Term>> anyOf;
+        };
+
+        std::vector<Op> ops_;
+        std::vector<Condition> conditions_;
+        std::string error_;
+        JsonTokenCursor scratch_{std::string_view()};
+
+        bool apply(const std::vector<Op>& ops, size_t op, JsonTokenCursor& cursor, size_t position, const Emit& emit);
+        bool matches(const Condition& condition, std::string_view value);
+        bool matches(const Term& term, std::string_view value);
+
+        bool parseStage(std::string_view text, size_t& i);
+        bool parsePath(std::string_view text, size_t& i, std::vector<Op>& ops);
+        bool parseCondition(std::string_view text, size_t& i, Condition& condition);
+        bool parseTerm(std::string_view text, size_t& i, Term& term);
+        bool parseLiteral(std::string_view text, size_t& i, std::string& literal);
+        bool fail(const std::string& message, size_t position);
+    };
+
+}
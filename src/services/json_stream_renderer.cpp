@@ -0,0 +1,594 @@
+﻿#include "json_stream_renderer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string_view>
+
+namespace lunarica {
+
+namespace {
+
+constexpr std::string_view COLOR_RESET = "\033[0m";
+constexpr std::string_view COLOR_KEY = "\033[38;5;208m";
+constexpr std::string_view COLOR_STRING = "\033[1;32m";
+constexpr std::string_view COLOR_NUMBER = "\033[1;33m";
+constexpr std::string_view COLOR_BOOL = "\033[1;35m";
+constexpr std::string_view COLOR_NULL = "\033[1;31m";
+constexpr std::string_view COLOR_PUNCT = "\033[1;37m";
+constexpr std::string_view COLOR_SUMMARY = "\033[2;37m";
+constexpr std::string_view ELLIPSIS = "\xE2\x80\xA6";
+
+constexpr size_t kMaxScalarLength = 512;
+constexpr size_t kIndexSlice = 256 * 1024;
+
+bool isJsonSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool isJsonNumber(const char* text, size_t length) {
+    size_t i = 0;
+    if (i < length && text[i] == '-') {
+        i++;
+    }
+    if (i == length) {
+        return false;
+    }
+    if (text[i] == '0') {
+        i++;
+    } else if (isDigit(text[i])) {
+        while (i < length && isDigit(text[i])) {
+            i++;
+        }
+    } else {
+        return false;
+    }
+    if (i < length && text[i] == '.') {
+        size_t start = ++i;
+        while (i < length && isDigit(text[i])) {
+            i++;
+        }
+        if (i == start) {
+            return false;
+        }
+    }
+    if (i < length && (text[i] == 'e' || text[i] == 'E')) {
+        i++;
+        if (i < length && (text[i] == '+' || text[i] == '-')) {
+            i++;
+        }
+        size_t start = i;
+        while (i < length && isDigit(text[i])) {
+            i++;
+        }
+        if (i == start) {
+            return false;
+        }
+    }
+    return i == length;
+}
+
+size_t visibleColumns(const char* text, size_t length) {
+    size_t visible = 0;
+    bool inEscape = false;
+    for (size_t i = 0; i < length; ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c == '\033') {
+            inEscape = true;
+        } else if (inEscape) {
+            inEscape = c != 'm';
+        } else if ((c & 0xC0) != 0x80) {
+            visible++;
+        }
+    }
+    return visible;
+}
+
+size_t offsetOfColumn(const char* text, size_t length, size_t column) {
+    size_t visible = 0;
+    bool inEscape = false;
+    for (size_t i = 0; i < length; ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c == '\033') {
+            inEscape = true;
+        } else if (inEscape) {
+            inEscape = c != 'm';
+        } else if ((c & 0xC0) != 0x80) {
+            if (visible == column) {
+                return i;
+            }
+            visible++;
+        }
+    }
+    return length;
+}
+
+}
+
+JsonStreamRenderer::JsonStreamRenderer(OutputSink& out, bool jsonHint, int terminalWidth, size_t window)
+    : out_(out),
+      jsonHint_(jsonHint),
+      lineLimit_(terminalWidth > 0 ? static_cast<size_t>(std::max(20, terminalWidth - 5))
+                                   : std::numeric_limits<size_t>::max() / 2),
+      window_(std::max<size_t>(window, 1024)) {
+    containers_.reserve(32);
+    counts_.reserve(32);
+    buffer_.append(window_ + 4096, ' ');
+    buffer_.truncate(0);
+}
+
+void JsonStreamRenderer::feed(const char* data, size_t length) {
+    if (mode_ == Mode::Detect) {
+        size_t start = 0;
+        while (start < length && isJsonSpace(data[start])) {
+            start++;
+        }
+        if (start == length) {
+            return;
+        }
+
+        char first = data[start];
+        mode_ = (jsonHint_ || first == '{' || first == '[') ? Mode::Json : Mode::Raw;
+        data += start;
+        length -= start;
+    }
+
+    while (length > 0 && mode_ == Mode::Json) {
+        size_t slice = std::min(length, kIndexSlice);
+        consumeJson(data, slice);
+        data += slice;
+        length -= slice;
+    }
+
+    if (mode_ == Mode::Raw) {
+        consumeRaw(data, length);
+    }
+    flush(mode_ == Mode::Raw);
+}
+
+void JsonStreamRenderer::finish() {
+    if (mode_ == Mode::Json && skip_ != Skip::None) {
+        skip_ = Skip::None;
+        buffer_.append(COLOR_SUMMARY);
+        appendText(ELLIPSIS.data(), ELLIPSIS.size());
+        buffer_.append(COLOR_RESET);
+    } else if (mode_ == Mode::Json) {
+        if (!scalar_.empty() && !flushScalar(scalar_.data(), scalar_.size())) {
+            fail();
+        } else if (inString_) {
+            buffer_.append(COLOR_RESET);
+        }
+    }
+
+    char last = buffer_.size() == 0 ? lastWritten_ : buffer_.back();
+    if (last != '\n' && (lineHasContent_ || mode_ == Mode::Raw)) {
+        buffer_.push('\n');
+    } else if (mode_ == Mode::Json && !lineHasContent_) {
+        buffer_.truncate(lineStart_);
+    }
+
+    flush(true);
+}
+
+void JsonStreamRenderer::resume(const JsonRenderState& state) {
+    mode_ = Mode::Json;
+    containers_ = state.containers;
+    expectKey_ = state.expectKey;
+    openPending_ = state.openPending;
+    topLevelDone_ = state.topLevelDone;
+    counts_.assign(containers_.size(), 0);
+    newLine(containers_.size() * 2);
+}
+
+void JsonStreamRenderer::setLimits(const JsonRenderLimits& limits) {
+    limits_ = limits;
+}
+
+bool JsonStreamRenderer::isScalar(const char* text, size_t length) {
+    return (length == 4 && (std::memcmp(text, "true", 4) == 0 || std::memcmp(text, "null", 4) == 0)) ||
+           (length == 5 && std::memcmp(text, "false", 5) == 0) ||
+           isJsonNumber(text, length);
+}
+
+void JsonStreamRenderer::consumeJson(const char* data, size_t length) {
+    indexer_.index(data, length, positions_);
+
+    size_t i = 0;
+    if (!scalar_.empty()) {
+        size_t end = 0;
+        while (end < length && !isJsonSpace(data[end]) && (positions_.empty() || end < positions_[0])) {
+            end++;
+        }
+        scalar_.append(data, end);
+        if (end == length) {
+            if (scalar_.size() > kMaxScalarLength) {
+                fail();
+            }
+            return;
+        }
+        if (!flushScalar(scalar_.data(), scalar_.size())) {
+            fail();
+            consumeRaw(data + end, length - end);
+            return;
+        }
+        i = end;
+    }
+
+    for (size_t k = 0; k < positions_.size(); ++k) {
+        size_t position = positions_[k];
+        char c = data[position];
+
+        if (inString_) {
+            appendStringSpan(data + i, position - i);
+            buffer_.push('"');
+            buffer_.append(COLOR_RESET);
+            if (++lineWidth_ > lineLimit_) {
+                wrapLine();
+            }
+            inString_ = false;
+            endValue();
+            i = position + 1;
+            continue;
+        }
+
+        if (skip_ != Skip::None) {
+            skipToken(c);
+            i = position + 1;
+            continue;
+        }
+
+        bool ok = true;
+        switch (c) {
+            case '{':
+            case '[':
+                beginValue();
+                if (limits_.depth > 0 && containers_.size() >= limits_.depth) {
+                    beginSkip(Skip::Collapse, c);
+                    break;
+                }
+                appendPunct(c);
+                containers_.push_back(c);
+                counts_.push_back(0);
+                openPending_ = true;
+                expectKey_ = c == '{';
+                break;
+            case '}':
+            case ']':
+                ok = closeContainer(c);
+                break;
+            case ',':
+                if (containers_.empty() || openPending_) {
+                    ok = false;
+                    break;
+                }
+                appendPunct(c);
+                newLine(containers_.size() * 2);
+                expectKey_ = containers_.back() == '{';
+                if (limits_.items > 0 && ++counts_.back() >= limits_.items) {
+                    beginSkip(Skip::Elide, containers_.back());
+                }
+                break;
+            case ':':
+                if (containers_.empty() || containers_.back() != '{') {
+                    ok = false;
+                    break;
+                }
+                appendPunct(c);
+                buffer_.push(' ');
+                lineWidth_++;
+                expectKey_ = false;
+                break;
+            case '"':
+                beginValue();
+                buffer_.append((!containers_.empty() && containers_.back() == '{' && expectKey_) ? COLOR_KEY : COLOR_STRING);
+                buffer_.push('"');
+                lineWidth_++;
+                lineHasContent_ = true;
+                inString_ = true;
+                break;
+            default: {
+                beginValue();
+                size_t next = k + 1 < positions_.size() ? positions_[k + 1] : length;
+                size_t end = position;
+                while (end < next && !isJsonSpace(data[end])) {
+                    end++;
+                }
+                if (end == length) {
+                    scalar_.assign(data + position, end - position);
+                    return;
+                }
+                ok = flushScalar(data + position, end - position);
+                break;
+            }
+        }
+
+        if (!ok) {
+            fail();
+            consumeRaw(data + position, length - position);
+            return;
+        }
+        i = position + 1;
+
+        if (buffer_.size() >= window_) {
+            flush(false);
+        }
+    }
+
+    if (inString_) {
+        appendStringSpan(data + i, length - i);
+    }
+}
+
+void JsonStreamRenderer::appendStringSpan(const char* data, size_t length) {
+    if (lineWidth_ + length <= lineLimit_) {
+        size_t visible = 0;
+        for (size_t i = 0; i < length; ++i) {
+            visible += (static_cast<unsigned char>(data[i]) & 0xC0) != 0x80;
+        }
+        buffer_.append(data, length);
+        lineWidth_ += visible;
+        lineHasContent_ = true;
+        return;
+    }
+
+    while (length > 0) {
+        size_t room = lineLimit_ > lineWidth_ ? lineLimit_ - lineWidth_ : 0;
+        size_t visible = 0;
+        size_t end = 0;
+        while (end < length) {
+            if ((static_cast<unsigned char>(data[end]) & 0xC0) != 0x80) {
+                if (visible == room) {
+                    break;
+                }
+                visible++;
+            }
+            end++;
+        }
+
+        if (end == 0) {
+            breakLine(buffer_.size() - lineStart_);
+            continue;
+        } else {
+            buffer_.append(data, end);
+            lineWidth_ += visible;
+            lineHasContent_ = true;
+        }
+        data += end;
+        length -= end;
+
+        if (buffer_.size() >= window_) {
+            flush(false);
+        }
+    }
+}
+
+void JsonStreamRenderer::consumeRaw(const char* data, size_t length) {
+    buffer_.append(data, length);
+    if (buffer_.size() >= window_) {
+        flush(true);
+    }
+}
+
+void JsonStreamRenderer::fail() {
+    if (inString_) {
+        buffer_.append(COLOR_RESET);
+        inString_ = false;
+    }
+    buffer_.append(scalar_.data(), scalar_.size());
+    scalar_.clear();
+    mode_ = Mode::Raw;
+}
+
+bool JsonStreamRenderer::closeContainer(char c) {
+    if (containers_.empty() || containers_.back() != (c == '}' ? '{' : '[')) {
+        return false;
+    }
+    containers_.pop_back();
+    counts_.pop_back();
+    if (openPending_) {
+        openPending_ = false;
+    } else {
+        newLine(containers_.size() * 2);
+    }
+    appendPunct(c);
+    endValue();
+    return true;
+}
+
+void JsonStreamRenderer::beginSkip(Skip skip, char open) {
+    skip_ = skip;
+    skipOpen_ = open;
+    skipDepth_ = 1;
+    skipCount_ = 0;
+    skipEmpty_ = true;
+}
+
+void JsonStreamRenderer::skipToken(char c) {
+    switch (c) {
+        case '{':
+        case '[':
+            if (skipDepth_ == 1) {
+                skipEmpty_ = false;
+            }
+            skipDepth_++;
+            break;
+        case '}':
+        case ']':
+            if (--skipDepth_ == 0) {
+                finishSkip(c);
+            }
+            break;
+        case ',':
+            if (skipDepth_ == 1) {
+                skipCount_++;
+            }
+            break;
+        case ':':
+            break;
+        default:
+            if (skipDepth_ == 1) {
+                skipEmpty_ = false;
+            }
+            break;
+    }
+}
+
+void JsonStreamRenderer::finishSkip(char c) {
+    size_t count = skipEmpty_ ? 0 : skipCount_ + 1;
+    Skip skip = skip_;
+    skip_ = Skip::None;
+
+    const char* noun = skipOpen_ == '{' ? (count == 1 ? " key" : " keys") : (count == 1 ? " item" : " items");
+    std::string summary = std::to_string(count) + noun;
+
+    if (skip == Skip::Collapse) {
+        appendPunct(skipOpen_);
+        if (count > 0) {
+            buffer_.append(COLOR_SUMMARY);
+            appendText(ELLIPSIS.data(), ELLIPSIS.size());
+            appendText(summary.data(), summary.size());
+            buffer_.append(COLOR_RESET);
+        }
+        appendPunct(c);
+        endValue();
+        return;
+    }
+
+    if (count > 0) {
+        summary = std::string(ELLIPSIS) + std::to_string(count) + " more" + noun;
+        buffer_.append(COLOR_SUMMARY);
+        appendText(summary.data(), summary.size());
+        buffer_.append(COLOR_RESET);
+    }
+    closeContainer(c);
+}
+
+void JsonStreamRenderer::beginValue() {
+    if (openPending_) {
+        openPending_ = false;
+        newLine(containers_.size() * 2);
+    } else if (containers_.empty() && topLevelDone_) {
+        newLine(0);
+        topLevelDone_ = false;
+    }
+}
+
+void JsonStreamRenderer::endValue() {
+    if (containers_.empty()) {
+        topLevelDone_ = true;
+    }
+}
+
+bool JsonStreamRenderer::flushScalar(const char* text, size_t length) {
+    std::string_view color;
+    if ((length == 4 && std::memcmp(text, "true", 4) == 0) || (length == 5 && std::memcmp(text, "false", 5) == 0)) {
+        color = COLOR_BOOL;
+    } else if (length == 4 && std::memcmp(text, "null", 4) == 0) {
+        color = COLOR_NULL;
+    } else if (isJsonNumber(text, length)) {
+        color = COLOR_NUMBER;
+    } else {
+        return false;
+    }
+
+    buffer_.append(color);
+    buffer_.append(text, length);
+    buffer_.append(COLOR_RESET);
+    lineWidth_ += length;
+    lineHasContent_ = true;
+    scalar_.clear();
+    if (lineWidth_ > lineLimit_) {
+        wrapLine();
+    }
+    endValue();
+    return true;
+}
+
+void JsonStreamRenderer::appendPunct(char c) {
+    buffer_.append(COLOR_PUNCT);
+    buffer_.push(c);
+    buffer_.append(COLOR_RESET);
+    lineHasContent_ = true;
+
+    if (++lineWidth_ > lineLimit_) {
+        wrapLine();
+    }
+}
+
+void JsonStreamRenderer::appendText(const char* text, size_t length) {
+    buffer_.append(text, length);
+    lineWidth_ += visibleColumns(text, length);
+    lineHasContent_ = true;
+
+    if (lineWidth_ > lineLimit_) {
+        wrapLine();
+    }
+}
+
+void JsonStreamRenderer::newLine(size_t indent) {
+    if (lineHasContent_) {
+        buffer_.push('\n');
+    } else {
+        buffer_.truncate(lineStart_);
+    }
+    lineStart_ = buffer_.size();
+    buffer_.append(indent, ' ');
+    lineWidth_ = indent;
+    lineIndent_ = indent;
+    lineHasContent_ = false;
+}
+
+void JsonStreamRenderer::wrapLine() {
+    while (lineWidth_ > lineLimit_) {
+        const char* line = buffer_.data() + lineStart_;
+        breakLine(offsetOfColumn(line, buffer_.size() - lineStart_, lineLimit_));
+    }
+}
+
+void JsonStreamRenderer::breakLine(size_t limit) {
+    const char* line = buffer_.data() + lineStart_;
+    size_t lineLength = buffer_.size() - lineStart_;
+
+    size_t firstContent = 0;
+    while (firstContent < lineLength && line[firstContent] == ' ') {
+        firstContent++;
+    }
+    size_t breakAt = std::min(limit, lineLength - 1);
+    while (breakAt > firstContent && line[breakAt] != ' ') {
+        breakAt--;
+    }
+
+    if (breakAt > firstContent) {
+        wrapRest_.assign(line + breakAt + 1, lineLength - breakAt - 1);
+        buffer_.truncate(lineStart_ + breakAt);
+    } else {
+        wrapRest_.assign(line + limit, lineLength - limit);
+        buffer_.truncate(lineStart_ + limit);
+    }
+
+    size_t continuation = std::min(lineIndent_ + 2, lineLimit_ / 2);
+    buffer_.push('\n');
+    lineStart_ = buffer_.size();
+    buffer_.append(continuation, ' ');
+    buffer_.append(wrapRest_.data(), wrapRest_.size());
+    lineWidth_ = continuation + visibleColumns(wrapRest_.data(), wrapRest_.size());
+    lineHasContent_ = !wrapRest_.empty();
+}
+
+void JsonStreamRenderer::flush(bool everything) {
+    size_t end = (everything || mode_ == Mode::Raw) ? buffer_.size() : lineStart_;
+    if (end == 0) {
+        return;
+    }
+
+    out_.write(buffer_.data(), end);
+    lastWritten_ = buffer_.data()[end - 1];
+    buffer_.consume(end);
+    lineStart_ -= std::min(lineStart_, end);
+}
+
+}
@@ -0,0 +1,156 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "json_structural_index.h"
+#include "core/output_sink.h"
+
+namespace lunarica {
+
+    struct JsonRenderLimits {
+        size_t depth = 0;
+        size_t items = 0;
+    };
+
+    struct JsonRenderState {
+        std::vector<char> containers;
+        bool expectKey = false;
+        bool openPending = false;
+        bool topLevelDone = false;
+    };
+
+    class JsonStreamRenderer {
+    public:
+        static constexpr size_t kDefaultWindow = 64 * 1024;
+
+        JsonStreamRenderer(OutputSink& out, bool jsonHint, int terminalWidth, size_t window = kDefaultWindow);
+        ~JsonStreamRenderer() = default;
+
+        void feed(const char* data, size_t length);
+        void finish();
+        void resume(const JsonRenderState& state);
+        void setLimits(const JsonRenderLimits& limits);
+
+        static bool isScalar(const char* text, size_t length);
+
+        bool isRaw() const {
+            return mode_ == Mode::Raw;
+        }
+
+    private:
+        enum class Mode { Detect, Json, Raw };
+        enum class Skip { None, Collapse, Elide };
+
+        class RenderBuffer {
+        public:
+            void append(const char* data, size_t length) {
+                reserve(length);
+                std::memcpy(&storage_[size_], data, length);
+                size_ += length;
+            }
+
+            void append(std::string_view text) {
+                append(text.data(), text.size());
+            }
+
+            void append(size_t count, char c) {
+                reserve(count);
+                std::memset(&storage_[size_], c, count);
+                size_ += count;
+            }
+
+            void push(char c) {
+                reserve(1);
+                storage_[size_++] = c;
+            }
+
+            void truncate(size_t length) {
+                size_ = length;
+            }
+
+            void consume(size_t length) {
+                std::memmove(&storage_[0], &storage_[length], size_ - length);
+                size_ -= length;
+            }
+
+            const char* data() const {
+                return storage_.data();
+            }
+
+            size_t size() const {
+                return size_;
+            }
+
+            char back() const {
+                return storage_[size_ - 1];
+            }
+
+        private:
+            std::string storage_;
+            size_t size_ = 0;
+
+            void reserve(size_t extra) {
+                if (size_ + extra > storage_.size()) {
+                    storage_.resize(std::max(storage_.size() * 2, size_ + extra));
+                }
+            }
+        };
+
+        OutputSink& out_;
+        bool jsonHint_;
+        size_t lineLimit_;
+        size_t window_;
+        Mode mode_ = Mode::Detect;
+
+        JsonStructuralIndexer indexer_;
+        std::vector<uint32_t> positions_;
+        std::vector<char> containers_;
+        bool expectKey_ = false;
+        bool openPending_ = false;
+        bool topLevelDone_ = false;
+        bool inString_ = false;
+        std::string scalar_;
+
+        JsonRenderLimits limits_;
+        std::vector<size_t> counts_;
+        Skip skip_ = Skip::None;
+        size_t skipDepth_ = 0;
+        size_t skipCount_ = 0;
+        bool skipEmpty_ = true;
+        char skipOpen_ = 0;
+
+        RenderBuffer buffer_;
+        size_t lineStart_ = 0;
+        size_t lineWidth_ = 0;
+        size_t lineIndent_ = 0;
+        bool lineHasContent_ = false;
+        char lastWritten_ = '\n';
+        std::string wrapRest_;
+
+        void consumeJson(const char* data, size_t length);
+        void appendStringSpan(const char* data, size_t length);
+        void consumeRaw(const char* data, size_t length);
+        void fail();
+
+        bool closeContainer(char c);
+        void beginSkip(Skip skip, char open);
+        void skipToken(char c);
+        void finishSkip(char c);
+
+        void beginValue();
+        void endValue();
+        bool flushScalar(const char* text, size_t length);
+
+        void appendPunct(char c);
+        void appendText(const char* text, size_t length);
+        void newLine(size_t indent);
+        void wrapLine();
+        void breakLine(size_t limit);
+        void flush(bool everything);
+    };
+
+}
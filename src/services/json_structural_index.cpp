@@ -0,0 +1,295 @@
+﻿#include "json_structural_index.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define LUNARICA_X86_64 1
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace lunarica {
+
+namespace {
+
+int countTrailingZeros(uint64_t value) {
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward64(&index, value);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+uint64_t prefixXor(uint64_t bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+uint64_t escapedCharacters(uint64_t backslash, uint64_t& carry) {
+    constexpr uint64_t evenBits = 0x5555555555555555ULL;
+
+    backslash &= ~carry;
+    uint64_t followsEscape = (backslash << 1) | carry;
+    uint64_t oddSequenceStarts = backslash & ~evenBits & ~followsEscape;
+    uint64_t sequencesStartingOnEvenBits = oddSequenceStarts + backslash;
+    carry = sequencesStartingOnEvenBits < oddSequenceStarts ? 1 : 0;
+    uint64_t invertMask = sequencesStartingOnEvenBits << 1;
+    return (evenBits ^ invertMask) & followsEscape;
+}
+
+void classifyScalar(const char* block, uint64_t& quote, uint64_t& backslash, uint64_t& op, uint64_t& whitespace) {
+    for (size_t i = 0; i < JsonStructuralIndexer::kBlockSize; ++i) {
+        uint64_t bit = uint64_t(1) << i;
+        switch (block[i]) {
+            case '"': quote |= bit; break;
+            case '\\': backslash |= bit; break;
+            case '{': case '}': case '[': case ']': case ':': case ',': op |= bit; break;
+            case ' ': case '\t': case '\n': case '\r': whitespace |= bit; break;
+            default: break;
+        }
+    }
+}
+
+#ifdef LUNARICA_X86_64
+void classifySse2(const char* block, uint64_t& quote, uint64_t& backslash, uint64_t& op, uint64_t& whitespace) {
+    const __m128i quoteChar = _mm_set1_epi8('"');
+    const __m128i backslashChar = _mm_set1_epi8('\\');
+    const __m128i lowerCase = _mm_set1_epi8(0x20);
+    const __m128i openBrace = _mm_set1_epi8('{');
+    const __m128i closeBrace = _mm_set1_epi8('}');
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i carriageReturn = _mm_set1_epi8('\r');
+
+    for (int part = 0; part < 4; ++part) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + part * 16));
+        __m128i folded = _mm_or_si128(chunk, lowerCase);
+        __m128i ops = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, openBrace), _mm_cmpeq_epi8(folded, closeBrace)),
+                                   _mm_or_si128(_mm_cmpeq_epi8(chunk, colon), _mm_cmpeq_epi8(chunk, comma)));
+        __m128i spaces = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, tab)),
+                                      _mm_or_si128(_mm_cmpeq_epi8(chunk, newline), _mm_cmpeq_epi8(chunk, carriageReturn)));
+
+        int shift = part * 16;
+        quote |= uint64_t(uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quoteChar)))) << shift;
+        backslash |= uint64_t(uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, backslashChar)))) << shift;
+        op |= uint64_t(uint32_t(_mm_movemask_epi8(ops))) << shift;
+        whitespace |= uint64_t(uint32_t(_mm_movemask_epi8(spaces))) << shift;
+    }
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("avx2")))
+#endif
+void classifyAvx2(const char* block, uint64_t& quote, uint64_t& backslash, uint64_t& op, uint64_t& whitespace) {
+    const __m256i quoteChar = _mm256_set1_epi8('"');
+    const __m256i backslashChar = _mm256_set1_epi8('\\');
+    const __m256i lowerCase = _mm256_set1_epi8(0x20);
+    const __m256i openBrace = _mm256_set1_epi8('{');
+    const __m256i closeBrace = _mm256_set1_epi8('}');
+    const __m256i colon = _mm256_set1_epi8(':');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i carriageReturn = _mm256_set1_epi8('\r');
+
+    for (int part = 0; part < 2; ++part) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + part * 32));
+        __m256i folded = _mm256_or_si256(chunk, lowerCase);
+        __m256i ops = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(folded, openBrace), _mm256_cmpeq_epi8(folded, closeBrace)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, colon), _mm256_cmpeq_epi8(chunk, comma)));
+        __m256i spaces = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, space), _mm256_cmpeq_epi8(chunk, tab)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, newline), _mm256_cmpeq_epi8(chunk, carriageReturn)));
+
+        int shift = part * 32;
+        quote |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, quoteChar)))) << shift;
+        backslash |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, backslashChar)))) << shift;
+        op |= uint64_t(uint32_t(_mm256_movemask_epi8(ops))) << shift;
+        whitespace |= uint64_t(uint32_t(_mm256_movemask_epi8(spaces))) << shift;
+    }
+}
+#endif
+
+}
+
+JsonStructuralIndexer::JsonStructuralIndexer(Backend backend) : backend_(backend) {
+    Backend supported = detectBackend();
+    if (static_cast<int>(backend_) > static_cast<int>(supported)) {
+        backend_ = supported;
+    }
+}
+
+JsonStructuralIndexer::Backend JsonStructuralIndexer::detectBackend() {
+#if defined(LUNARICA_X86_64) && (defined(__GNUC__) || defined(__clang__))
+    if (__builtin_cpu_supports("avx2")) {
+        return Backend::Avx2;
+    }
+    return Backend::Sse2;
+#elif defined(LUNARICA_X86_64)
+    return Backend::Sse2;
+#else
+    return Backend::Scalar;
+#endif
+}
+
+const char* JsonStructuralIndexer::backendName(Backend backend) {
+    switch (backend) {
+        case Backend::Avx2: return "avx2";
+        case Backend::Sse2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+void JsonStructuralIndexer::reset() {
+    escapeCarry_ = 0;
+    inStringCarry_ = 0;
+    scalarCarry_ = 0;
+}
+
+void JsonStructuralIndexer::index(const char* data, size_t length, std::vector<uint32_t>& positions) {
+    positions.clear();
+
+    for (size_t offset = 0; offset < length; offset += kBlockSize) {
+        size_t valid = length - offset < kBlockSize ? length - offset : kBlockSize;
+        const char* block = data + offset;
+
+        char padded[kBlockSize];
+        if (valid < kBlockSize) {
+            std::memset(padded, ' ', kBlockSize);
+            std::memcpy(padded, block, valid);
+            block = padded;
+        }
+
+        BlockMasks masks;
+        classify(block, masks);
+        uint64_t structural = indexBlock(masks, valid);
+
+        while (structural != 0) {
+            positions.push_back(static_cast<uint32_t>(offset + countTrailingZeros(structural)));
+            structural &= structural - 1;
+        }
+    }
+}
+
+void JsonStructuralIndexer::classify(const char* block, BlockMasks& masks) const {
+#ifdef LUNARICA_X86_64
+    if (backend_ == Backend::Avx2) {
+        classifyAvx2(block, masks.quote, masks.backslash, masks.op, masks.whitespace);
+        return;
+    }
+    if (backend_ == Backend::Sse2) {
+        classifySse2(block, masks.quote, masks.backslash, masks.op, masks.whitespace);
+        return;
+    }
+#endif
+    classifyScalar(block, masks.quote, masks.backslash, masks.op, masks.whitespace);
+}
+
+uint64_t JsonStructuralIndexer::indexBlock(const BlockMasks& masks, size_t valid) {
+    uint64_t escapeCarry = escapeCarry_;
+    uint64_t escaped = escapedCharacters(masks.backslash, escapeCarry);
+    uint64_t quotes = masks.quote & ~escaped;
+
+    uint64_t inString = prefixXor(quotes) ^ inStringCarry_;
+    uint64_t outside = ~inString & ~quotes;
+    uint64_t ops = masks.op & outside;
+    uint64_t scalar = ~(masks.op | masks.whitespace | masks.quote) & outside;
+    uint64_t scalarStarts = scalar & ~((scalar << 1) | scalarCarry_);
+
+    if (valid == kBlockSize) {
+        escapeCarry_ = escapeCarry;
+        inStringCarry_ = uint64_t(static_cast<int64_t>(inString) >> 63);
+        scalarCarry_ = scalar >> 63;
+    } else {
+        uint64_t validMask = (uint64_t(1) << valid) - 1;
+        escapeCarry_ = (escaped >> valid) & 1;
+        inStringCarry_ = ((inString >> (valid - 1)) & 1) ? ~uint64_t(0) : 0;
+        scalarCarry_ = (scalar >> (valid - 1)) & 1;
+        quotes &= validMask;
+        ops &= validMask;
+        scalarStarts &= validMask;
+    }
+
+    return quotes | ops | scalarStarts;
+}
+
+JsonTokenCursor::JsonTokenCursor(std::string_view text, size_t offset)
+    : text_(text),
+      indexed_(std::min(offset, text.size())) {
+}
+
+void JsonTokenCursor::reset(std::string_view text, size_t offset) {
+    text_ = text;
+    indexed_ = std::min(offset, text.size());
+    base_ = 0;
+    cursor_ = 0;
+    positions_.clear();
+    indexer_.reset();
+}
+
+bool JsonTokenCursor::refill() {
+    while (cursor_ == positions_.size()) {
+        if (indexed_ == text_.size()) {
+            return false;
+        }
+        size_t slice = std::min(kSlice, text_.size() - indexed_);
+        indexer_.index(text_.data() + indexed_, slice, positions_);
+        base_ = indexed_;
+        indexed_ += slice;
+        cursor_ = 0;
+    }
+    return true;
+}
+
+size_t JsonTokenCursor::scalarEnd(std::string_view text, size_t position) {
+    while (position < text.size()) {
+        switch (text[position]) {
+            case ' ': case '\t': case '\n': case '\r':
+            case '{': case '}': case '[': case ']':
+            case ',': case ':': case '"':
+                return position;
+            default:
+                position++;
+        }
+    }
+    return position;
+}
+
+bool JsonTokenCursor::skipValue(size_t& position) {
+    char c = text_[position];
+    if (c == '"') {
+        return next(position);
+    }
+    if (c != '{' && c != '[') {
+        return true;
+    }
+
+    size_t depth = 1;
+    while (depth > 0 && next(position)) {
+        c = text_[position];
+        if (c == '{' || c == '[') {
+            depth++;
+        } else if (c == '}' || c == ']') {
+            depth--;
+        }
+    }
+    return depth == 0;
+}
+
+}
@@ -0,0 +1,80 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace lunarica {
+
+    class JsonStructuralIndexer {
+    public:
+        enum class Backend { Scalar, Sse2, Avx2 };
+
+        static constexpr size_t kBlockSize = 64;
+
+        explicit JsonStructuralIndexer(Backend backend = detectBackend());
+
+        void index(const char* data, size_t length, std::vector<uint32_t>& positions);
+        void reset();
+
+        Backend backend() const {
+            return backend_;
+        }
+
+        static Backend detectBackend();
+        static const char* backendName(Backend backend);
+
+    private:
+        struct BlockMasks {
+            uint64_t quote = 0;
+            uint64_t backslash = 0;
+            uint64_t op = 0;
+            uint64_t whitespace = 0;
+        };
+
+        Backend backend_;
+        uint64_t escapeCarry_ = 0;
+        uint64_t inStringCarry_ = 0;
+        uint64_t scalarCarry_ = 0;
+
+        void classify(const char* block, BlockMasks& masks) const;
+        uint64_t indexBlock(const BlockMasks& masks, size_t valid);
+    };
+
+    class JsonTokenCursor {
+    public:
+        explicit JsonTokenCursor(std::string_view text, size_t offset = 0);
+
+        void reset(std::string_view text, size_t offset = 0);
+
+        bool next(size_t& position) {
+            if (cursor_ == positions_.size() && !refill()) {
+                return false;
+            }
+            position = base_ + positions_[cursor_++];
+            return true;
+        }
+
+        bool skipValue(size_t& position);
+
+        static size_t scalarEnd(std::string_view text, size_t position);
+
+        std::string_view text() const {
+            return text_;
+        }
+
+    private:
+        static constexpr size_t kSlice = 256 * 1024;
+
+        std::string_view text_;
+        size_t indexed_;
+        size_t base_ = 0;
+        size_t cursor_ = 0;
+        JsonStructuralIndexer indexer_;
+        std::vector<uint32_t> positions_;
+
+        bool refill();
+    };
+
+}
@@ -0,0 +1,341 @@
+﻿#include "load_generator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace lunarica {
+
+namespace {
+
+struct WorkerStats {
+    explicit WorkerStats(bool openLoop) {
+        if (openLoop) {
+            serviceTime.emplace(3, BenchReport::kHighestLatencyUs);
+        }
+    }
+
+    LatencyHistogram latency{3, BenchReport::kHighestLatencyUs};
+    std::optional<LatencyHistogram> serviceTime;
+    std::map<int, size_t> statusCounts;
+    std::map<std::string, size_t> errorCounts;
+    size_t lateSends = 0;
+    int64_t maxSendLagUs = 0;
+};
+
+constexpr auto kLateSendThreshold = std::chrono::milliseconds(1);
+constexpr auto kSpinWindow = std::chrono::microseconds(200);
+
+std::vector<WorkerStats> makeStats(size_t count, bool openLoop) {
+    std::vector<WorkerStats> stats;
+    stats.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        stats.emplace_back(openLoop);
+    }
+    return stats;
+}
+
+int64_t toMicros(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+void recordResult(WorkerStats& local, const httplib::Result& res) {
+    if (res) {
+        local.statusCounts[res->status]++;
+    } else {
+        local.errorCounts[httplib::to_string(res.error())]++;
+    }
+}
+
+void recordSample(WorkerStats& local, const EngineSample& sample, bool openLoop) {
+    if (openLoop) {
+        auto lag = sample.sent - sample.intended;
+        if (lag > kLateSendThreshold) {
+            local.lateSends++;
+        }
+        local.maxSendLagUs = std::max(local.maxSendLagUs, toMicros(lag));
+        local.latency.record(toMicros(sample.received - sample.intended));
+        local.serviceTime->record(toMicros(sample.received - sample.sent));
+    } else {
+        local.latency.record(toMicros(sample.received - sample.sent));
+    }
+
+    if (sample.error == httplib::Error::Success) {
+        local.statusCounts[sample.status]++;
+    } else {
+        local.errorCounts[httplib::to_string(sample.error)]++;
+    }
+}
+
+void mergeStats(BenchReport& report, std::vector<WorkerStats>& stats) {
+    for (auto& local : stats) {
+        report.latency.merge(local.latency);
+        if (local.serviceTime) {
+            report.serviceTime.merge(*local.serviceTime);
+        }
+        for (const auto& [status, count] : local.statusCounts) {
+            report.statusCounts[status] += count;
+        }
+        for (const auto& [error, count] : local.errorCounts) {
+            report.errorCounts[error] += count;
+        }
+        report.lateSends += local.lateSends;
+        report.maxSendLagUs = std::max(report.maxSendLagUs, local.maxSendLagUs);
+    }
+}
+
+}
+
+Pacer::Pacer(double rate, size_t total, Clock::time_point start)
+    : intervalNs_(1e9 / rate), total_(total), start_(start) {
+}
+
+bool Pacer::next(size_t& slot, Clock::time_point& intended) {
+    slot = nextSlot_.fetch_add(1, std::memory_order_relaxed);
+    if (slot >= total_) {
+        return false;
+    }
+    intended = intendedTime(slot);
+    return true;
+}
+
+Pacer::Clock::time_point Pacer::intendedTime(size_t slot) const {
+    // Saturate instead of overflowing the cast for far-off slots; slot 0 is
+    // kept apart because 0 * inf is NaN for a vanishing rate.
+    double offsetNs = slot == 0 ? 0.0 : static_cast<double>(slot) * intervalNs_;
+    auto latest = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::time_point::max() - start_);
+    if (!(offsetNs < static_cast<double>(latest.count()))) {
+        return Clock::time_point::max();
+    }
+    auto offset = std::chrono::nanoseconds(static_cast<int64_t>(offsetNs));
+    return start_ + std::chrono::duration_cast<Clock::duration>(offset);
+}
+
+void Pacer::waitUntil(Clock::time_point deadline) {
+    auto now = Clock::now();
+    if (deadline - now > kSpinWindow) {
+        std::this_thread::sleep_until(deadline - kSpinWindow);
+    }
+    while (Clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+}
+
+double BenchReport::throughput() const {
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    if (seconds <= 0.0) {
+        return 0.0;
+    }
+    return static_cast<double>(requests) / seconds;
+}
+
+int64_t BenchReport::percentile(double percent) const {
+    return latency.valueAtPercentile(percent);
+}
+
+int64_t BenchReport::servicePercentile(double percent) const {
+    return serviceTime.valueAtPercentile(percent);
+}
+
+int64_t BenchReport::max() const {
+    return latency.max();
+}
+
+LoadGenerator::LoadGenerator(std::shared_ptr<HttpService> httpService)
+    : httpService_(std::move(httpService)) {
+}
+
+BenchReport LoadGenerator::runClosedLoop(const HttpRequest& request, const BenchOptions& options) {
+    size_t concurrency = std::max<size_t>(1, std::min(options.concurrency, options.requests));
+
+    std::atomic<size_t> issued{0};
+    std::vector<WorkerStats> stats = makeStats(concurrency, false);
+    std::vector<std::thread> workers;
+    workers.reserve(concurrency);
+
+    auto started = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < concurrency; ++i) {
+        workers.emplace_back([&, i]() {
+            WorkerStats& local = stats[i];
+
+            while (issued.fetch_add(1, std::memory_order_relaxed) < options.requests) {
+                auto sent = std::chrono::steady_clock::now();
+                auto res = httpService_->send(request);
+                auto received = std::chrono::steady_clock::now();
+
+                local.latency.record(toMicros(received - sent));
+                recordResult(local, res);
+            }
+        });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    BenchReport report;
+    report.requests = options.requests;
+    report.concurrency = concurrency;
+    report.elapsed = std::chrono::steady_clock::now() - started;
+    mergeStats(report, stats);
+    return report;
+}
+
+BenchReport LoadGenerator::runOpenLoop(const HttpRequest& request, const BenchOptions& options) {
+    size_t concurrency = std::max<size_t>(1, std::min(options.concurrency, options.requests));
+
+    auto started = Pacer::Clock::now();
+    Pacer pacer(options.rate, options.requests, started);
+
+    // This thread alone waits out the schedule and hands each due slot to an
+    // idle worker; workers block on the queue instead of every one of them
+    // spinning towards its own next slot.
+    std::mutex mutex;
+    std::condition_variable due;
+    std::deque<Pacer::Clock::time_point> ready;
+    bool scheduled = false;
+
+    std::vector<WorkerStats> stats = makeStats(concurrency, true);
+    std::vector<std::thread> workers;
+    workers.reserve(concurrency);
+
+    for (size_t i = 0; i < concurrency; ++i) {
+        workers.emplace_back([&, i]() {
+            WorkerStats& local = stats[i];
+
+            while (true) {
+                Pacer::Clock::time_point intended;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    due.wait(lock, [&] { return !ready.empty() || scheduled; });
+                    if (ready.empty()) {
+                        break;
+                    }
+                    intended = ready.front();
+                    ready.pop_front();
+                }
+
+                auto sent = Pacer::Clock::now();
+                auto res = httpService_->send(request);
+                auto received = Pacer::Clock::now();
+
+                auto lag = sent - intended;
+                if (lag > kLateSendThreshold) {
+                    local.lateSends++;
+                }
+                local.maxSendLagUs = std::max(local.maxSendLagUs, toMicros(lag));
+
+                local.latency.record(toMicros(received - intended));
+                local.serviceTime->record(toMicros(received - sent));
+                recordResult(local, res);
+            }
+        });
+    }
+
+    size_t slot = 0;
+    Pacer::Clock::time_point intended;
+    while (pacer.next(slot, intended)) {
+        Pacer::waitUntil(intended);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.push_back(intended);
+        }
+        due.notify_one();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        scheduled = true;
+    }
+    due.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    BenchReport report;
+    report.requests = options.requests;
+    report.concurrency = concurrency;
+    report.targetRate = options.rate;
+    report.elapsed = Pacer::Clock::now() - started;
+    mergeStats(report, stats);
+    return report;
+}
+
+bool LoadGenerator::runEventLoop(const HttpRequest& request, const BenchOptions& options, BenchReport& report,
+                                 std::string& error) {
+    if (!EventLoopEngine::available()) {
+        error = "the event-loop engine is only available on Linux";
+        return false;
+    }
+    if (request.scheme != "http") {
+        error = "the event-loop engine supports plain http:// targets only";
+        return false;
+    }
+    if (request.bodyFile || request.form) {
+        error = "the event-loop engine sends in-memory bodies only";
+        return false;
+    }
+
+    std::string key = ConnectionPool::makeKey(request.scheme, request.host);
+    ResolveResult resolved = httpService_->getConnectionPool().getDnsCache().resolve(DnsResolver::hostnameOf(request.host));
+    if (!resolved.ok) {
+        error = "could not resolve " + request.host + ": " + resolved.error;
+        return false;
+    }
+
+    EventLoopEngine::Target target;
+    target.address = resolved.address;
+    target.port = static_cast<uint16_t>(std::atoi(key.c_str() + key.rfind(':') + 1));
+    target.request = EventLoopEngine::serialize(request);
+    target.headRequest = request.method == "HEAD";
+
+    bool openLoop = options.rate > 0.0;
+    size_t connections = std::max<size_t>(1, std::min(options.concurrency, options.requests));
+    size_t threads = std::min(options.threads > 0 ? options.threads : defaultThreads(), connections);
+
+    auto started = Pacer::Clock::now();
+    Pacer pacer(openLoop ? options.rate : 1.0, options.requests, started);
+
+    EngineOptions engineOptions;
+    engineOptions.requests = options.requests;
+    engineOptions.connections = connections;
+    engineOptions.threads = threads;
+    engineOptions.backend = options.backend;
+    engineOptions.connectTimeout = options.connectTimeout;
+    engineOptions.readTimeout = options.readTimeout;
+    if (openLoop) {
+        engineOptions.schedule = [&pacer](Pacer::Clock::time_point& intended) {
+            size_t slot = 0;
+            return pacer.next(slot, intended);
+        };
+    }
+
+    std::vector<WorkerStats> stats = makeStats(threads, openLoop);
+    EventLoopEngine engine(std::move(target));
+    bool ok = engine.run(engineOptions, [&](size_t loop, const EngineSample& sample) {
+        recordSample(stats[loop], sample, openLoop);
+    }, error);
+    if (!ok) {
+        return false;
+    }
+
+    report = BenchReport();
+    report.requests = options.requests;
+    report.concurrency = connections;
+    report.targetRate = openLoop ? options.rate : 0.0;
+    report.elapsed = Pacer::Clock::now() - started;
+    mergeStats(report, stats);
+    return true;
+}
+
+size_t LoadGenerator::defaultThreads() {
+    return std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 4);
+}
+
+}
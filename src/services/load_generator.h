@@ -0,0 +1,83 @@
+﻿#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "event_loop_engine.h"
+#include "http_service.h"
+#include "utils/latency_histogram.h"
+
+namespace lunarica {
+
+    struct BenchOptions {
+        size_t requests = 100;
+        size_t concurrency = 10;
+        double rate = 0.0;
+        bool eventLoop = false;
+        EngineBackend backend = EngineBackend::Epoll;
+        size_t threads = 0;
+        std::chrono::seconds connectTimeout{3};
+        std::chrono::seconds readTimeout{5};
+    };
+
+    struct BenchReport {
+        // Bench timeouts are a few seconds, so a one-minute ceiling covers any
+        // real sample with fewer buckets than the 1 h default; every worker
+        // carries its own histograms.
+        static constexpr int64_t kHighestLatencyUs = 60LL * 1000 * 1000;
+
+        size_t requests = 0;
+        size_t concurrency = 0;
+        std::chrono::nanoseconds elapsed{0};
+        std::map<int, size_t> statusCounts;
+        std::map<std::string, size_t> errorCounts;
+        LatencyHistogram latency{3, kHighestLatencyUs};
+        LatencyHistogram serviceTime{3, kHighestLatencyUs};
+        double targetRate = 0.0;
+        size_t lateSends = 0;
+        int64_t maxSendLagUs = 0;
+
+        double throughput() const;
+        int64_t percentile(double percent) const;
+        int64_t servicePercentile(double percent) const;
+        int64_t max() const;
+    };
+
+    class Pacer {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        Pacer(double rate, size_t total, Clock::time_point start);
+
+        bool next(size_t& slot, Clock::time_point& intended);
+        Clock::time_point intendedTime(size_t slot) const;
+
+        static void waitUntil(Clock::time_point deadline);
+
+    private:
+        double intervalNs_;
+        size_t total_;
+        Clock::time_point start_;
+        std::atomic<size_t> nextSlot_{0};
+    };
+
+    class LoadGenerator {
+    public:
+        explicit LoadGenerator(std::shared_ptr<HttpService> httpService);
+        ~LoadGenerator() = default;
+
+        BenchReport runClosedLoop(const HttpRequest& request, const BenchOptions& options);
+        BenchReport runOpenLoop(const HttpRequest& request, const BenchOptions& options);
+        bool runEventLoop(const HttpRequest& request, const BenchOptions& options, BenchReport& report, std::string& error);
+
+        static size_t defaultThreads();
+
+    private:
+        std::shared_ptr<HttpService> httpService_;
+    };
+
+}
@@ -0,0 +1,96 @@
+﻿#include "mapped_file.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace lunarica {
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& path, std::string& error) {
+    std::shared_ptr<MappedFile> file(new MappedFile());
+    file->path_ = path;
+
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "Cannot open " + path + ": " + std::strerror(errno);
+        return nullptr;
+    }
+
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        error = "Not a regular file: " + path;
+        ::close(fd);
+        return nullptr;
+    }
+
+    file->size_ = static_cast<size_t>(info.st_size);
+    if (file->size_ > 0) {
+        void* mapping = mmap(nullptr, file->size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            error = "Cannot map " + path + ": " + std::strerror(errno);
+            ::close(fd);
+            return nullptr;
+        }
+        madvise(mapping, file->size_, MADV_SEQUENTIAL);
+        file->data_ = static_cast<const char*>(mapping);
+        file->mapped_ = true;
+    }
+    ::close(fd);
+#else
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        error = "Cannot open " + path;
+        return nullptr;
+    }
+
+    LARGE_INTEGER size {};
+    if (GetFileType(handle) != FILE_TYPE_DISK || !GetFileSizeEx(handle, &size)) {
+        error = "Not a regular file: " + path;
+        CloseHandle(handle);
+        return nullptr;
+    }
+
+    file->size_ = static_cast<size_t>(size.QuadPart);
+    if (file->size_ > 0) {
+        // The view keeps the section alive, so both handles can go right away.
+        HANDLE section = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* mapping = section ? MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (section) {
+            CloseHandle(section);
+        }
+        if (!mapping) {
+            error = "Cannot map " + path;
+            CloseHandle(handle);
+            return nullptr;
+        }
+        file->data_ = static_cast<const char*>(mapping);
+        file->mapped_ = true;
+    }
+    CloseHandle(handle);
+#endif
+    return file;
+}
+
+MappedFile::~MappedFile() {
+    if (!mapped_) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+#else
+    munmap(const_cast<char*>(data_), size_);
+#endif
+}
+
+}
@@ -0,0 +1,40 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace lunarica {
+
+    class MappedFile {
+    public:
+        static std::shared_ptr<MappedFile> open(const std::string& path, std::string& error);
+
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        std::string_view view() const {
+            return {data_, size_};
+        }
+
+        size_t size() const {
+            return size_;
+        }
+
+        const std::string& path() const {
+            return path_;
+        }
+
+    private:
+        MappedFile() = default;
+
+        std::string path_;
+        const char* data_ = "";
+        size_t size_ = 0;
+        bool mapped_ = false;
+    };
+
+}
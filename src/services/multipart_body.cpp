@@ -0,0 +1,119 @@
+﻿#include "multipart_body.h"
+
+#include <algorithm>
+#include <cctype>
+#include <random>
+
+namespace lunarica {
+
+std::shared_ptr<MultipartBody> MultipartBody::build(const std::vector<FormField>& fields, std::string& error,
+                                                    const std::string& boundary) {
+    auto body = std::make_shared<MultipartBody>();
+    body->boundary_ = boundary.empty() ? randomBoundary() : boundary;
+
+    for (const auto& field : fields) {
+        std::string head = "--" + body->boundary_ + "\r\nContent-Disposition: form-data; name=\"" + quote(field.name) + "\"";
+        if (field.file.empty()) {
+            body->append(head + "\r\n\r\n" + field.value + "\r\n");
+            continue;
+        }
+
+        auto file = MappedFile::open(field.file, error);
+        if (!file) {
+            return nullptr;
+        }
+        std::string filename = field.file.substr(field.file.find_last_of("/\\") + 1);
+        body->append(head + "; filename=\"" + quote(filename) + "\"\r\nContent-Type: " +
+                     contentTypeFor(field.file) + "\r\n\r\n");
+        body->append(std::move(file));
+        body->append("\r\n");
+    }
+    body->append("--" + body->boundary_ + "--\r\n");
+    return body;
+}
+
+std::string_view MultipartBody::slice(size_t offset, size_t maxLength) const {
+    auto it = std::upper_bound(segments_.begin(), segments_.end(), offset,
+                               [](size_t position, const Segment& segment) { return position < segment.start; });
+    if (it == segments_.begin()) {
+        return {};
+    }
+    --it;
+    std::string_view data = it->view();
+    size_t within = offset - it->start;
+    if (within >= data.size()) {
+        return {};
+    }
+    return data.substr(within, maxLength);
+}
+
+std::string MultipartBody::contentTypeFor(const std::string& path) {
+    static const std::pair<const char*, const char*> types[] = {
+        {".json", "application/json"}, {".txt", "text/plain"}, {".csv", "text/csv"},
+        {".html", "text/html"}, {".xml", "application/xml"}, {".pdf", "application/pdf"},
+        {".zip", "application/zip"}, {".gz", "application/gzip"}, {".png", "image/png"},
+        {".jpg", "image/jpeg"}, {".jpeg", "image/jpeg"}, {".gif", "image/gif"},
+        {".webp", "image/webp"}, {".svg", "image/svg+xml"}, {".mp3", "audio/mpeg"},
+        {".mp4", "video/mp4"}, {".webm", "video/webm"}, {".mov", "video/quicktime"}
+    };
+
+    size_t dot = path.find_last_of('.');
+    if (dot != std::string::npos && path.find_first_of("/\\", dot) == std::string::npos) {
+        std::string extension = path.substr(dot);
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        for (const auto& [suffix, type] : types) {
+            if (extension == suffix) {
+                return type;
+            }
+        }
+    }
+    return "application/octet-stream";
+}
+
+void MultipartBody::append(std::string text) {
+    Segment segment;
+    segment.start = size_;
+    segment.text = std::move(text);
+    size_ += segment.text.size();
+    segments_.push_back(std::move(segment));
+}
+
+void MultipartBody::append(std::shared_ptr<MappedFile> file) {
+    if (file->size() == 0) {
+        return;
+    }
+    Segment segment;
+    segment.start = size_;
+    segment.file = std::move(file);
+    size_ += segment.file->size();
+    segments_.push_back(std::move(segment));
+}
+
+std::string MultipartBody::quote(const std::string& value) {
+    std::string quoted;
+    for (char c : value) {
+        switch (c) {
+            case '"': quoted += "%22"; break;
+            case '\r': quoted += "%0D"; break;
+            case '\n': quoted += "%0A"; break;
+            default: quoted += c;
+        }
+    }
+    return quoted;
+}
+
+std::string MultipartBody::randomBoundary() {
+    static const char alphabet[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+    std::random_device device;
+    std::mt19937 generator(device());
+    std::uniform_int_distribution<size_t> pick(0, sizeof(alphabet) - 2);
+
+    std::string boundary = "----LunaricaFormBoundary";
+    for (int i = 0; i < 16; ++i) {
+        boundary += alphabet[pick(generator)];
+    }
+    return boundary;
+}
+
+}
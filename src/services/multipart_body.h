@@ -0,0 +1,61 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "mapped_file.h"
+
+namespace lunarica {
+
+    struct FormField {
+        std::string name;
+        std::string value;
+        std::string file;
+    };
+
+    class MultipartBody {
+    public:
+        static std::shared_ptr<MultipartBody> build(const std::vector<FormField>& fields, std::string& error,
+                                                    const std::string& boundary = std::string());
+
+        std::string_view slice(size_t offset, size_t maxLength) const;
+
+        size_t size() const {
+            return size_;
+        }
+
+        const std::string& boundary() const {
+            return boundary_;
+        }
+
+        std::string contentType() const {
+            return "multipart/form-data; boundary=" + boundary_;
+        }
+
+        static std::string contentTypeFor(const std::string& path);
+
+    private:
+        struct Segment {
+            size_t start = 0;
+            std::string text;
+            std::shared_ptr<MappedFile> file;
+
+            std::string_view view() const {
+                return file ? file->view() : std::string_view(text);
+            }
+        };
+
+        std::string boundary_;
+        std::vector<Segment> segments_;
+        size_t size_ = 0;
+
+        void append(std::string text);
+        void append(std::shared_ptr<MappedFile> file);
+
+        static std::string quote(const std::string& value);
+        static std::string randomBoundary();
+    };
+
+}
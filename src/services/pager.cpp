@@ -0,0 +1,539 @@
+﻿#include "pager.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <streambuf>
+#include "json_path.h"
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+namespace lunarica {
+
+namespace {
+
+constexpr size_t kRenderSlice = 16 * 1024;
+constexpr size_t kMaxLineLength = 1024 * 1024;
+
+enum Key {
+    KeyEscape = 27,
+    KeyUp = 1000,
+    KeyDown,
+    KeyLeft,
+    KeyRight,
+    KeyPageUp,
+    KeyPageDown,
+    KeyHome,
+    KeyEnd
+};
+
+class LineCollector : public std::streambuf {
+public:
+    explicit LineCollector(std::vector<std::string>& lines)
+        : lines_(lines) {
+        lines_.emplace_back();
+    }
+
+    size_t complete() const {
+        return lines_.size() - 1;
+    }
+
+protected:
+    int overflow(int c) override {
+        if (c != traits_type::eof()) {
+            char ch = static_cast<char>(c);
+            xsputn(&ch, 1);
+        }
+        return c;
+    }
+
+    std::streamsize xsputn(const char* data, std::streamsize count) override {
+        const char* end = data + count;
+        while (data < end) {
+            const char* newline = static_cast<const char*>(std::memchr(data, '\n', static_cast<size_t>(end - data)));
+            const char* stop = newline ? newline : end;
+            append(data, static_cast<size_t>(stop - data));
+            if (!newline) {
+                break;
+            }
+            lines_.emplace_back();
+            data = newline + 1;
+        }
+        return count;
+    }
+
+private:
+    std::vector<std::string>& lines_;
+
+    void append(const char* data, size_t length) {
+        std::string& line = lines_.back();
+        line.append(data, std::min(length, kMaxLineLength - std::min(line.size(), kMaxLineLength)));
+    }
+};
+
+#ifndef _WIN32
+class RawTerminal {
+public:
+    RawTerminal() {
+        active_ = tcgetattr(STDIN_FILENO, &saved_) == 0;
+        if (active_) {
+            termios raw = saved_;
+            raw.c_lflag &= ~(ICANON | ECHO | ISIG | IEXTEN);
+            raw.c_iflag &= ~(IXON | ICRNL);
+            raw.c_cc[VMIN] = 1;
+            raw.c_cc[VTIME] = 0;
+            tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+        }
+    }
+
+    ~RawTerminal() {
+        if (active_) {
+            tcsetattr(STDIN_FILENO, TCSAFLUSH, &saved_);
+        }
+    }
+
+private:
+    termios saved_{};
+    bool active_ = false;
+};
+#endif
+
+}
+
+Pager::Pager(std::string_view body, bool jsonHint, OutputSink& out)
+    : body_(body),
+      jsonHint_(jsonHint),
+      out_(out),
+      index_(body, jsonHint) {
+}
+
+void Pager::run() {
+#ifdef _WIN32
+    printAll();
+#else
+    if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO)) {
+        printAll();
+        return;
+    }
+
+    RawTerminal terminal;
+    out_ << "\033[?1049h\033[?25l";
+    updateSize();
+    scrollTo(top_);
+
+    do {
+        updateSize();
+        draw();
+    } while (handleKey(readKey()));
+
+    out_ << "\033[?25h\033[?1049l";
+    out_.flush();
+#endif
+}
+
+void Pager::resize(size_t rows, size_t columns) {
+    rows_ = std::max<size_t>(rows, 1);
+    columns_ = std::max<size_t>(columns, 10);
+}
+
+void Pager::scrollBy(long long lines) {
+    if (lines < 0) {
+        top_ -= std::min(top_, static_cast<size_t>(-lines));
+    } else {
+        scrollTo(top_ + static_cast<size_t>(lines));
+    }
+}
+
+void Pager::scrollTo(size_t line) {
+    index_.extendToLine(line + rows_);
+    top_ = std::min(line, lastTop());
+}
+
+void Pager::scrollToEnd() {
+    index_.extendAll();
+    top_ = lastTop();
+}
+
+void Pager::scrollHorizontally(long long columns) {
+    if (columns < 0) {
+        left_ -= std::min(left_, static_cast<size_t>(-columns));
+    } else {
+        left_ += static_cast<size_t>(columns);
+    }
+}
+
+bool Pager::search(const std::string& text, bool forward) {
+    if (text.empty()) {
+        return false;
+    }
+
+    size_t from = (text == lastSearch_ && lastMatch_ != std::string_view::npos)
+        ? lastMatch_ + (forward ? 1 : 0)
+        : index_.lineOffset(top_);
+    lastSearch_ = text;
+
+    size_t found = std::string_view::npos;
+    if (forward) {
+        auto it = std::search(body_.begin() + std::min(from, body_.size()), body_.end(),
+                              std::boyer_moore_horspool_searcher(text.begin(), text.end()));
+        if (it != body_.end()) {
+            found = static_cast<size_t>(it - body_.begin());
+        }
+    } else if (from > 0) {
+        found = body_.rfind(text, from - 1);
+    }
+
+    if (found == std::string_view::npos) {
+        message_ = "Pattern not found: " + text;
+        return false;
+    }
+
+    lastMatch_ = found;
+    scrollTo(index_.lineOfOffset(found));
+    return true;
+}
+
+bool Pager::jumpToPath(const std::string& path) {
+    std::vector<JsonPathStep> steps;
+    if (!JsonPath::parse(path, steps)) {
+        message_ = "Invalid path: " + path;
+        return false;
+    }
+
+    size_t offset = JsonPath::find(body_, steps);
+    if (offset == JsonPath::npos) {
+        message_ = "Path not found: " + JsonPath::toString(steps);
+        return false;
+    }
+
+    scrollTo(index_.lineOfOffset(offset));
+    message_ = JsonPath::toString(steps);
+    return true;
+}
+
+const std::string& Pager::line(size_t number) {
+    index_.extendToLine(number);
+    if (number >= index_.lineCount()) {
+        return emptyLine_;
+    }
+
+    const auto& lines = block(number / JsonLineIndex::kCheckpointInterval);
+    size_t offset = number % JsonLineIndex::kCheckpointInterval;
+    return offset < lines.size() ? lines[offset] : emptyLine_;
+}
+
+std::vector<std::string> Pager::visibleLines() {
+    std::vector<std::string> lines;
+    lines.reserve(rows_);
+    for (size_t i = 0; i < rows_; ++i) {
+        size_t number = top_ + i;
+        index_.extendToLine(number);
+        if (number >= index_.lineCount()) {
+            lines.emplace_back("~");
+        } else {
+            lines.push_back(clip(line(number), left_, columns_));
+        }
+    }
+    return lines;
+}
+
+std::string Pager::statusLine() {
+    size_t lines = index_.lineCount();
+    size_t bottom = std::min(top_ + rows_, lines);
+
+    std::string status = "lines " + std::to_string(lines == 0 ? 0 : top_ + 1) + "-" + std::to_string(bottom) +
+                         " of " + std::to_string(lines) + (index_.complete() ? "" : "+");
+    if (left_ > 0) {
+        status += ", column " + std::to_string(left_ + 1);
+    }
+
+    if (!message_.empty()) {
+        status += "  " + message_;
+    } else {
+        status += "  (q quit, / ? search, n N next, : path, g G top end)";
+    }
+    return status;
+}
+
+std::string Pager::clip(const std::string& line, size_t from, size_t width) {
+    std::string result;
+    size_t column = 0;
+    bool inEscape = false;
+    bool keep = false;
+
+    for (char c : line) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        if (byte == '\033') {
+            inEscape = true;
+            result.push_back(c);
+            continue;
+        }
+        if (inEscape) {
+            inEscape = byte != 'm';
+            result.push_back(c);
+            continue;
+        }
+
+        if ((byte & 0xC0) != 0x80) {
+            if (column >= from + width) {
+                break;
+            }
+            keep = column >= from;
+            column++;
+            if (keep && byte < 0x20) {
+                result.push_back(' ');
+                continue;
+            }
+        }
+        if (keep) {
+            result.push_back(c);
+        }
+    }
+
+    result += "\033[0m";
+    return result;
+}
+
+const std::vector<std::string>& Pager::block(size_t number) {
+    auto it = blocks_.find(number);
+    if (it != blocks_.end()) {
+        return it->second;
+    }
+
+    if (blocks_.size() >= kCachedBlocks) {
+        blocks_.erase(blockOrder_.front());
+        blockOrder_.pop_front();
+    }
+    blockOrder_.push_back(number);
+    return blocks_[number] = renderBlock(index_.checkpoint(number * JsonLineIndex::kCheckpointInterval));
+}
+
+std::vector<std::string> Pager::renderBlock(const JsonLineIndex::Checkpoint& checkpoint) {
+    std::vector<std::string> lines;
+
+    if (checkpoint.raw) {
+        size_t offset = checkpoint.offset;
+        while (lines.size() < JsonLineIndex::kCheckpointInterval && offset < body_.size()) {
+            size_t end = std::min(body_.find('\n', offset), body_.size());
+            std::string_view text = body_.substr(offset, std::min(end - offset, kMaxLineLength));
+            if (!text.empty() && text.back() == '\r') {
+                text.remove_suffix(1);
+            }
+            lines.emplace_back(text);
+            offset = end + 1;
+        }
+        return lines;
+    }
+
+    LineCollector collector(lines);
+    std::ostream stream(&collector);
+    {
+        OutputSink sink(stream);
+        JsonStreamRenderer renderer(sink, true, 0);
+        renderer.resume(checkpoint.state);
+
+        size_t offset = checkpoint.offset;
+        while (collector.complete() < JsonLineIndex::kCheckpointInterval && offset < body_.size()) {
+            size_t slice = std::min(kRenderSlice, body_.size() - offset);
+            renderer.feed(body_.data() + offset, slice);
+            sink.flush();
+            offset += slice;
+        }
+        if (offset == body_.size()) {
+            renderer.finish();
+        }
+    }
+
+    lines.resize(std::min(collector.complete(), JsonLineIndex::kCheckpointInterval));
+    return lines;
+}
+
+size_t Pager::lastTop() const {
+    size_t lines = index_.lineCount();
+    return lines > rows_ ? lines - rows_ : 0;
+}
+
+void Pager::printAll() {
+    JsonStreamRenderer renderer(out_, jsonHint_, 0);
+    for (size_t offset = 0; offset < body_.size(); offset += JsonStreamRenderer::kDefaultWindow) {
+        renderer.feed(body_.data() + offset, std::min(JsonStreamRenderer::kDefaultWindow, body_.size() - offset));
+    }
+    renderer.finish();
+    out_.flush();
+}
+
+void Pager::draw() {
+    std::string frame = "\033[H";
+    for (const auto& line : visibleLines()) {
+        frame += line;
+        frame += "\033[K\r\n";
+    }
+    frame += "\033[7m" + clip(statusLine(), 0, columns_) + "\033[K";
+
+    out_.write(frame.data(), frame.size());
+    out_.flush();
+}
+
+bool Pager::handleKey(int key) {
+    message_.clear();
+
+    switch (key) {
+        case 'q':
+        case 'Q':
+        case 3:
+            return false;
+        case 'j':
+        case '\r':
+        case '\n':
+        case KeyDown:
+            scrollBy(1);
+            break;
+        case 'k':
+        case KeyUp:
+            scrollBy(-1);
+            break;
+        case ' ':
+        case 'f':
+        case 6:
+        case KeyPageDown:
+            scrollBy(static_cast<long long>(rows_));
+            break;
+        case 'b':
+        case 2:
+        case KeyPageUp:
+            scrollBy(-static_cast<long long>(rows_));
+            break;
+        case 'd':
+            scrollBy(static_cast<long long>(rows_ / 2));
+            break;
+        case 'u':
+            scrollBy(-static_cast<long long>(rows_ / 2));
+            break;
+        case 'g':
+        case '<':
+        case KeyHome:
+            scrollTo(0);
+            break;
+        case 'G':
+        case '>':
+        case KeyEnd:
+            scrollToEnd();
+            break;
+        case 'h':
+        case KeyLeft:
+            scrollHorizontally(-static_cast<long long>(columns_ / 2));
+            break;
+        case 'l':
+        case KeyRight:
+            scrollHorizontally(static_cast<long long>(columns_ / 2));
+            break;
+        case '/':
+        case '?': {
+            std::string text = prompt(std::string(1, static_cast<char>(key)));
+            search(text.empty() ? lastSearch_ : text, key == '/');
+            break;
+        }
+        case 'n':
+            search(lastSearch_, true);
+            break;
+        case 'N':
+            search(lastSearch_, false);
+            break;
+        case ':': {
+            std::string path = prompt(":");
+            if (!path.empty()) {
+                jumpToPath(path);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    return true;
+}
+
+std::string Pager::prompt(const std::string& leader) {
+    std::string text;
+    out_ << "\033[?25h";
+
+    while (true) {
+        out_ << "\033[" << rows_ + 1 << ";1H\033[0m" << leader << text << "\033[K";
+        out_.flush();
+
+        int key = readKey();
+        if (key == '\r' || key == '\n') {
+            break;
+        }
+        if (key == KeyEscape || key == 3) {
+            text.clear();
+            break;
+        }
+        if (key == 127 || key == 8) {
+            if (text.empty()) {
+                break;
+            }
+            text.pop_back();
+        } else if (key >= 32 && key < 256) {
+            text.push_back(static_cast<char>(key));
+        }
+    }
+
+    out_ << "\033[?25l";
+    return text;
+}
+
+int Pager::readKey() {
+#ifdef _WIN32
+    return 'q';
+#else
+    unsigned char c = 0;
+    if (read(STDIN_FILENO, &c, 1) != 1) {
+        return 'q';
+    }
+    if (c != KeyEscape) {
+        return c;
+    }
+
+    char sequence[8];
+    size_t length = 0;
+    while (length < sizeof(sequence)) {
+        pollfd descriptor{STDIN_FILENO, POLLIN, 0};
+        if (poll(&descriptor, 1, 30) <= 0 || read(STDIN_FILENO, &sequence[length], 1) != 1) {
+            break;
+        }
+        char last = sequence[length++];
+        if (length >= 2 && (std::isalpha(static_cast<unsigned char>(last)) || last == '~')) {
+            break;
+        }
+    }
+
+    std::string_view code(sequence, length);
+    if (code == "[A") return KeyUp;
+    if (code == "[B") return KeyDown;
+    if (code == "[C") return KeyRight;
+    if (code == "[D") return KeyLeft;
+    if (code == "[5~") return KeyPageUp;
+    if (code == "[6~") return KeyPageDown;
+    if (code == "[H" || code == "OH" || code == "[1~") return KeyHome;
+    if (code == "[F" || code == "OF" || code == "[4~") return KeyEnd;
+    return KeyEscape;
+#endif
+}
+
+void Pager::updateSize() {
+#ifndef _WIN32
+    struct winsize w;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &w) != -1 && w.ws_row > 1) {
+        resize(w.ws_row - 1, w.ws_col);
+    }
+#endif
+}
+
+}
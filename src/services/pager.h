@@ -0,0 +1,80 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "json_line_index.h"
+#include "core/output_sink.h"
+
+namespace lunarica {
+
+    class Pager {
+    public:
+        Pager(std::string_view body, bool jsonHint, OutputSink& out);
+
+        void run();
+
+        void resize(size_t rows, size_t columns);
+        void scrollBy(long long lines);
+        void scrollTo(size_t line);
+        void scrollToEnd();
+        void scrollHorizontally(long long columns);
+
+        bool search(const std::string& text, bool forward = true);
+        bool jumpToPath(const std::string& path);
+
+        const std::string& line(size_t number);
+        std::vector<std::string> visibleLines();
+        std::string statusLine();
+
+        size_t topLine() const {
+            return top_;
+        }
+
+        const std::string& message() const {
+            return message_;
+        }
+
+        JsonLineIndex& index() {
+            return index_;
+        }
+
+        static std::string clip(const std::string& line, size_t from, size_t width);
+
+    private:
+        static constexpr size_t kCachedBlocks = 16;
+
+        std::string_view body_;
+        bool jsonHint_;
+        OutputSink& out_;
+        JsonLineIndex index_;
+
+        size_t rows_ = 23;
+        size_t columns_ = 80;
+        size_t top_ = 0;
+        size_t left_ = 0;
+
+        std::string lastSearch_;
+        size_t lastMatch_ = std::string_view::npos;
+        std::string message_;
+
+        std::unordered_map<size_t, std::vector<std::string>> blocks_;
+        std::deque<size_t> blockOrder_;
+        std::string emptyLine_;
+
+        const std::vector<std::string>& block(size_t number);
+        std::vector<std::string> renderBlock(const JsonLineIndex::Checkpoint& checkpoint);
+        size_t lastTop() const;
+
+        void printAll();
+        void draw();
+        bool handleKey(int key);
+        std::string prompt(const std::string& leader);
+        int readKey();
+        void updateSize();
+    };
+
+}
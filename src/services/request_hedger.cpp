@@ -0,0 +1,121 @@
+﻿#include "request_hedger.h"
+
+namespace lunarica {
+
+namespace {
+
+constexpr int64_t kHighestLatencyUs = 60LL * 1000 * 1000;
+
+}
+
+bool HedgeRace::Leg::attach(httplib::Client& client) {
+    std::lock_guard<std::mutex> lock(race_.mutex_);
+    if (race_.winner_ >= 0 && race_.winner_ != static_cast<int>(index_)) {
+        return false;
+    }
+    race_.clients_[index_] = &client;
+    return true;
+}
+
+void HedgeRace::Leg::detach() {
+    std::lock_guard<std::mutex> lock(race_.mutex_);
+    race_.clients_[index_] = nullptr;
+}
+
+bool HedgeRace::Leg::claim() {
+    std::lock_guard<std::mutex> lock(race_.mutex_);
+    if (race_.winner_ < 0) {
+        race_.winner_ = static_cast<int>(index_);
+        race_.decidedAt_ = Clock::now();
+        if (httplib::Client* loser = race_.clients_[1 - index_]) {
+            loser->stop();
+        }
+        race_.changed_.notify_all();
+    }
+    return race_.winner_ == static_cast<int>(index_);
+}
+
+bool HedgeRace::Leg::cancelled() const {
+    std::lock_guard<std::mutex> lock(race_.mutex_);
+    return race_.winner_ >= 0 && race_.winner_ != static_cast<int>(index_);
+}
+
+void HedgeRace::Leg::finish() {
+    std::lock_guard<std::mutex> lock(race_.mutex_);
+    race_.finished_[index_] = true;
+    race_.changed_.notify_all();
+}
+
+bool HedgeRace::waitForHeaders(Clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return changed_.wait_until(lock, deadline, [this] {
+        return winner_ >= 0 || finished_[0];
+    });
+}
+
+int HedgeRace::winner() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return winner_;
+}
+
+HedgeRace::Clock::time_point HedgeRace::decidedAt() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return decidedAt_;
+}
+
+bool RequestHedger::delayFor(const std::string& host, HedgeMode mode, int fixedMs,
+                             std::chrono::microseconds& delay) {
+    if (mode == HedgeMode::Fixed) {
+        delay = std::chrono::milliseconds(fixedMs);
+        return true;
+    }
+    if (mode != HedgeMode::Percentile) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = latency_.find(host);
+    if (it == latency_.end() || it->second.count() < kMinSamples) {
+        return false;
+    }
+    // A hedged request only shows how fast the quicker of two legs was, and
+    // feeding that back would pull the p95 (and so the delay) lower and lower.
+    // Samples come from unhedged requests only, so keep a steady trickle of them.
+    if (++requests_[host] % kSampleEvery == 0) {
+        return false;
+    }
+    delay = std::chrono::microseconds(it->second.valueAtPercentile(95));
+    return true;
+}
+
+void RequestHedger::record(const std::string& host, std::chrono::microseconds latency) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    latency_.try_emplace(host, 2, kHighestLatencyUs).first->second.record(latency.count());
+}
+
+void RequestHedger::count(bool fired, bool won) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.requests++;
+    stats_.fired += fired ? 1 : 0;
+    stats_.won += won ? 1 : 0;
+}
+
+size_t RequestHedger::samples(const std::string& host) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = latency_.find(host);
+    return it == latency_.end() ? 0 : static_cast<size_t>(it->second.count());
+}
+
+HedgeStats RequestHedger::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void RequestHedger::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    latency_.clear();
+    requests_.clear();
+    stats_ = HedgeStats();
+}
+
+}
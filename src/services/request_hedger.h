@@ -0,0 +1,92 @@
+﻿#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+#include <httplib.h>
+#include "core/context.h"
+#include "utils/latency_histogram.h"
+
+namespace lunarica {
+
+    struct HedgeStats {
+        size_t requests = 0;
+        size_t fired = 0;
+        size_t won = 0;
+    };
+
+    struct HedgeOutcome {
+        bool fired = false;
+        bool won = false;
+        std::chrono::microseconds delay{0};
+    };
+
+    // Arbitrates between the original request (leg 0) and its duplicate
+    // (leg 1): the first leg to receive response headers wins and the other
+    // one has its connection shut down.
+    class HedgeRace {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        class Leg {
+        public:
+            Leg(HedgeRace& race, size_t index) : race_(race), index_(index) {}
+
+            bool attach(httplib::Client& client);
+            void detach();
+            bool claim();
+            bool cancelled() const;
+            void finish();
+
+        private:
+            HedgeRace& race_;
+            size_t index_;
+        };
+
+        HedgeRace() = default;
+        HedgeRace(const HedgeRace&) = delete;
+        HedgeRace& operator=(const HedgeRace&) = delete;
+
+        bool waitForHeaders(Clock::time_point deadline);
+        int winner() const;
+        Clock::time_point decidedAt() const;
+
+    private:
+        mutable std::mutex mutex_;
+        std::condition_variable changed_;
+        httplib::Client* clients_[2] = {nullptr, nullptr};
+        bool finished_[2] = {false, false};
+        int winner_ = -1;
+        Clock::time_point decidedAt_;
+    };
+
+    class RequestHedger {
+    public:
+        static constexpr size_t kMinSamples = 20;
+        // One in this many requests to a host goes out unhedged so that its
+        // latency keeps feeding the percentile (see delayFor).
+        static constexpr size_t kSampleEvery = 20;
+
+        RequestHedger() = default;
+        RequestHedger(const RequestHedger&) = delete;
+        RequestHedger& operator=(const RequestHedger&) = delete;
+
+        bool delayFor(const std::string& host, HedgeMode mode, int fixedMs, std::chrono::microseconds& delay);
+        void record(const std::string& host, std::chrono::microseconds latency);
+        void count(bool fired, bool won);
+
+        size_t samples(const std::string& host) const;
+        HedgeStats stats() const;
+        void reset();
+
+    private:
+        mutable std::mutex mutex_;
+        std::map<std::string, LatencyHistogram> latency_;
+        std::map<std::string, size_t> requests_;
+        HedgeStats stats_;
+    };
+
+}
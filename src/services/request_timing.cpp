@@ -0,0 +1,186 @@
+﻿#include "request_timing.h"
+
+#include <fmt/core.h>
+
+#ifdef __linux__
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#endif
+
+namespace lunarica {
+
+namespace {
+
+std::string connectionPhases(const RequestTiming& timing) {
+    std::string line = "dns " + (timing.newConnection && timing.dns.count() > 0
+                                     ? RequestTiming::formatDuration(timing.dns) : std::string("-"));
+    line += (timing.connectEstimated ? " | ~connect " : " | connect ") + (timing.newConnection && timing.connect.count() > 0
+                                 ? RequestTiming::formatDuration(timing.connect) : std::string("-"));
+    line += " | tls " + (timing.tlsHandshake ? RequestTiming::formatDuration(timing.tls) : std::string("-"));
+    if (timing.tlsHandshake) {
+        line += timing.tlsResumed ? " (resumed)" : " (full)";
+    }
+    line += " | ttfb " + RequestTiming::formatDuration(timing.ttfb);
+    return line;
+}
+
+}
+
+RequestTiming::Duration RequestTiming::network() const {
+    return dns + connect + tls + ttfb + transfer;
+}
+
+std::string RequestTiming::headSummary() const {
+    std::string line = connectionPhases(*this);
+    line += newConnection ? " (new connection" : " (reused connection";
+    line += http2 ? ", h2)" : ")";
+    return line;
+}
+
+std::string RequestTiming::summary() const {
+    std::string line = connectionPhases(*this);
+    line += " | transfer " + formatDuration(transfer);
+    line += " | total " + formatDuration(network());
+    line += newConnection ? " (new connection" : " (reused connection";
+    line += http2 ? ", h2)" : ")";
+    return line;
+}
+
+std::string RequestTiming::formatDuration(Duration duration) {
+    return fmt::format("{:.2f} ms", std::chrono::duration<double, std::milli>(duration).count());
+}
+
+void ConnectionProbe::attach(httplib::Client& client) {
+    client.set_socket_options([this](httplib::socket_t sock) {
+        onSocketCreated(sock);
+    });
+
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+    if (SSL_CTX* ctx = client.ssl_context()) {
+        SSL_CTX_set_app_data(ctx, this);
+        SSL_CTX_set_info_callback(ctx, &ConnectionProbe::onTlsEvent);
+    }
+#endif
+}
+
+void ConnectionProbe::attachSessions(httplib::Client& client, TlsSessionCache& sessions, const std::string& key) {
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+    if (SSL_CTX* ctx = client.ssl_context()) {
+        sessions_ = &sessions;
+        sessionKey_ = key;
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_sess_set_new_cb(ctx, &ConnectionProbe::onNewSession);
+    }
+#else
+    (void)client;
+    (void)sessions;
+    (void)key;
+#endif
+}
+
+void ConnectionProbe::addResolveTime(std::chrono::nanoseconds elapsed) {
+    pendingDns_ += elapsed;
+}
+
+void ConnectionProbe::beginRequest(Clock::time_point started) {
+    started_ = started;
+    requestDns_ = pendingDns_;
+    pendingDns_ = std::chrono::nanoseconds(0);
+    connected_ = false;
+    tlsHandshake_ = false;
+    tlsResumed_ = false;
+    headersSeen_ = false;
+    estimatedConnect_ = std::chrono::nanoseconds(0);
+}
+
+void ConnectionProbe::markHeaders() {
+    headersAt_ = Clock::now();
+    headersSeen_ = true;
+
+    if (connected_ && !tlsHandshake_) {
+        estimatedConnect_ = estimateTcpHandshake();
+    }
+}
+
+RequestTiming ConnectionProbe::finish(Clock::time_point finished) const {
+    RequestTiming timing;
+    timing.newConnection = connected_;
+    timing.tlsHandshake = tlsHandshake_;
+    timing.tlsResumed = tlsResumed_;
+
+    Clock::time_point readyAt = started_;
+    if (connected_) {
+        timing.dns = requestDns_;
+
+        if (tlsHandshake_) {
+            timing.connect = tlsStart_ - connectStart_;
+            timing.tls = tlsDone_ - tlsStart_;
+            readyAt = tlsDone_;
+        } else {
+            timing.connect = estimatedConnect_;
+            timing.connectEstimated = estimatedConnect_.count() > 0;
+            readyAt = connectStart_ + estimatedConnect_;
+        }
+    }
+
+    Clock::time_point endOfHeaders = headersSeen_ ? headersAt_ : finished;
+    if (endOfHeaders > readyAt) {
+        timing.ttfb = endOfHeaders - readyAt;
+    }
+    if (headersSeen_ && finished > headersAt_) {
+        timing.transfer = finished - headersAt_;
+    }
+
+    return timing;
+}
+
+void ConnectionProbe::onSocketCreated(httplib::socket_t sock) {
+    connectStart_ = Clock::now();
+    connected_ = true;
+    socket_ = sock;
+}
+
+std::chrono::nanoseconds ConnectionProbe::estimateTcpHandshake() const {
+#ifdef __linux__
+    struct tcp_info info = {};
+    socklen_t length = sizeof(info);
+    if (getsockopt(socket_, IPPROTO_TCP, TCP_INFO, &info, &length) == 0) {
+        return std::chrono::microseconds(info.tcpi_rtt);
+    }
+#endif
+    return std::chrono::nanoseconds(0);
+}
+
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+void ConnectionProbe::onTlsEvent(const SSL* ssl, int where, int) {
+    auto* probe = static_cast<ConnectionProbe*>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+    if (probe == nullptr) {
+        return;
+    }
+
+    if (where & SSL_CB_HANDSHAKE_START) {
+        probe->tlsStart_ = Clock::now();
+        probe->tlsHandshake_ = true;
+        if (probe->sessions_) {
+            if (SSL_SESSION* session = probe->sessions_->lookup(probe->sessionKey_)) {
+                SSL_set_session(const_cast<SSL*>(ssl), session);
+                SSL_SESSION_free(session);
+            }
+        }
+    } else if (where & SSL_CB_HANDSHAKE_DONE) {
+        probe->tlsDone_ = Clock::now();
+        probe->tlsResumed_ = SSL_session_reused(const_cast<SSL*>(ssl)) == 1;
+    }
+}
+
+int ConnectionProbe::onNewSession(SSL* ssl, SSL_SESSION* session) {
+    auto* probe = static_cast<ConnectionProbe*>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+    if (probe != nullptr && probe->sessions_) {
+        probe->sessions_->store(probe->sessionKey_, session);
+    }
+    return 0;
+}
+#endif
+
+}
@@ -0,0 +1,80 @@
+﻿#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <httplib.h>
+#include "tls_session_cache.h"
+
+namespace lunarica {
+
+    struct RequestTiming {
+        using Duration = std::chrono::nanoseconds;
+
+        Duration dns{0};
+        Duration connect{0};
+        Duration tls{0};
+        Duration ttfb{0};
+        Duration transfer{0};
+        Duration render{0};
+        Duration upload{0};
+        uint64_t uploaded = 0;
+        uint64_t uploadedRaw = 0;
+        bool newConnection = false;
+        // Plain HTTP/1 connects are not timed directly; connect is the
+        // kernel's smoothed RTT for the socket and is shown as "~connect".
+        bool connectEstimated = false;
+        bool tlsHandshake = false;
+        bool tlsResumed = false;
+        bool http2 = false;
+
+        Duration network() const;
+        std::string headSummary() const;
+        std::string summary() const;
+
+        static std::string formatDuration(Duration duration);
+    };
+
+    class ConnectionProbe {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        ConnectionProbe() = default;
+        ConnectionProbe(const ConnectionProbe&) = delete;
+        ConnectionProbe& operator=(const ConnectionProbe&) = delete;
+
+        void attach(httplib::Client& client);
+        void attachSessions(httplib::Client& client, TlsSessionCache& sessions, const std::string& key);
+
+        void addResolveTime(std::chrono::nanoseconds elapsed);
+        void beginRequest(Clock::time_point started);
+        void markHeaders();
+        RequestTiming finish(Clock::time_point finished) const;
+
+    private:
+        Clock::time_point started_;
+        Clock::time_point connectStart_;
+        Clock::time_point tlsStart_;
+        Clock::time_point tlsDone_;
+        Clock::time_point headersAt_;
+        std::chrono::nanoseconds pendingDns_{0};
+        std::chrono::nanoseconds requestDns_{0};
+        std::chrono::nanoseconds estimatedConnect_{0};
+        bool connected_ = false;
+        bool tlsHandshake_ = false;
+        bool tlsResumed_ = false;
+        bool headersSeen_ = false;
+        TlsSessionCache* sessions_ = nullptr;
+        std::string sessionKey_;
+        httplib::socket_t socket_ = static_cast<httplib::socket_t>(-1);
+
+        void onSocketCreated(httplib::socket_t sock);
+        std::chrono::nanoseconds estimateTcpHandshake() const;
+
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+        static void onTlsEvent(const SSL* ssl, int where, int ret);
+        static int onNewSession(SSL* ssl, SSL_SESSION* session);
+#endif
+    };
+
+}
@@ -0,0 +1,96 @@
+﻿#include "response_store.h"
+
+#include <algorithm>
+
+namespace lunarica {
+
+bool StoredResponse::isJson() {
+    if (contentType.find("json") != std::string::npos) {
+        return true;
+    }
+    std::string_view text = body.view();
+    size_t first = text.find_first_not_of(" \t\r\n");
+    return first != std::string_view::npos && (text[first] == '{' || text[first] == '[');
+}
+
+JsonDocumentIndex& StoredResponse::structure() {
+    if (!structure_) {
+        structure_ = std::make_unique<JsonDocumentIndex>(body.view());
+    }
+    return *structure_;
+}
+
+void StoredResponse::release() {
+    structure_.reset();
+    body.spill();
+}
+
+ResponseStore::ResponseStore(size_t capacity, size_t memoryBudget)
+    : capacity_(std::max<size_t>(capacity, 1)),
+      memoryBudget_(memoryBudget) {
+}
+
+std::shared_ptr<StoredResponse> ResponseStore::create(const std::string& method, const std::string& url) {
+    auto response = std::make_shared<StoredResponse>();
+    response->id = nextId_++;
+    response->method = method;
+    response->url = url;
+    return response;
+}
+
+void ResponseStore::add(std::shared_ptr<StoredResponse> response) {
+    entries_.push_front(std::move(response));
+    while (entries_.size() > capacity_) {
+        entries_.pop_back();
+    }
+    enforceBudget();
+}
+
+void ResponseStore::clear() {
+    entries_.clear();
+}
+
+std::shared_ptr<StoredResponse> ResponseStore::get(size_t number) const {
+    if (number == 0 || number > entries_.size()) {
+        return nullptr;
+    }
+    return entries_[number - 1];
+}
+
+size_t ResponseStore::memoryUsage() const {
+    size_t total = 0;
+    for (const auto& entry : entries_) {
+        total += entry->body.memoryUsage();
+    }
+    return total;
+}
+
+bool ResponseStore::parseReference(std::string_view text, size_t& number, std::vector<JsonPathStep>& steps) {
+    number = 1;
+    if (!text.empty() && text[0] == '$') {
+        size_t digits = 1;
+        size_t parsed = 0;
+        while (digits < text.size() && text[digits] >= '0' && text[digits] <= '9') {
+            parsed = parsed * 10 + static_cast<size_t>(text[digits] - '0');
+            digits++;
+        }
+        if (digits > 1) {
+            number = parsed;
+        }
+        text.remove_prefix(digits);
+    }
+    return JsonPath::parse(text, steps);
+}
+
+void ResponseStore::enforceBudget() {
+    size_t usage = memoryUsage();
+    for (auto it = entries_.rbegin(); it != entries_.rend() && usage > memoryBudget_; ++it) {
+        size_t held = (*it)->body.memoryUsage();
+        if (held > 0) {
+            (*it)->release();
+            usage -= held - (*it)->body.memoryUsage();
+        }
+    }
+}
+
+}
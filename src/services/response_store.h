@@ -0,0 +1,67 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "body_spool.h"
+#include "json_document_index.h"
+#include "json_path.h"
+
+namespace lunarica {
+
+    struct StoredResponse {
+        uint64_t id = 0;
+        std::string method;
+        std::string url;
+        int status = 0;
+        std::string contentType;
+        std::vector<std::pair<std::string, std::string>> headers;
+        BodySpool body;
+
+        bool isJson();
+        JsonDocumentIndex& structure();
+        void release();
+
+    private:
+        std::unique_ptr<JsonDocumentIndex> structure_;
+    };
+
+    class ResponseStore {
+    public:
+        static constexpr size_t kDefaultCapacity = 10;
+        static constexpr size_t kDefaultMemoryBudget = 64 * 1024 * 1024;
+
+        explicit ResponseStore(size_t capacity = kDefaultCapacity, size_t memoryBudget = kDefaultMemoryBudget);
+
+        std::shared_ptr<StoredResponse> create(const std::string& method, const std::string& url);
+        void add(std::shared_ptr<StoredResponse> response);
+        void clear();
+
+        std::shared_ptr<StoredResponse> get(size_t number) const;
+        std::shared_ptr<StoredResponse> latest() const {
+            return get(1);
+        }
+
+        const std::deque<std::shared_ptr<StoredResponse>>& entries() const {
+            return entries_;
+        }
+
+        size_t memoryUsage() const;
+
+        static bool parseReference(std::string_view text, size_t& number, std::vector<JsonPathStep>& steps);
+
+    private:
+        size_t capacity_;
+        size_t memoryBudget_;
+        uint64_t nextId_ = 1;
+        std::deque<std::shared_ptr<StoredResponse>> entries_;
+
+        void enforceBudget();
+    };
+
+}
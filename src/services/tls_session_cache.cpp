@@ -0,0 +1,66 @@
+﻿#include "tls_session_cache.h"
+
+namespace lunarica {
+
+TlsSessionCache::~TlsSessionCache() {
+    clear();
+}
+
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+
+void TlsSessionCache::store(const std::string& key, SSL_SESSION* session) {
+    if (session == nullptr || !SSL_SESSION_is_resumable(session)) {
+        return;
+    }
+
+    SSL_SESSION_up_ref(session);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sessions_.find(key);
+    if (it != sessions_.end()) {
+        SSL_SESSION_free(static_cast<SSL_SESSION*>(it->second));
+        it->second = session;
+        return;
+    }
+
+    if (sessions_.size() >= kMaxSessions) {
+        SSL_SESSION_free(static_cast<SSL_SESSION*>(sessions_.begin()->second));
+        sessions_.erase(sessions_.begin());
+    }
+    sessions_.emplace(key, session);
+}
+
+SSL_SESSION* TlsSessionCache::lookup(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sessions_.find(key);
+    if (it == sessions_.end()) {
+        return nullptr;
+    }
+
+    auto* session = static_cast<SSL_SESSION*>(it->second);
+    if (!SSL_SESSION_is_resumable(session)) {
+        SSL_SESSION_free(session);
+        sessions_.erase(it);
+        return nullptr;
+    }
+    SSL_SESSION_up_ref(session);
+    return session;
+}
+
+#endif
+
+void TlsSessionCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+    for (const auto& [_, session] : sessions_) {
+        SSL_SESSION_free(static_cast<SSL_SESSION*>(session));
+    }
+#endif
+    sessions_.clear();
+}
+
+size_t TlsSessionCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sessions_.size();
+}
+
+}
@@ -0,0 +1,33 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+#include <httplib.h>
+
+namespace lunarica {
+
+    class TlsSessionCache {
+    public:
+        static constexpr size_t kMaxSessions = 256;
+
+        TlsSessionCache() = default;
+        ~TlsSessionCache();
+        TlsSessionCache(const TlsSessionCache&) = delete;
+        TlsSessionCache& operator=(const TlsSessionCache&) = delete;
+
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+        void store(const std::string& key, SSL_SESSION* session);
+        SSL_SESSION* lookup(const std::string& key);
+#endif
+
+        void clear();
+        size_t size() const;
+
+    private:
+        mutable std::mutex mutex_;
+        std::map<std::string, void*> sessions_;
+    };
+
+}
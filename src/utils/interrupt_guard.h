@@ -0,0 +1,35 @@
+#pragma once
+
+#include <csignal>
+
+namespace lunarica {
+
+    inline volatile std::sig_atomic_t interruptRequested = 0;
+
+    inline void requestInterrupt(int) {
+        interruptRequested = 1;
+    }
+
+    class InterruptGuard {
+    public:
+        InterruptGuard() {
+            interruptRequested = 0;
+            previous_ = std::signal(SIGINT, requestInterrupt);
+        }
+
+        ~InterruptGuard() {
+            std::signal(SIGINT, previous_);
+        }
+
+        InterruptGuard(const InterruptGuard&) = delete;
+        InterruptGuard& operator=(const InterruptGuard&) = delete;
+
+        bool triggered() const {
+            return interruptRequested != 0;
+        }
+
+    private:
+        void (*previous_)(int);
+    };
+
+}
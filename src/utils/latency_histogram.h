@@ -0,0 +1,176 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace lunarica {
+
+    class LatencyHistogram {
+    public:
+        explicit LatencyHistogram(int significantDigits = 3, int64_t highestTrackableUs = 3600LL * 1000 * 1000)
+            : significantDigits_(significantDigits),
+              highestTrackable_(highestTrackableUs) {
+            if (significantDigits < 1 || significantDigits > 5) {
+                throw std::invalid_argument("significant digits must be between 1 and 5");
+            }
+            if (highestTrackableUs < 2) {
+                throw std::invalid_argument("highest trackable value must be at least 2");
+            }
+
+            int64_t largestSingleUnit = 2 * static_cast<int64_t>(std::pow(10, significantDigits));
+            subBucketCountMagnitude_ = static_cast<int>(std::ceil(std::log2(static_cast<double>(largestSingleUnit))));
+            subBucketHalfCountMagnitude_ = subBucketCountMagnitude_ - 1;
+            subBucketCount_ = int64_t(1) << subBucketCountMagnitude_;
+            subBucketHalfCount_ = subBucketCount_ / 2;
+            subBucketMask_ = subBucketCount_ - 1;
+
+            int64_t smallestUntrackable = subBucketCount_;
+            int buckets = 1;
+            while (smallestUntrackable <= highestTrackable_) {
+                if (smallestUntrackable > std::numeric_limits<int64_t>::max() / 2) {
+                    buckets++;
+                    break;
+                }
+                smallestUntrackable <<= 1;
+                buckets++;
+            }
+            bucketCount_ = buckets;
+
+            counts_.assign(static_cast<size_t>((bucketCount_ + 1) * subBucketHalfCount_), 0);
+        }
+
+        void record(int64_t value) {
+            value = std::clamp<int64_t>(value, 0, highestTrackable_);
+            counts_[countsIndexFor(value)]++;
+            totalCount_++;
+            min_ = std::min(min_, value);
+            max_ = std::max(max_, value);
+            sum_ += static_cast<double>(value);
+        }
+
+        void merge(const LatencyHistogram& other) {
+            if (other.totalCount_ == 0) {
+                return;
+            }
+
+            if (sameLayout(other)) {
+                for (size_t i = 0; i < counts_.size(); ++i) {
+                    counts_[i] += other.counts_[i];
+                }
+            } else {
+                for (size_t i = 0; i < other.counts_.size(); ++i) {
+                    if (other.counts_[i] != 0) {
+                        int64_t value = std::min(other.valueFromIndex(i), highestTrackable_);
+                        counts_[countsIndexFor(value)] += other.counts_[i];
+                    }
+                }
+            }
+
+            totalCount_ += other.totalCount_;
+            min_ = std::min(min_, other.min_);
+            max_ = std::max(max_, std::min(other.max_, highestTrackable_));
+            sum_ += other.sum_;
+        }
+
+        int64_t valueAtPercentile(double percentile) const {
+            if (totalCount_ == 0) {
+                return 0;
+            }
+
+            percentile = std::clamp(percentile, 0.0, 100.0);
+            auto target = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(totalCount_) + 0.5);
+            target = std::max<uint64_t>(target, 1);
+
+            uint64_t seen = 0;
+            for (size_t i = 0; i < counts_.size(); ++i) {
+                seen += counts_[i];
+                if (seen >= target) {
+                    return std::min(highestEquivalentValue(valueFromIndex(i)), max_);
+                }
+            }
+            return max_;
+        }
+
+        void reset() {
+            std::fill(counts_.begin(), counts_.end(), 0);
+            totalCount_ = 0;
+            min_ = std::numeric_limits<int64_t>::max();
+            max_ = 0;
+            sum_ = 0.0;
+        }
+
+        uint64_t count() const { return totalCount_; }
+        int64_t min() const { return totalCount_ == 0 ? 0 : min_; }
+        int64_t max() const { return max_; }
+        double mean() const { return totalCount_ == 0 ? 0.0 : sum_ / static_cast<double>(totalCount_); }
+
+        int significantDigits() const { return significantDigits_; }
+        int64_t highestTrackable() const { return highestTrackable_; }
+        size_t memoryFootprint() const { return counts_.size() * sizeof(uint64_t); }
+
+    private:
+        int significantDigits_;
+        int64_t highestTrackable_;
+        int subBucketCountMagnitude_ = 0;
+        int subBucketHalfCountMagnitude_ = 0;
+        int64_t subBucketCount_ = 0;
+        int64_t subBucketHalfCount_ = 0;
+        int64_t subBucketMask_ = 0;
+        int bucketCount_ = 0;
+
+        std::vector<uint64_t> counts_;
+        uint64_t totalCount_ = 0;
+        int64_t min_ = std::numeric_limits<int64_t>::max();
+        int64_t max_ = 0;
+        double sum_ = 0.0;
+
+        static int bitLength(uint64_t value) {
+            int length = 0;
+            while (value != 0) {
+                value >>= 1;
+                length++;
+            }
+            return length;
+        }
+
+        bool sameLayout(const LatencyHistogram& other) const {
+            return subBucketCountMagnitude_ == other.subBucketCountMagnitude_ &&
+                   counts_.size() == other.counts_.size();
+        }
+
+        int bucketIndexFor(int64_t value) const {
+            return bitLength(static_cast<uint64_t>(value | subBucketMask_)) - (subBucketHalfCountMagnitude_ + 1);
+        }
+
+        size_t countsIndexFor(int64_t value) const {
+            int bucketIndex = bucketIndexFor(value);
+            int64_t subBucketIndex = value >> bucketIndex;
+            int64_t index = ((static_cast<int64_t>(bucketIndex) + 1) << subBucketHalfCountMagnitude_) +
+                            (subBucketIndex - subBucketHalfCount_);
+            return static_cast<size_t>(index);
+        }
+
+        int64_t valueFromIndex(size_t index) const {
+            int64_t bucketIndex = (static_cast<int64_t>(index) >> subBucketHalfCountMagnitude_) - 1;
+            int64_t subBucketIndex = (static_cast<int64_t>(index) & (subBucketHalfCount_ - 1)) + subBucketHalfCount_;
+            if (bucketIndex < 0) {
+                subBucketIndex -= subBucketHalfCount_;
+                bucketIndex = 0;
+            }
+            return subBucketIndex << bucketIndex;
+        }
+
+        int64_t highestEquivalentValue(int64_t value) const {
+            int bucketIndex = bucketIndexFor(value);
+            int64_t subBucketIndex = value >> bucketIndex;
+            int64_t lowest = subBucketIndex << bucketIndex;
+            int adjustedBucket = subBucketIndex >= subBucketCount_ ? bucketIndex + 1 : bucketIndex;
+            return lowest + (int64_t(1) << adjustedBucket) - 1;
+        }
+    };
+
+}
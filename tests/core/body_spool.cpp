@@ -0,0 +1,38 @@
+﻿#include "services/body_spool.h"
+
+#include <string>
+#include <gtest/gtest.h>
+
+namespace lunarica {
+
+TEST(BodySpoolTest, KeepsSmallBodiesInMemory) {
+    BodySpool spool(64);
+    spool.append("hello ", 6);
+    spool.append("world", 5);
+
+    EXPECT_FALSE(spool.spilled());
+    EXPECT_EQ(spool.size(), 11u);
+    EXPECT_EQ(spool.view(), "hello world");
+}
+
+TEST(BodySpoolTest, SpillsLargeBodiesToFile) {
+    BodySpool spool(16);
+    std::string expected;
+    for (int i = 0; i < 100; ++i) {
+        std::string chunk = "chunk-" + std::to_string(i) + ";";
+        spool.append(chunk.data(), chunk.size());
+        expected += chunk;
+    }
+
+    EXPECT_TRUE(spool.spilled());
+    EXPECT_EQ(spool.view(), expected);
+
+    spool.append("tail", 4);
+    EXPECT_EQ(spool.view(), expected + "tail");
+
+    spool.clear();
+    EXPECT_EQ(spool.size(), 0u);
+    EXPECT_EQ(spool.view(), "");
+}
+
+}
@@ -0,0 +1,130 @@
+﻿#include <gtest/gtest.h>
+#include "services/connection_pool.h"
+
+namespace lunarica {
+
+class ConnectionPoolTest : public ::testing::Test {
+protected:
+    std::shared_ptr<Context> context;
+    std::unique_ptr<ConnectionPool> pool;
+
+    void SetUp() override {
+        context = std::make_shared<Context>();
+        pool = std::make_unique<ConnectionPool>(context);
+    }
+};
+
+TEST_F(ConnectionPoolTest, MakeKeyNormalizesDefaultPorts) {
+    EXPECT_EQ(ConnectionPool::makeKey("http", "Example.com"), "http://example.com:80");
+    EXPECT_EQ(ConnectionPool::makeKey("https", "example.com"), "https://example.com:443");
+    EXPECT_EQ(ConnectionPool::makeKey("http", "localhost:8090"), "http://localhost:8090");
+    EXPECT_EQ(ConnectionPool::makeKey("http", "[::1]"), "http://[::1]:80");
+    EXPECT_EQ(ConnectionPool::makeKey("http", "[::1]:8080"), "http://[::1]:8080");
+}
+
+TEST_F(ConnectionPoolTest, ReusesReleasedClient) {
+    httplib::Client* first = nullptr;
+    {
+        auto lease = pool->acquire("http", "localhost:8090");
+        EXPECT_FALSE(lease.isReused());
+        first = &lease.client();
+    }
+    EXPECT_EQ(pool->idleCount(), 1);
+
+    auto lease = pool->acquire("http", "localhost:8090");
+    EXPECT_TRUE(lease.isReused());
+    EXPECT_EQ(&lease.client(), first);
+    EXPECT_EQ(pool->idleCount(), 0);
+}
+
+TEST_F(ConnectionPoolTest, SeparatesHosts) {
+    {
+        auto a = pool->acquire("http", "localhost:8090");
+        auto b = pool->acquire("http", "localhost:8091");
+        EXPECT_NE(a.key(), b.key());
+    }
+    EXPECT_EQ(pool->idleCount(), 2);
+
+    auto lease = pool->acquire("http", "localhost:8091");
+    EXPECT_TRUE(lease.isReused());
+    EXPECT_EQ(pool->idleCount(), 1);
+}
+
+TEST_F(ConnectionPoolTest, ConcurrentLeasesGetDistinctClients) {
+    auto a = pool->acquire("http", "localhost:8090");
+    auto b = pool->acquire("http", "localhost:8090");
+    EXPECT_NE(&a.client(), &b.client());
+}
+
+TEST_F(ConnectionPoolTest, RebuildsClientWhenTimeoutsChange) {
+    {
+        auto lease = pool->acquire("http", "localhost:8090");
+    }
+
+    context->setReadTimeout(context->getReadTimeout() + 1);
+
+    auto lease = pool->acquire("http", "localhost:8090");
+    EXPECT_FALSE(lease.isReused());
+    EXPECT_EQ(pool->idleCount(), 0);
+}
+
+TEST_F(ConnectionPoolTest, DiscardedLeaseIsNotPooled) {
+    {
+        auto lease = pool->acquire("http", "localhost:8090");
+        lease.discard();
+    }
+    EXPECT_EQ(pool->idleCount(), 0);
+}
+
+TEST_F(ConnectionPoolTest, CarriesResolveFailureOnLease) {
+    auto lease = pool->acquire("http", "unresolvable.invalid:8090");
+    EXPECT_FALSE(lease.resolveError().empty());
+    lease.discard();
+
+    auto again = pool->acquire("http", "unresolvable.invalid:8090");
+    EXPECT_FALSE(again.resolveError().empty());
+    EXPECT_EQ(pool->getDnsCache().size(), 1u);
+
+    auto resolved = pool->acquire("http", "localhost:8090");
+    EXPECT_TRUE(resolved.resolveError().empty());
+}
+
+TEST_F(ConnectionPoolTest, UnpinWalksCachedAddressesThenFallsBack) {
+    size_t addresses = pool->getDnsCache().resolve("localhost").addresses.size();
+    ASSERT_GT(addresses, 0u);
+
+    auto lease = pool->acquire("http", "localhost:8090");
+    for (size_t i = 0; i < addresses; ++i) {
+        EXPECT_TRUE(lease.unpin());
+    }
+    EXPECT_FALSE(lease.unpin());
+}
+
+TEST_F(ConnectionPoolTest, CapsIdleClientsPerHost) {
+    httplib::Client* newest = nullptr;
+    {
+        std::vector<ConnectionPool::Lease> leases;
+        for (size_t i = 0; i < ConnectionPool::kMaxIdlePerHost + 8; ++i) {
+            leases.push_back(pool->acquire("http", "localhost:8090"));
+        }
+        newest = &leases.back().client();
+        auto other = pool->acquire("http", "localhost:8091");
+        for (auto& lease : leases) {
+            lease = ConnectionPool::Lease();
+        }
+    }
+    EXPECT_EQ(pool->idleCount(), ConnectionPool::kMaxIdlePerHost + 1);
+
+    auto lease = pool->acquire("http", "localhost:8090");
+    EXPECT_EQ(&lease.client(), newest);
+}
+
+TEST_F(ConnectionPoolTest, ZeroIdleTimeoutDisablesPooling) {
+    context->setIdleTimeout(0);
+    {
+        auto lease = pool->acquire("http", "localhost:8090");
+    }
+    EXPECT_EQ(pool->idleCount(), 0);
+}
+
+}
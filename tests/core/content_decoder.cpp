@@ -0,0 +1,127 @@
+﻿#include "services/content_decoder.h"
+
+#include <string>
+#include <gtest/gtest.h>
+
+#ifdef LUNARICA_ZLIB_SUPPORT
+#include <zlib.h>
+#endif
+
+#ifdef LUNARICA_BROTLI_ENCODER
+#include <brotli/encode.h>
+#endif
+
+namespace lunarica {
+
+namespace {
+
+std::string sampleBody() {
+    std::string body = "[";
+    for (int i = 0; i < 5000; ++i) {
+        body += (i > 0 ? "," : "") + std::string("{\"id\":") + std::to_string(i) + ",\"name\":\"item\"}";
+    }
+    return body + "]";
+}
+
+std::string decode(ContentDecoder& decoder, const std::string& encoded, size_t chunkSize, bool& ok) {
+    std::string result;
+    auto sink = [&](const char* data, size_t length) {
+        result.append(data, length);
+        return true;
+    };
+    ok = true;
+    for (size_t offset = 0; ok && offset < encoded.size(); offset += chunkSize) {
+        ok = decoder.feed(encoded.data() + offset, std::min(chunkSize, encoded.size() - offset), sink);
+    }
+    ok = ok && decoder.finish(sink);
+    return result;
+}
+
+#ifdef LUNARICA_ZLIB_SUPPORT
+std::string zlibCompress(const std::string& input, int windowBits) {
+    z_stream stream{};
+    deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY);
+    std::string output(deflateBound(&stream, input.size()) + 32, '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+    stream.avail_out = static_cast<uInt>(output.size());
+    deflate(&stream, Z_FINISH);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+    return output;
+}
+#endif
+
+}
+
+TEST(ContentDecoderTest, IdentityAndUnknownEncodings) {
+    std::string error;
+    EXPECT_EQ(ContentDecoder::create("", error), nullptr);
+    EXPECT_EQ(ContentDecoder::create(" identity ", error), nullptr);
+    EXPECT_TRUE(error.empty());
+
+    EXPECT_EQ(ContentDecoder::create("zstd", error), nullptr);
+    EXPECT_NE(error.find("zstd"), std::string::npos);
+}
+
+#ifdef LUNARICA_ZLIB_SUPPORT
+TEST(ContentDecoderTest, InflatesGzipAndDeflateAcrossChunks) {
+    std::string body = sampleBody();
+    std::string error;
+
+    for (int windowBits : {15 + 16, 15, -15}) {
+        std::string encoded = zlibCompress(body, windowBits);
+        ASSERT_LT(encoded.size(), body.size() / 4);
+
+        for (size_t chunkSize : {size_t(1), size_t(7), size_t(4096), encoded.size()}) {
+            auto decoder = ContentDecoder::create(windowBits > 15 ? "gzip" : "Deflate", error);
+            ASSERT_NE(decoder, nullptr);
+            bool ok = false;
+            EXPECT_EQ(decode(*decoder, encoded, chunkSize, ok), body) << windowBits << " / " << chunkSize;
+            EXPECT_TRUE(ok) << decoder->error();
+        }
+    }
+
+    EXPECT_NE(ContentDecoder::acceptEncoding().find("gzip"), std::string::npos);
+}
+
+TEST(ContentDecoderTest, ReportsTruncatedAndCorruptStreams) {
+    std::string encoded = zlibCompress(sampleBody(), 15 + 16);
+    std::string error;
+    bool ok = true;
+
+    auto truncated = ContentDecoder::create("gzip", error);
+    decode(*truncated, encoded.substr(0, encoded.size() / 2), 512, ok);
+    EXPECT_FALSE(ok);
+    EXPECT_NE(truncated->error().find("truncated"), std::string::npos);
+
+    auto corrupt = ContentDecoder::create("gzip", error);
+    decode(*corrupt, "this is not gzip", 512, ok);
+    EXPECT_FALSE(ok);
+    EXPECT_NE(corrupt->error().find("invalid gzip"), std::string::npos);
+}
+#endif
+
+#if defined(LUNARICA_BROTLI_SUPPORT) && defined(LUNARICA_BROTLI_ENCODER)
+TEST(ContentDecoderTest, DecodesBrotliAcrossChunks) {
+    std::string body = sampleBody();
+    std::string encoded(BrotliEncoderMaxCompressedSize(body.size()), '\0');
+    size_t encodedSize = encoded.size();
+    ASSERT_TRUE(BrotliEncoderCompress(BROTLI_DEFAULT_QUALITY, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT, body.size(),
+                                      reinterpret_cast<const uint8_t*>(body.data()), &encodedSize,
+                                      reinterpret_cast<uint8_t*>(&encoded[0])));
+    encoded.resize(encodedSize);
+
+    std::string error;
+    for (size_t chunkSize : {size_t(1), size_t(100), encoded.size()}) {
+        auto decoder = ContentDecoder::create("br", error);
+        ASSERT_NE(decoder, nullptr);
+        bool ok = false;
+        EXPECT_EQ(decode(*decoder, encoded, chunkSize, ok), body) << chunkSize;
+        EXPECT_TRUE(ok) << decoder->error();
+    }
+}
+#endif
+
+}
@@ -0,0 +1,55 @@
+﻿#include "services/content_encoder.h"
+#include "services/content_decoder.h"
+
+#include <string>
+#include <gtest/gtest.h>
+
+namespace lunarica {
+
+#ifdef LUNARICA_ZLIB_SUPPORT
+TEST(ContentEncoderTest, StreamsGzipThatRoundTrips) {
+    std::string body;
+    for (int i = 0; i < 20000; ++i) {
+        body += "{\"id\":" + std::to_string(i) + ",\"event\":\"import\"}\n";
+    }
+
+    std::string error;
+    auto encoder = ContentEncoder::create(6, error);
+    ASSERT_NE(encoder, nullptr) << error;
+
+    std::string encoded;
+    size_t writes = 0;
+    auto sink = [&](const char* data, size_t length) {
+        encoded.append(data, length);
+        writes++;
+        return true;
+    };
+    for (size_t offset = 0; offset < body.size(); offset += 1000) {
+        ASSERT_TRUE(encoder->feed(body.data() + offset, std::min<size_t>(1000, body.size() - offset), sink));
+    }
+    ASSERT_TRUE(encoder->finish(sink));
+    EXPECT_LT(encoded.size(), body.size() / 5);
+    EXPECT_GT(writes, 0u);
+    EXPECT_EQ(ContentEncoder::compress(body, 6, error), encoded);
+
+    auto decoder = ContentDecoder::create("gzip", error);
+    std::string decoded;
+    auto collect = [&](const char* data, size_t length) {
+        decoded.append(data, length);
+        return true;
+    };
+    ASSERT_TRUE(decoder->feed(encoded.data(), encoded.size(), collect));
+    ASSERT_TRUE(decoder->finish(collect));
+    EXPECT_EQ(decoded, body);
+}
+
+TEST(ContentEncoderTest, RejectsInvalidLevels) {
+    std::string error;
+    EXPECT_EQ(ContentEncoder::create(0, error), nullptr);
+    EXPECT_EQ(ContentEncoder::create(10, error), nullptr);
+    EXPECT_FALSE(error.empty());
+    EXPECT_TRUE(ContentEncoder::available());
+}
+#endif
+
+}
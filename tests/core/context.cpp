@@ -108,6 +108,10 @@ TEST(ContextTest, TimeoutSettings) {
 
     context.setReadTimeout(20);
     EXPECT_EQ(context.getReadTimeout(), 20);
+
+    EXPECT_EQ(context.getIdleTimeout(), 30);
+    context.setIdleTimeout(90);
+    EXPECT_EQ(context.getIdleTimeout(), 90);
 }
 
 TEST(ContextTest, ExitFlag) {
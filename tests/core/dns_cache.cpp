@@ -0,0 +1,91 @@
+﻿#include "services/dns_cache.h"
+
+#include <atomic>
+#include <thread>
+#include <gtest/gtest.h>
+
+namespace lunarica {
+
+namespace {
+
+DnsCache::Lookup countingLookup(std::atomic<int>& calls, std::chrono::milliseconds delay = std::chrono::milliseconds(0)) {
+    return [&calls, delay](const std::string& hostname) {
+        calls++;
+        std::this_thread::sleep_for(delay);
+        ResolveResult result;
+        result.ok = hostname != "missing.invalid";
+        result.address = result.ok ? "10.0.0.1" : "";
+        if (result.ok) {
+            result.addresses = {result.address, "10.0.0.2"};
+        }
+        result.error = result.ok ? "" : "not found";
+        result.elapsed = delay;
+        return result;
+    };
+}
+
+}
+
+TEST(DnsCacheTest, CachesAnswersUntilTheyExpire) {
+    std::atomic<int> calls{0};
+    DnsCache cache(countingLookup(calls));
+
+    ResolveResult first = cache.resolve("api.example.com");
+    ResolveResult second = cache.resolve("api.example.com");
+    EXPECT_TRUE(first.ok);
+    EXPECT_FALSE(first.cached);
+    EXPECT_TRUE(second.cached);
+    EXPECT_EQ(second.address, "10.0.0.1");
+    EXPECT_EQ(second.addresses.size(), 2u);
+    EXPECT_EQ(calls, 1);
+
+    EXPECT_FALSE(cache.resolve("missing.invalid").ok);
+    EXPECT_TRUE(cache.resolve("missing.invalid").cached);
+    EXPECT_EQ(calls, 2);
+
+    cache.setTtl(std::chrono::seconds(0), std::chrono::seconds(0));
+    cache.clear();
+    EXPECT_EQ(cache.size(), 0u);
+    cache.resolve("api.example.com");
+    EXPECT_FALSE(cache.resolve("api.example.com").cached);
+    EXPECT_EQ(calls, 4);
+}
+
+TEST(DnsCacheTest, PrefetchResolvesInBackgroundOnce) {
+    std::atomic<int> calls{0};
+    DnsCache cache(countingLookup(calls, std::chrono::milliseconds(50)));
+
+    cache.prefetch("api.example.com");
+    cache.prefetch("api.example.com");
+    cache.prefetch("127.0.0.1");
+
+    std::vector<std::thread> threads;
+    std::atomic<int> cached{0};
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&] {
+            if (cache.resolve("api.example.com").cached) {
+                cached++;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(cached, 4);
+    EXPECT_EQ(cache.size(), 1u);
+}
+
+TEST(DnsResolverTest, CountsResolvedAddresses) {
+    ResolveResult single = DnsResolver().resolve("127.0.0.1");
+    ASSERT_TRUE(single.ok);
+    EXPECT_EQ(single.address, "127.0.0.1");
+    EXPECT_EQ(single.addresses, std::vector<std::string>{"127.0.0.1"});
+
+    ResolveResult missing = DnsResolver().resolve("missing.invalid");
+    EXPECT_FALSE(missing.ok);
+    EXPECT_TRUE(missing.addresses.empty());
+}
+
+}
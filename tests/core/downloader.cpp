@@ -0,0 +1,130 @@
+﻿#include "services/downloader.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <gtest/gtest.h>
+#include "../utils/test_http_server.h"
+
+namespace lunarica {
+
+namespace {
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+}
+
+class DownloaderTest : public ::testing::Test {
+protected:
+    std::shared_ptr<Context> context;
+    std::shared_ptr<HttpService> httpService;
+    std::unique_ptr<testing::TestHttpServer> testServer;
+    std::ostringstream output;
+    std::string target;
+
+    void SetUp() override {
+        context = std::make_shared<Context>();
+        auto sink = std::make_shared<OutputSink>(output);
+        httpService = std::make_shared<HttpService>(context, std::make_shared<JsonFormatter>(sink), sink);
+
+        testServer = std::make_unique<testing::TestHttpServer>(8093);
+        testServer->start();
+
+        context->setUrl(testServer->getBaseUrl());
+        target = (std::filesystem::temp_directory_path() / "lunarica_download_test.bin").string();
+        std::filesystem::remove(target);
+        std::filesystem::remove(Downloader::statePath(target));
+    }
+
+    void TearDown() override {
+        testServer->stop();
+        std::filesystem::remove(target);
+        std::filesystem::remove(Downloader::statePath(target));
+    }
+};
+
+TEST_F(DownloaderTest, FetchesRangesInParallel) {
+    Downloader downloader(httpService);
+    DownloadOptions options;
+    options.connections = 4;
+
+    DownloadReport report = downloader.run(httpService->prepareRequest("GET", "/file"), target, options, nullptr);
+
+    ASSERT_TRUE(report.completed) << report.error;
+    EXPECT_TRUE(report.ranged);
+    EXPECT_EQ(report.progress.connections, 4u);
+    EXPECT_EQ(report.progress.received, testing::TestHttpServer::fileContent().size());
+    EXPECT_TRUE(readFile(target) == testing::TestHttpServer::fileContent());
+    EXPECT_FALSE(std::filesystem::exists(Downloader::statePath(target)));
+}
+
+TEST_F(DownloaderTest, ResumesFromStateFile) {
+    const std::string& content = testing::TestHttpServer::fileContent();
+    uint64_t half = content.size() / 2;
+    {
+        std::ofstream out(target, std::ios::binary);
+        out.write(content.data(), static_cast<std::streamsize>(half));
+        out << std::string(content.size() - half, 'x');
+    }
+
+    DownloadState state;
+    state.url = httpService->prepareRequest("GET", "/file").url;
+    state.size = content.size();
+    state.validator = "\"v1\"";
+    state.segments = DownloadState::split(content.size(), 2);
+    state.segments[0].done = half;
+    ASSERT_TRUE(state.save(Downloader::statePath(target)));
+
+    Downloader downloader(httpService);
+    DownloadReport report = downloader.run(httpService->prepareRequest("GET", "/file"), target, DownloadOptions(), nullptr);
+
+    ASSERT_TRUE(report.completed) << report.error;
+    EXPECT_EQ(report.progress.resumed, half);
+    EXPECT_EQ(report.progress.received, content.size() - half);
+    EXPECT_EQ(report.progress.connections, 1u);
+    EXPECT_TRUE(readFile(target) == content);
+}
+
+TEST_F(DownloaderTest, FallsBackToSingleStream) {
+    Downloader downloader(httpService);
+    DownloadReport report = downloader.run(httpService->prepareRequest("GET", "/file-no-ranges"), target,
+                                           DownloadOptions(), nullptr);
+
+    ASSERT_TRUE(report.completed) << report.error;
+    EXPECT_FALSE(report.ranged);
+    EXPECT_TRUE(readFile(target) == testing::TestHttpServer::fileContent());
+}
+
+TEST(DownloadStateTest, SplitsAndRoundTrips) {
+    auto segments = DownloadState::split(10, 3);
+    ASSERT_EQ(segments.size(), 3u);
+    EXPECT_EQ(segments[0].end, 3u);
+    EXPECT_EQ(segments[2].begin, 6u);
+    EXPECT_EQ(segments[2].end, 10u);
+    EXPECT_EQ(DownloadState::split(2, 8).size(), 2u);
+
+    DownloadState state;
+    state.url = "http://example.com/a?b=c d";
+    state.size = 10;
+    state.validator = "W/\"abc\"";
+    state.segments = segments;
+    state.segments[1].done = 2;
+
+    std::string path = (std::filesystem::temp_directory_path() / "lunarica_state_test.download").string();
+    ASSERT_TRUE(state.save(path));
+
+    DownloadState loaded;
+    ASSERT_TRUE(loaded.load(path));
+    EXPECT_EQ(loaded.url, state.url);
+    EXPECT_EQ(loaded.validator, state.validator);
+    EXPECT_EQ(loaded.segments.size(), 3u);
+    EXPECT_EQ(loaded.completed(), 2u);
+    std::filesystem::remove(path);
+}
+
+}
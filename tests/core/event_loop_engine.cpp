@@ -0,0 +1,217 @@
+﻿#include "services/event_loop_engine.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <gtest/gtest.h>
+#include "../utils/test_http_server.h"
+
+namespace lunarica {
+
+namespace {
+
+struct Framed {
+    int status = 0;
+    size_t body = 0;
+    size_t consumed = 0;
+    bool keepAlive = false;
+    bool done = false;
+    bool failed = false;
+};
+
+Framed frame(const std::string& wire, size_t chunkSize, bool headRequest = false) {
+    ResponseFramer framer;
+    framer.reset(headRequest);
+
+    Framed result;
+    for (size_t offset = 0; offset < wire.size() && !framer.done() && !framer.failed(); offset += chunkSize) {
+        result.consumed += framer.feed(wire.data() + offset, std::min(chunkSize, wire.size() - offset));
+    }
+    result.done = framer.done() || framer.finishAtEof();
+    result.failed = framer.failed();
+    result.status = framer.status();
+    result.body = framer.bodyBytes();
+    result.keepAlive = framer.keepAlive();
+    return result;
+}
+
+}
+
+TEST(ResponseFramerTest, FramesContentLengthAndChunkedBodies) {
+    std::string fixed = "HTTP/1.1 200 OK\r\nContent-Length: 11\r\nContent-Type: text/plain\r\n\r\nhello world";
+    std::string chunked = "HTTP/1.1 201 Created\r\ntransfer-encoding: chunked\r\n\r\n"
+                          "5;ext=1\r\nhello\r\n6\r\n world\r\n0\r\nX-Trailer: yes\r\n\r\n";
+
+    for (size_t chunkSize : {size_t(1), size_t(2), size_t(7), size_t(4096)}) {
+        Framed first = frame(fixed, chunkSize);
+        EXPECT_TRUE(first.done) << "chunk size " << chunkSize;
+        EXPECT_EQ(first.status, 200);
+        EXPECT_EQ(first.body, 11u);
+        EXPECT_TRUE(first.keepAlive);
+
+        Framed second = frame(chunked, chunkSize);
+        EXPECT_TRUE(second.done) << "chunk size " << chunkSize;
+        EXPECT_EQ(second.status, 201);
+        EXPECT_EQ(second.body, 11u);
+        EXPECT_EQ(second.consumed, chunked.size());
+    }
+}
+
+TEST(ResponseFramerTest, HandlesBodilessAndCloseDelimitedResponses) {
+    Framed interim = frame("HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 204 No Content\r\n\r\n", 3);
+    EXPECT_TRUE(interim.done);
+    EXPECT_EQ(interim.status, 204);
+
+    Framed head = frame("HTTP/1.1 200 OK\r\nContent-Length: 500\r\n\r\n", 64, true);
+    EXPECT_TRUE(head.done);
+    EXPECT_EQ(head.body, 0u);
+
+    Framed untilClose = frame("HTTP/1.0 200 OK\r\n\r\nstreamed until eof", 5);
+    EXPECT_TRUE(untilClose.done);
+    EXPECT_EQ(untilClose.body, 18u);
+    EXPECT_FALSE(untilClose.keepAlive);
+
+    Framed closing = frame("HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 0\r\n\r\n", 8);
+    EXPECT_TRUE(closing.done);
+    EXPECT_FALSE(closing.keepAlive);
+
+    EXPECT_TRUE(frame("SSH-2.0-OpenSSH\r\n\r\n", 64).failed);
+    EXPECT_TRUE(frame("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n", 64).failed);
+}
+
+#ifdef __linux__
+
+class EventLoopEngineTest : public ::testing::TestWithParam<EngineBackend> {
+protected:
+    std::unique_ptr<testing::TestHttpServer> testServer;
+
+    void SetUp() override {
+        if (EventLoopEngine::resolveBackend(GetParam()) != GetParam()) {
+            GTEST_SKIP() << EventLoopEngine::backendName(GetParam()) << " is not supported here";
+        }
+        testServer = std::make_unique<testing::TestHttpServer>(8097);
+        testServer->start();
+    }
+
+    void TearDown() override {
+        if (testServer) {
+            testServer->stop();
+        }
+    }
+
+    EngineOptions optionsFor(size_t requests, size_t connections, size_t threads = 1) {
+        EngineOptions options;
+        options.requests = requests;
+        options.connections = connections;
+        options.threads = threads;
+        options.backend = GetParam();
+        return options;
+    }
+
+    EventLoopEngine::Target target(const std::string& path, uint16_t port = 8097) {
+        HttpRequest request;
+        request.method = "GET";
+        request.host = "localhost:" + std::to_string(port);
+        request.path = path;
+
+        EventLoopEngine::Target result;
+        result.address = DnsResolver().resolve("localhost").address;
+        result.port = port;
+        result.request = EventLoopEngine::serialize(request);
+        return result;
+    }
+};
+
+TEST_P(EventLoopEngineTest, ClosedLoopReusesConnectionsAcrossLoops) {
+    EngineOptions options = optionsFor(300, 12, 3);
+
+    std::mutex mutex;
+    std::map<int, size_t> statuses;
+    std::atomic<size_t> loops{0};
+    std::string error;
+
+    EventLoopEngine engine(target("/posts/1"));
+    ASSERT_TRUE(engine.run(options, [&](size_t loop, const EngineSample& sample) {
+        std::lock_guard<std::mutex> lock(mutex);
+        statuses[sample.error == httplib::Error::Success ? sample.status : -1]++;
+        loops |= size_t(1) << loop;
+        EXPECT_GE(sample.received, sample.sent);
+    }, error)) << error;
+
+    EXPECT_EQ(statuses[200], 300u);
+    EXPECT_EQ(statuses.size(), 1u);
+    EXPECT_EQ(loops.load(), 7u);
+}
+
+TEST_P(EventLoopEngineTest, ReportsRefusedConnectionsAndReadTimeouts) {
+    EngineOptions options = optionsFor(6, 2);
+    options.readTimeout = std::chrono::milliseconds(200);
+
+    std::mutex mutex;
+    std::map<httplib::Error, size_t> errors;
+    auto observer = [&](size_t, const EngineSample& sample) {
+        std::lock_guard<std::mutex> lock(mutex);
+        errors[sample.error]++;
+    };
+    std::string error;
+
+    EventLoopEngine refused(target("/posts/1", 1));
+    ASSERT_TRUE(refused.run(options, observer, error)) << error;
+    EXPECT_EQ(errors[httplib::Error::Connection], 6u);
+
+    errors.clear();
+    options.requests = 2;
+    EventLoopEngine slow(target("/delay"));
+    auto started = std::chrono::steady_clock::now();
+    ASSERT_TRUE(slow.run(options, observer, error)) << error;
+    EXPECT_EQ(errors[httplib::Error::Read], 2u);
+    EXPECT_LT(std::chrono::steady_clock::now() - started, std::chrono::seconds(2));
+}
+
+TEST_P(EventLoopEngineTest, OpenLoopSendsOnSchedule) {
+    EngineOptions options = optionsFor(20, 4, 2);
+
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> slot{0};
+    options.schedule = [&](EngineOptions::Clock::time_point& intended) {
+        size_t next = slot++;
+        intended = start + std::chrono::milliseconds(5 * next);
+        return next < 20;
+    };
+
+    std::atomic<size_t> completed{0};
+    std::atomic<size_t> early{0};
+    std::string error;
+    EventLoopEngine engine(target("/posts/1"));
+    ASSERT_TRUE(engine.run(options, [&](size_t, const EngineSample& sample) {
+        completed += sample.status == 200;
+        early += sample.sent < sample.intended;
+    }, error)) << error;
+
+    EXPECT_EQ(completed.load(), 20u);
+    EXPECT_EQ(early.load(), 0u);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(95));
+}
+
+TEST_P(EventLoopEngineTest, ReceivesLargeChunkedBodies) {
+    EngineOptions options = optionsFor(8, 4);
+
+    std::atomic<size_t> completed{0};
+    std::string error;
+    EventLoopEngine engine(target("/file-no-ranges"));
+    ASSERT_TRUE(engine.run(options, [&](size_t, const EngineSample& sample) {
+        completed += sample.status == 200;
+    }, error)) << error;
+    EXPECT_EQ(completed.load(), 8u);
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends, EventLoopEngineTest,
+                         ::testing::Values(EngineBackend::Epoll, EngineBackend::IoUring),
+                         [](const ::testing::TestParamInfo<EngineBackend>& info) {
+                             return std::string(EventLoopEngine::backendName(info.param));
+                         });
+
+#endif
+
+}
@@ -0,0 +1,83 @@
+﻿#include "services/event_stream.h"
+
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+namespace lunarica {
+
+namespace {
+
+std::vector<std::string> decode(EventStreamDecoder::Format format, const std::string& body, size_t chunkSize) {
+    EventStreamDecoder decoder(format);
+    std::vector<std::string> events;
+    auto handler = [&](const StreamEvent& event) {
+        events.push_back(std::string(event.type) + "|" + std::string(event.id) + "|" + std::string(event.data));
+        return true;
+    };
+    for (size_t offset = 0; offset < body.size(); offset += chunkSize) {
+        decoder.feed(body.data() + offset, std::min(chunkSize, body.size() - offset), handler);
+    }
+    decoder.finish(handler);
+    return events;
+}
+
+}
+
+TEST(EventStreamDecoderTest, DetectsFormat) {
+    EXPECT_EQ(EventStreamDecoder::detect("text/event-stream; charset=utf-8"), EventStreamDecoder::Format::Sse);
+    EXPECT_EQ(EventStreamDecoder::detect("application/x-ndjson"), EventStreamDecoder::Format::Lines);
+}
+
+TEST(EventStreamDecoderTest, ParsesServerSentEvents) {
+    std::string body =
+        ": keep-alive\n\n"
+        "data: {\"n\": 1}\n\n"
+        "event: update\r\nid: 7\r\ndata: first\r\ndata:second\r\n\r\n"
+        "event: ignored\n\n"
+        "data: {\"n\": 3}\rretry: 100\r\r"
+        "data: tail";
+
+    std::vector<std::string> expected = {
+        "message||{\"n\": 1}",
+        "update|7|first\nsecond",
+        "message|7|{\"n\": 3}",
+        "message|7|tail"
+    };
+    for (size_t chunkSize : {1, 2, 5, 16, 1024}) {
+        EXPECT_EQ(decode(EventStreamDecoder::Format::Sse, body, chunkSize), expected) << "chunk size " << chunkSize;
+    }
+}
+
+TEST(EventStreamDecoderTest, SplitsNewlineDelimitedRecords) {
+    std::string body = "{\"a\":1}\n{\"a\":2}\r\n\n  \n{\"a\":3}";
+    std::vector<std::string> expected = {"||{\"a\":1}", "||{\"a\":2}", "||{\"a\":3}"};
+    for (size_t chunkSize : {1, 3, 1024}) {
+        EXPECT_EQ(decode(EventStreamDecoder::Format::Lines, body, chunkSize), expected) << "chunk size " << chunkSize;
+    }
+}
+
+TEST(EventStreamDecoderTest, StopsWhenHandlerDeclinesAndKeepsMemoryBounded) {
+    EventStreamDecoder decoder(EventStreamDecoder::Format::Lines);
+    size_t seen = 0;
+    auto handler = [&](const StreamEvent&) {
+        return ++seen < 3;
+    };
+
+    std::string line = "{\"value\":\"" + std::string(100, 'x') + "\"}\n";
+    bool keepGoing = true;
+    for (int i = 0; i < 100000 && keepGoing; ++i) {
+        keepGoing = decoder.feed(line.data(), line.size(), handler);
+    }
+    EXPECT_EQ(seen, 3u);
+
+    EventStreamDecoder sse(EventStreamDecoder::Format::Sse);
+    std::string event = "data: {\"value\":\"" + std::string(100, 'x') + "\"}\n\n";
+    for (int i = 0; i < 100000; ++i) {
+        sse.feed(event.data(), 7, [](const StreamEvent&) { return true; });
+        sse.feed(event.data() + 7, event.size() - 7, [](const StreamEvent&) { return true; });
+    }
+    EXPECT_LT(sse.buffered(), 1024u);
+}
+
+}
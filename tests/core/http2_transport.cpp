@@ -0,0 +1,195 @@
+﻿#ifndef _WIN32
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <gtest/gtest.h>
+#include "services/http2_transport.h"
+#include "../utils/test_h2c_server.h"
+
+namespace lunarica {
+
+namespace {
+
+ResolveResult slowLookup(const std::string& hostname) {
+    if (hostname == "slow.invalid") {
+        std::this_thread::sleep_for(std::chrono::milliseconds(600));
+    }
+    ResolveResult result;
+    result.error = "no such host";
+    return result;
+}
+
+}
+
+class Http2TransportTest : public ::testing::Test {
+protected:
+    DnsCache dns{slowLookup};
+    TlsSessionCache sessions;
+    std::unique_ptr<Http2Transport> transport;
+    std::unique_ptr<testing::TestH2cServer> server;
+    Http2Connection::Endpoint endpoint{"127.0.0.1", 8094, false};
+
+    void SetUp() override {
+        server = std::make_unique<testing::TestH2cServer>(8094);
+        server->start();
+        transport = std::make_unique<Http2Transport>(dns, sessions);
+    }
+
+    void TearDown() override {
+        transport.reset();
+        server->stop();
+    }
+
+    Http2Result fetch(const std::string& method, const std::string& path, const Http2Handlers& handlers = {},
+                      const std::string& body = "") {
+        Http2Request request;
+        request.method = method;
+        request.scheme = "http";
+        request.authority = "127.0.0.1:8094";
+        request.path = path;
+        request.headers = {{"Accept", "*/*"}, {"Connection", "keep-alive"}};
+        if (!body.empty()) {
+            request.body = [&body](size_t offset) {
+                return std::string_view(body).substr(offset, 100000);
+            };
+        }
+
+        Http2Result result;
+        EXPECT_TRUE(transport->execute(endpoint, request, handlers, 3, 5, result));
+        return result;
+    }
+};
+
+TEST_F(Http2TransportTest, FetchesOverPriorKnowledgeH2c) {
+    Http2Result result = fetch("GET", "/posts/1");
+
+    ASSERT_TRUE(result.ok()) << result.error;
+    EXPECT_TRUE(result.newConnection);
+    EXPECT_EQ(result.response.status, 200);
+    EXPECT_NE(result.response.body.find("\"protocol\": \"h2c\""), std::string::npos);
+    EXPECT_EQ(result.response.headers[0], (std::pair<std::string, std::string>("content-type", "application/json")));
+
+    Http2Result again = fetch("GET", "/posts/1");
+    ASSERT_TRUE(again.ok()) << again.error;
+    EXPECT_FALSE(again.newConnection);
+    EXPECT_EQ(server->connectionCount(), 1u);
+}
+
+TEST_F(Http2TransportTest, MultiplexesConcurrentRequestsOnOneConnection) {
+    auto started = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    std::atomic<int> succeeded{0};
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&] {
+            Http2Result result = fetch("GET", "/slow");
+            if (result.ok() && result.response.body == "slow") {
+                succeeded++;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - started;
+
+    EXPECT_EQ(succeeded, 8);
+    EXPECT_LT(elapsed, std::chrono::milliseconds(8 * 200 / 2));
+    EXPECT_EQ(server->connectionCount(), 1u);
+    EXPECT_EQ(transport->connectionCount(), 1u);
+}
+
+TEST_F(Http2TransportTest, SlowConnectDoesNotBlockOtherHosts) {
+    std::thread slow([this] {
+        Http2Request request;
+        request.method = "GET";
+        request.scheme = "http";
+        request.authority = "slow.invalid:8094";
+        request.path = "/posts/1";
+        Http2Result result;
+        EXPECT_TRUE(transport->execute({"slow.invalid", 8094, false}, request, {}, 3, 5, result));
+        EXPECT_FALSE(result.ok());
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    auto started = std::chrono::steady_clock::now();
+    Http2Result result = fetch("GET", "/posts/1");
+    auto elapsed = std::chrono::steady_clock::now() - started;
+    slow.join();
+
+    ASSERT_TRUE(result.ok()) << result.error;
+    EXPECT_LT(elapsed, std::chrono::milliseconds(300));
+}
+
+TEST_F(Http2TransportTest, StreamsLargeBodiesBothWays) {
+    std::string body(3 << 20, 'u');
+    Http2Result echoed = fetch("POST", "/echo", {}, body);
+    ASSERT_TRUE(echoed.ok()) << echoed.error;
+    EXPECT_EQ(echoed.response.body, "POST:" + body);
+    EXPECT_EQ(echoed.uploaded, body.size());
+
+    std::string received;
+    bool sawHeaders = false;
+    Http2Handlers handlers;
+    handlers.onHeaders = [&](const Http2Result& result) {
+        sawHeaders = result.response.status == 200;
+        return true;
+    };
+    handlers.onBody = [&](const char* data, size_t length) {
+        received.append(data, length);
+        return true;
+    };
+    Http2Result large = fetch("GET", "/large", handlers);
+    ASSERT_TRUE(large.ok()) << large.error;
+    EXPECT_TRUE(sawHeaders);
+    EXPECT_TRUE(large.response.body.empty());
+    EXPECT_EQ(received, testing::TestH2cServer::largeContent());
+}
+
+TEST_F(Http2TransportTest, SlowConsumerDoesNotStallOtherStreams) {
+    std::atomic<bool> consuming{false};
+    std::atomic<bool> foreignThread{false};
+    std::thread slow([&] {
+        auto owner = std::this_thread::get_id();
+        Http2Handlers handlers;
+        handlers.onBody = [&](const char*, size_t) {
+            foreignThread = foreignThread || std::this_thread::get_id() != owner;
+            if (!consuming.exchange(true)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            }
+            return true;
+        };
+        Http2Result result = fetch("GET", "/large", handlers);
+        EXPECT_TRUE(result.ok()) << result.error;
+    });
+    while (!consuming) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    Http2Result result = fetch("GET", "/posts/1");
+    auto elapsed = std::chrono::steady_clock::now() - started;
+    slow.join();
+
+    ASSERT_TRUE(result.ok()) << result.error;
+    EXPECT_LT(elapsed, std::chrono::milliseconds(250));
+    EXPECT_FALSE(foreignThread);
+    EXPECT_EQ(server->connectionCount(), 1u);
+}
+
+TEST_F(Http2TransportTest, CancelsFromHandlersAndKeepsConnection) {
+    Http2Handlers handlers;
+    handlers.onBody = [](const char*, size_t) {
+        return false;
+    };
+    Http2Result canceled = fetch("GET", "/large", handlers);
+    EXPECT_EQ(canceled.status, Http2Result::Status::Canceled);
+
+    Http2Result next = fetch("GET", "/posts/1");
+    EXPECT_TRUE(next.ok()) << next.error;
+    EXPECT_EQ(server->connectionCount(), 1u);
+}
+
+}
+
+#endif
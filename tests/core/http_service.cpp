@@ -1,10 +1,13 @@
 ﻿#include "services/http_service.h"
 
+#include <filesystem>
+#include <fstream>
 #include <memory>
 #include <string>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include "../utils/test_h2c_server.h"
 #include "../utils/test_http_server.h"
 #include "utils/encoding_utils.h"
 
@@ -16,32 +19,39 @@ protected:
     std::shared_ptr<JsonFormatter> formatter;
     std::unique_ptr<HttpService> httpService;
     std::unique_ptr<testing::TestHttpServer> testServer;
-    std::streambuf* originalCoutBuffer;
     std::ostringstream outputStream;
+    std::shared_ptr<OutputSink> sink;
 
     void SetUp() override {
         context = std::make_shared<Context>();
-        formatter = std::make_shared<JsonFormatter>();
-        httpService = std::make_unique<HttpService>(context, formatter);
+        sink = std::make_shared<OutputSink>(outputStream);
+        formatter = std::make_shared<JsonFormatter>(sink);
+        httpService = std::make_unique<HttpService>(context, formatter, sink);
 
         testServer = std::make_unique<testing::TestHttpServer>(8090);
         testServer->start();
 
         context->setUrl(testServer->getBaseUrl());
-
-        originalCoutBuffer = std::cout.rdbuf(outputStream.rdbuf());
     }
 
     void TearDown() override {
-        std::cout.rdbuf(originalCoutBuffer);
         testServer->stop();
     }
 
     std::string getOutput() {
+        sink->flush();
         std::string result = outputStream.str();
         outputStream.str("");
         return result;
     }
+
+    static size_t countOf(const std::string& text, const std::string& needle) {
+        size_t count = 0;
+        for (size_t at = text.find(needle); at != std::string::npos; at = text.find(needle, at + 1)) {
+            count++;
+        }
+        return count;
+    }
 };
 
 TEST_F(HttpServiceTest, GetRequestTest) {
@@ -174,4 +184,267 @@ TEST_F(HttpServiceTest, CompleteURLTest) {
     EXPECT_TRUE(output.find("Making GET request to: " + testUrl) != std::string::npos);
 }
 
+TEST_F(HttpServiceTest, TimingBreakdownTest) {
+    httpService->get("/posts/1");
+
+    std::string output = getOutput();
+    EXPECT_TRUE(output.find("TIMING: dns") != std::string::npos);
+    EXPECT_TRUE(output.find("ttfb") != std::string::npos);
+    EXPECT_TRUE(output.find("(new connection)") != std::string::npos);
+    EXPECT_EQ(output.find("~connect") != std::string::npos, httpService->getLastTiming().connectEstimated);
+    EXPECT_TRUE(output.find("rendered in") != std::string::npos);
+    EXPECT_TRUE(httpService->getLastTiming().newConnection);
+
+    httpService->get("/posts/1");
+
+    output = getOutput();
+    EXPECT_TRUE(output.find("(reused connection)") != std::string::npos);
+    EXPECT_FALSE(httpService->getLastTiming().newConnection);
+    EXPECT_GT(httpService->getLastTiming().render.count(), 0);
+}
+
+TEST_F(HttpServiceTest, StreamedBodyTest) {
+    context->setStreamWindow(4096);
+    httpService->get("/stream");
+
+    std::string output = getOutput();
+    EXPECT_TRUE(output.find("STATUS: 200") != std::string::npos);
+    EXPECT_TRUE(output.find("item-0") != std::string::npos);
+    EXPECT_TRUE(output.find("item-199") != std::string::npos);
+    EXPECT_LT(output.find("BODY:"), output.find("item-0"));
+    EXPECT_TRUE(output.find("Received") != std::string::npos);
+}
+
+TEST_F(HttpServiceTest, InlineLimitKeepsFullBodyForPager) {
+    context->setInlineLimit(1024);
+    httpService->get("/stream");
+
+    std::string output = getOutput();
+    EXPECT_TRUE(output.find("item-0") != std::string::npos);
+    EXPECT_TRUE(output.find("item-199") == std::string::npos);
+    EXPECT_TRUE(output.find("more bytes not shown") != std::string::npos);
+
+    auto stored = httpService->getResponses().latest();
+    ASSERT_TRUE(stored != nullptr);
+    EXPECT_EQ(stored->status, 200);
+    EXPECT_TRUE(stored->body.view().find("item-199") != std::string_view::npos);
+}
+
+TEST_F(HttpServiceTest, CollapsedRenderingAndShow) {
+    context->setCollapseItems(3);
+    httpService->get("/stream");
+
+    std::string output = getOutput();
+    EXPECT_TRUE(output.find("item-2") != std::string::npos);
+    EXPECT_TRUE(output.find("item-3") == std::string::npos);
+    EXPECT_TRUE(output.find("197 more items") != std::string::npos);
+
+    httpService->show("$1[150]");
+    output = getOutput();
+    EXPECT_TRUE(output.find("$1[150]") != std::string::npos);
+    EXPECT_TRUE(output.find("item-150") != std::string::npos);
+}
+
+TEST_F(HttpServiceTest, StoresRecentResponses) {
+    httpService->get("/posts/1");
+    httpService->get("/stream");
+    getOutput();
+
+    ResponseStore& store = httpService->getResponses();
+    ASSERT_EQ(store.entries().size(), 2u);
+    EXPECT_NE(store.get(1)->url.find("/stream"), std::string::npos);
+    EXPECT_NE(store.get(2)->url.find("/posts/1"), std::string::npos);
+
+    httpService->show("$1[42].name");
+    EXPECT_NE(getOutput().find("item-42"), std::string::npos);
+
+    httpService->show("$3");
+    EXPECT_NE(getOutput().find("No stored response $3"), std::string::npos);
+}
+
+TEST_F(HttpServiceTest, QueriesStoredResponses) {
+    httpService->get("/stream");
+    httpService->get("/posts/1");
+    getOutput();
+
+    httpService->query("$2 .[] | select(.id >= 197) | .name");
+    std::string output = getOutput();
+    EXPECT_NE(output.find("item-197"), std::string::npos);
+    EXPECT_NE(output.find("item-199"), std::string::npos);
+    EXPECT_EQ(output.find("item-196"), std::string::npos);
+    EXPECT_NE(output.find("3 results from $2"), std::string::npos);
+
+    httpService->query(".items[");
+    EXPECT_NE(getOutput().find("Invalid query"), std::string::npos);
+}
+
+TEST_F(HttpServiceTest, StreamsServerSentEvents) {
+    httpService->stream("/events");
+    std::string output = getOutput();
+
+    EXPECT_NE(output.find("#1 +"), std::string::npos);
+    EXPECT_NE(output.find("event tick | id 4"), std::string::npos);
+    EXPECT_EQ(countOf(output, "\"seq\""), 5u);
+    EXPECT_NE(output.find("5 events"), std::string::npos);
+    EXPECT_NE(output.find("gap p50"), std::string::npos);
+    EXPECT_TRUE(httpService->getResponses().entries().empty());
+}
+
+TEST_F(HttpServiceTest, StreamsNdjsonUpToLimit) {
+    httpService->stream("/ndjson", 2);
+    std::string output = getOutput();
+
+    EXPECT_EQ(countOf(output, "\"line\""), 2u);
+    EXPECT_EQ(output.find("#3 +"), std::string::npos);
+    EXPECT_NE(output.find("2 events"), std::string::npos);
+    EXPECT_EQ(output.find("Error"), std::string::npos);
+}
+
+TEST_F(HttpServiceTest, UploadsFilesByteForByte) {
+    std::string content;
+    for (int i = 0; i < 300000; ++i) {
+        content += static_cast<char>((i * 7) % 256);
+    }
+    uint32_t hash = 2166136261u;
+    for (char c : content) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    std::string path = (std::filesystem::temp_directory_path() / "lunarica_upload_test.bin").string();
+    {
+        std::ofstream out(path, std::ios::binary);
+        out.write(content.data(), static_cast<std::streamsize>(content.size()));
+    }
+
+    std::string expected = std::to_string(content.size()) + ":" + std::to_string(hash) + ":";
+    httpService->upload("POST", "/upload", path);
+    EXPECT_NE(getOutput().find(expected + "length:application/octet-stream"), std::string::npos);
+
+    context->addHeader("Content-Type", "image/x-test");
+    httpService->upload("POST", "/upload", path, true);
+    EXPECT_NE(getOutput().find(expected + "chunked:image/x-test"), std::string::npos);
+
+    httpService->upload("POST", "/upload", path + ".missing");
+    EXPECT_NE(getOutput().find("Cannot open"), std::string::npos);
+
+    std::filesystem::remove(path);
+}
+
+TEST_F(HttpServiceTest, UploadsMultipartForms) {
+    std::string path = (std::filesystem::temp_directory_path() / "lunarica_form_test.png").string();
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << std::string(200000, '\x89');
+    }
+
+    context->addBodyParam("album", "trip");
+    httpService->uploadForm("POST", "/form", {{"title", "Holiday", ""}, {"photo", "", path}});
+    std::string output = getOutput();
+
+    EXPECT_NE(output.find("album=trip;photo=lunarica_form_test.png:200000:image/png;title=Holiday;"), std::string::npos);
+    EXPECT_NE(output.find("Sent "), std::string::npos);
+    EXPECT_NE(output.find("MB/s"), std::string::npos);
+
+    std::filesystem::remove(path);
+}
+
+#ifdef LUNARICA_ZLIB_SUPPORT
+TEST_F(HttpServiceTest, DecodesCompressedResponses) {
+    httpService->get("/gzip");
+    std::string output = getOutput();
+
+    auto stored = httpService->getResponses().latest();
+    ASSERT_NE(stored, nullptr);
+    EXPECT_EQ(stored->body.view(), testing::TestHttpServer::compressibleContent());
+    EXPECT_NE(output.find("Content-Encoding: gzip"), std::string::npos);
+    EXPECT_NE(output.find("gzip bytes on the wire"), std::string::npos);
+    EXPECT_NE(output.find("item-1999"), std::string::npos);
+
+    context->addHeader("Accept-Encoding", "identity");
+    httpService->get("/gzip");
+    EXPECT_EQ(countOf(getOutput(), "bytes on the wire"), 0);
+    EXPECT_EQ(httpService->getResponses().latest()->body.view(), stored->body.view());
+}
+#endif
+
+#ifndef _WIN32
+TEST_F(HttpServiceTest, HedgesSlowGetsOnSecondConnection) {
+    context->setHedgeMode(HedgeMode::Fixed);
+    context->setHedgeDelay(100);
+
+    auto started = std::chrono::steady_clock::now();
+    httpService->get("/slow-once");
+    auto elapsed = std::chrono::steady_clock::now() - started;
+
+    std::string output = getOutput();
+    EXPECT_NE(output.find("STATUS: 200"), std::string::npos);
+    EXPECT_NE(output.find("\"slow\": false"), std::string::npos);
+    EXPECT_NE(output.find("the duplicate answered first"), std::string::npos);
+    EXPECT_LT(elapsed, std::chrono::milliseconds(800));
+
+    HedgeStats stats = httpService->getHedger().stats();
+    EXPECT_EQ(stats.requests, 1u);
+    EXPECT_EQ(stats.fired, 1u);
+    EXPECT_EQ(stats.won, 1u);
+
+    httpService->get("/posts/1");
+    EXPECT_EQ(getOutput().find("Hedged after"), std::string::npos);
+    EXPECT_EQ(httpService->getHedger().stats().fired, 1u);
+
+    httpService->del("/posts/1");
+    EXPECT_EQ(httpService->getHedger().stats().requests, 2u);
+
+    // Hedged requests report the faster leg, so only unhedged ones feed the p95.
+    std::string host = httpService->extractHost(context->getUrl());
+    EXPECT_EQ(httpService->getHedger().samples(host), 0u);
+    context->setHedgeMode(HedgeMode::Percentile);
+    httpService->get("/posts/1");
+    getOutput();
+    EXPECT_EQ(httpService->getHedger().samples(host), 1u);
+}
+
+TEST_F(HttpServiceTest, MultiplexesOverHttp2WhenEnabled) {
+    testing::TestH2cServer h2Server(8096);
+    h2Server.start();
+    context->setUrl(h2Server.getBaseUrl());
+    context->setHttp2Mode(Http2Mode::PriorKnowledge);
+
+    httpService->get("/posts/1");
+    std::string output = getOutput();
+    EXPECT_NE(output.find("STATUS: 200"), std::string::npos);
+    EXPECT_NE(output.find("h2)"), std::string::npos);
+    EXPECT_NE(output.find("h2c"), std::string::npos);
+    EXPECT_TRUE(httpService->getLastTiming().http2);
+
+    httpService->get("/posts/1");
+    getOutput();
+    EXPECT_FALSE(httpService->getLastTiming().newConnection);
+    EXPECT_EQ(h2Server.connectionCount(), 1u);
+
+    context->setHttp2Mode(Http2Mode::Off);
+    context->setUrl(testServer->getBaseUrl());
+    httpService->get("/posts/1");
+    getOutput();
+    EXPECT_FALSE(httpService->getLastTiming().http2);
+
+    h2Server.stop();
+}
+
+TEST_F(HttpServiceTest, FollowsRedirectsOverHttp2) {
+    testing::TestH2cServer h2Server(8096);
+    h2Server.start();
+    context->setUrl(h2Server.getBaseUrl());
+    context->setHttp2Mode(Http2Mode::PriorKnowledge);
+
+    httpService->get("/moved");
+    std::string output = getOutput();
+    EXPECT_NE(output.find("STATUS: 200"), std::string::npos);
+    EXPECT_EQ(output.find("STATUS: 302"), std::string::npos);
+    EXPECT_NE(output.find("Test Post"), std::string::npos);
+    EXPECT_TRUE(httpService->getLastTiming().http2);
+
+    context->setHttp2Mode(Http2Mode::Off);
+    h2Server.stop();
+}
+#endif
+
 }
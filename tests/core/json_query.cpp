@@ -0,0 +1,91 @@
+﻿#include "services/json_query.h"
+
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+namespace lunarica {
+
+namespace {
+
+std::vector<std::string> query(const std::string& expression, std::string_view json) {
+    JsonQuery compiled;
+    EXPECT_TRUE(compiled.parse(expression)) << compiled.error();
+    std::vector<std::string> results;
+    compiled.run(json, [&](std::string_view value) {
+        results.emplace_back(value);
+    });
+    return results;
+}
+
+const std::string kAudit =
+    "{\"items\": ["
+    "{\"id\": 1, \"status\": \"ok\", \"took\": 12, \"meta\": {\"tags\": [\"a\"]}},"
+    "{\"id\": 2, \"status\": \"failed\", \"took\": 250.5, \"note\": \"x \\\"}] y\"},"
+    "{\"id\": 3, \"status\": \"failed\", \"took\": 7, \"retry\": true},"
+    "{\"id\": 4, \"status\": \"f\\u0061iled\", \"took\": 1e3}"
+    "], \"count\": 4}";
+
+}
+
+TEST(JsonQueryTest, FollowsPaths) {
+    EXPECT_EQ(query(".count", kAudit), std::vector<std::string>{"4"});
+    EXPECT_EQ(query(".items[0].meta.tags", kAudit), std::vector<std::string>{"[\"a\"]"});
+    EXPECT_EQ(query(".items[1].note", kAudit), std::vector<std::string>{"\"x \\\"}] y\""});
+    EXPECT_EQ(query(".[\"count\"]", kAudit), std::vector<std::string>{"4"});
+    EXPECT_EQ(query(".items[].id", kAudit), (std::vector<std::string>{"1", "2", "3", "4"}));
+    EXPECT_EQ(query(".", "[1, 2]"), std::vector<std::string>{"[1, 2]"});
+    EXPECT_TRUE(query(".missing", kAudit).empty());
+    EXPECT_TRUE(query(".items[9]", kAudit).empty());
+    EXPECT_TRUE(query(".count[0]", kAudit).empty());
+}
+
+TEST(JsonQueryTest, SelectsMatchingElements) {
+    EXPECT_EQ(query(".items[] | select(.status==\"failed\") | .id", kAudit),
+              (std::vector<std::string>{"2", "3", "4"}));
+    EXPECT_EQ(query(".items[] | select(.took > 100) | .id", kAudit), (std::vector<std::string>{"2", "4"}));
+    EXPECT_EQ(query(".items[] | select(.status == \"failed\" and .took < 100) | .id", kAudit),
+              std::vector<std::string>{"3"});
+    EXPECT_EQ(query(".items[] | select(.retry or .id == 1) | .id", kAudit), (std::vector<std::string>{"1", "3"}));
+    EXPECT_EQ(query(".items[] | select(.retry == null) | .id", kAudit), (std::vector<std::string>{"1", "2", "4"}));
+    EXPECT_EQ(query(".items[] | select(.meta.tags[] == \"a\") | .status", kAudit),
+              std::vector<std::string>{"\"ok\""});
+}
+
+TEST(JsonQueryTest, StreamsNewlineDelimitedDocuments) {
+    std::string lines = "{\"level\":\"info\",\"msg\":\"a\"}\n{\"level\":\"error\",\"msg\":\"b\"}\n{\"level\":\"error\",\"msg\":\"c\"}\n";
+    EXPECT_EQ(query("select(.level == \"error\") | .msg", lines), (std::vector<std::string>{"\"b\"", "\"c\""}));
+}
+
+TEST(JsonQueryTest, ComparesLikeJq) {
+    EXPECT_LT(JsonQuery::compare("null", "false"), 0);
+    EXPECT_LT(JsonQuery::compare("true", "0"), 0);
+    EXPECT_LT(JsonQuery::compare("99", "\"a\""), 0);
+    EXPECT_EQ(JsonQuery::compare("1e2", "100.0"), 0);
+    EXPECT_EQ(JsonQuery::compare("\"\\u00e9\"", u8"\"\u00e9\""), 0);
+    EXPECT_GT(JsonQuery::compare("\"b\"", "\"a\""), 0);
+}
+
+TEST(JsonQueryTest, OrdersStringsByContent) {
+    EXPECT_GT(JsonQuery::compare("\"a b\"", "\"a\""), 0);
+    EXPECT_GT(JsonQuery::compare("\"a!\"", "\"a\""), 0);
+    EXPECT_LT(JsonQuery::compare("\"\"", "\" \""), 0);
+    EXPECT_LT(JsonQuery::compare("\"a\\tb\"", "\"a b\""), 0);
+    EXPECT_GT(JsonQuery::compare("\"a\\\"\"", "\"a\""), 0);
+    EXPECT_EQ(JsonQuery::compare("\"a\\/b\"", "\"a/b\""), 0);
+    EXPECT_LT(JsonQuery::compare("\"z\"", u8"\"\u00e9\""), 0);
+    EXPECT_EQ(query(".items[] | select(.name > \"a\") | .id", "{\"items\":[{\"id\":1,\"name\":\"a\"},{\"id\":2,\"name\":\"a b\"}]}"),
+              std::vector<std::string>{"2"});
+}
+
+TEST(JsonQueryTest, ReportsSyntaxErrors) {
+    JsonQuery compiled;
+    EXPECT_FALSE(compiled.parse("items"));
+    EXPECT_FALSE(compiled.parse(".items[] | select(.id ==)"));
+    EXPECT_FALSE(compiled.parse(".items[x]"));
+    EXPECT_FALSE(compiled.parse(".items | select(.a"));
+    EXPECT_NE(compiled.error().find("column"), std::string::npos);
+    EXPECT_FALSE(compiled.parse(".a."));
+}
+
+}
@@ -0,0 +1,148 @@
+﻿#include "services/json_stream_renderer.h"
+
+#include <sstream>
+#include <string>
+#include <gtest/gtest.h>
+
+namespace lunarica {
+
+namespace {
+
+std::string stripAnsi(const std::string& input) {
+    std::string result;
+    bool inEscape = false;
+    for (char c : input) {
+        if (c == '\033') {
+            inEscape = true;
+        } else if (inEscape) {
+            inEscape = c != 'm';
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+std::string render(const std::string& body, bool jsonHint, size_t chunkSize, JsonRenderLimits limits = {}) {
+    std::ostringstream out;
+    OutputSink sink(out);
+    JsonStreamRenderer renderer(sink, jsonHint, 120, 1024);
+    renderer.setLimits(limits);
+    for (size_t offset = 0; offset < body.size(); offset += chunkSize) {
+        renderer.feed(body.data() + offset, std::min(chunkSize, body.size() - offset));
+    }
+    renderer.finish();
+    sink.flush();
+    return out.str();
+}
+
+}
+
+TEST(JsonStreamRendererTest, PrettyPrintsObject) {
+    std::string output = stripAnsi(render("{\"id\":1,\"tags\":[\"a\",true,null],\"empty\":{}}", true, 1024));
+
+    EXPECT_EQ(output,
+              "{\n"
+              "  \"id\": 1,\n"
+              "  \"tags\": [\n"
+              "    \"a\",\n"
+              "    true,\n"
+              "    null\n"
+              "  ],\n"
+              "  \"empty\": {}\n"
+              "}\n");
+}
+
+TEST(JsonStreamRendererTest, ChunkBoundariesDoNotChangeOutput) {
+    std::string body = "{\"name\":\"escaped \\\"quote\\\"\",\"values\":[1.5e3,-2,false],\"nested\":{\"k\":\"v\"}}";
+    std::string whole = render(body, false, body.size());
+
+    for (size_t chunkSize : {1, 2, 3, 7, 13}) {
+        EXPECT_EQ(render(body, false, chunkSize), whole) << "chunk size " << chunkSize;
+    }
+}
+
+TEST(JsonStreamRendererTest, PlainTextPassesThrough) {
+    EXPECT_EQ(render("hello world", false, 4), "hello world\n");
+}
+
+TEST(JsonStreamRendererTest, InvalidJsonFallsBackToRaw) {
+    std::ostringstream out;
+    OutputSink sink(out);
+    JsonStreamRenderer renderer(sink, true, 120, 1024);
+    std::string body = "{\"a\": oops}";
+    renderer.feed(body.data(), body.size());
+    renderer.finish();
+    sink.flush();
+
+    EXPECT_TRUE(renderer.isRaw());
+    EXPECT_NE(stripAnsi(out.str()).find("oops}"), std::string::npos);
+}
+
+TEST(JsonStreamRendererTest, WrapsLongLines) {
+    std::ostringstream out;
+    OutputSink sink(out);
+    JsonStreamRenderer renderer(sink, true, 40, 1024);
+    std::string body = "{\"text\":\"" + std::string(200, 'x') + "\"}";
+    renderer.feed(body.data(), body.size());
+    renderer.finish();
+    sink.flush();
+
+    std::istringstream lines(stripAnsi(out.str()));
+    std::string line;
+    size_t count = 0;
+    while (std::getline(lines, line)) {
+        EXPECT_LE(line.size(), 35u);
+        EXPECT_NE(line.find_first_not_of(' '), std::string::npos);
+        count++;
+    }
+    EXPECT_GT(count, 5u);
+}
+
+TEST(JsonStreamRendererTest, CollapsesBeyondDepth) {
+    std::string body = "{\"user\":{\"id\":1,\"roles\":[\"a\",\"b\"]},\"items\":[[1,2,3],{},[],{\"k\":{\"x\":[1]}}]}";
+    JsonRenderLimits limits;
+    limits.depth = 2;
+
+    std::string whole = render(body, true, body.size(), limits);
+    EXPECT_EQ(stripAnsi(whole),
+              "{\n"
+              "  \"user\": {\n"
+              "    \"id\": 1,\n"
+              u8"    \"roles\": [\u20262 items]\n"
+              "  },\n"
+              "  \"items\": [\n"
+              u8"    [\u20263 items],\n"
+              "    {},\n"
+              "    [],\n"
+              u8"    {\u20261 key}\n"
+              "  ]\n"
+              "}\n");
+
+    for (size_t chunkSize : {1, 5, 11}) {
+        EXPECT_EQ(render(body, true, chunkSize, limits), whole) << "chunk size " << chunkSize;
+    }
+}
+
+TEST(JsonStreamRendererTest, ElidesPastItemBudget) {
+    std::string body = "[";
+    for (int i = 0; i < 10000; ++i) {
+        body += (i > 0 ? "," : "") + std::string("{\"id\":") + std::to_string(i) + "}";
+    }
+    body += "]";
+    JsonRenderLimits limits;
+    limits.items = 2;
+
+    EXPECT_EQ(stripAnsi(render(body, true, 4096, limits)),
+              "[\n"
+              "  {\n"
+              "    \"id\": 0\n"
+              "  },\n"
+              "  {\n"
+              "    \"id\": 1\n"
+              "  },\n"
+              u8"  \u20269998 more items\n"
+              "]\n");
+}
+
+}
@@ -0,0 +1,118 @@
+﻿#include "services/json_structural_index.h"
+
+#include <random>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+namespace lunarica {
+
+namespace {
+
+std::vector<uint32_t> referenceIndex(const std::string& json) {
+    std::vector<uint32_t> positions;
+    bool inString = false;
+    bool escaped = false;
+    bool previousScalar = false;
+
+    for (size_t i = 0; i < json.size(); ++i) {
+        char c = json[i];
+        bool quote = c == '"' && !escaped;
+        escaped = c == '\\' && !escaped;
+
+        if (quote) {
+            positions.push_back(static_cast<uint32_t>(i));
+            inString = !inString;
+            previousScalar = false;
+            continue;
+        }
+        if (inString) {
+            previousScalar = false;
+            continue;
+        }
+
+        bool op = c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',';
+        bool space = c == ' ' || c == '\t' || c == '\n' || c == '\r';
+        bool scalar = !op && !space && c != '"';
+        if (op || (scalar && !previousScalar)) {
+            positions.push_back(static_cast<uint32_t>(i));
+        }
+        previousScalar = scalar;
+    }
+    return positions;
+}
+
+std::vector<uint32_t> chunkedIndex(JsonStructuralIndexer& indexer, const std::string& json, size_t chunkSize) {
+    std::vector<uint32_t> all;
+    std::vector<uint32_t> positions;
+    for (size_t offset = 0; offset < json.size(); offset += chunkSize) {
+        indexer.index(json.data() + offset, std::min(chunkSize, json.size() - offset), positions);
+        for (uint32_t position : positions) {
+            all.push_back(static_cast<uint32_t>(offset + position));
+        }
+    }
+    return all;
+}
+
+std::string randomJsonish(std::mt19937& rng, size_t length) {
+    const char alphabet[] = "{}[]:,\"\\ \n\tab01-.etrue";
+    std::string text;
+    for (size_t i = 0; i < length; ++i) {
+        text += alphabet[rng() % (sizeof(alphabet) - 1)];
+    }
+    return text;
+}
+
+}
+
+TEST(JsonStructuralIndexTest, IndexesStructuralCharactersOutsideStrings) {
+    std::string json = R"({"a": "x,y", "b": [1, true], "c": "q\"}"})";
+    JsonStructuralIndexer indexer(JsonStructuralIndexer::Backend::Scalar);
+    std::vector<uint32_t> positions;
+    indexer.index(json.data(), json.size(), positions);
+
+    EXPECT_EQ(positions, referenceIndex(json));
+
+    std::string tokens;
+    for (uint32_t position : positions) {
+        tokens += json[position];
+    }
+    EXPECT_EQ(tokens, "{\"\":\"\",\"\":[1,t],\"\":\"\"}");
+}
+
+TEST(JsonStructuralIndexTest, BackendsMatchReference) {
+    std::mt19937 rng(1234);
+    const JsonStructuralIndexer::Backend backends[] = {
+        JsonStructuralIndexer::Backend::Scalar,
+        JsonStructuralIndexer::Backend::Sse2,
+        JsonStructuralIndexer::Backend::Avx2
+    };
+
+    for (int round = 0; round < 50; ++round) {
+        std::string json = randomJsonish(rng, 1 + rng() % 700);
+        std::vector<uint32_t> expected = referenceIndex(json);
+
+        for (auto backend : backends) {
+            if (JsonStructuralIndexer(backend).backend() != backend) {
+                continue;
+            }
+
+            for (size_t chunkSize : {1, 7, 63, 64, 65, 200, 4096}) {
+                JsonStructuralIndexer indexer(backend);
+                EXPECT_EQ(chunkedIndex(indexer, json, chunkSize), expected)
+                    << JsonStructuralIndexer::backendName(backend) << " chunk " << chunkSize;
+            }
+        }
+    }
+}
+
+TEST(JsonStructuralIndexTest, EscapeRunsAcrossBlockBoundary) {
+    std::string json = "[\"" + std::string(61, 'x') + "\\\\\\\"" + std::string(10, 'y') + "\",1]";
+    JsonStructuralIndexer indexer;
+    std::vector<uint32_t> positions;
+    indexer.index(json.data(), json.size(), positions);
+
+    EXPECT_EQ(positions, referenceIndex(json));
+}
+
+}
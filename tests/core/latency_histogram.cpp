@@ -0,0 +1,107 @@
+﻿#include <gtest/gtest.h>
+#include "utils/latency_histogram.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace lunarica {
+
+TEST(LatencyHistogramTest, EmptyHistogram) {
+    LatencyHistogram histogram;
+
+    EXPECT_EQ(histogram.count(), 0);
+    EXPECT_EQ(histogram.min(), 0);
+    EXPECT_EQ(histogram.max(), 0);
+    EXPECT_EQ(histogram.valueAtPercentile(99), 0);
+}
+
+TEST(LatencyHistogramTest, ExactBelowSubBucketRange) {
+    LatencyHistogram histogram;
+    for (int64_t i = 1; i <= 1000; ++i) {
+        histogram.record(i);
+    }
+
+    EXPECT_EQ(histogram.count(), 1000);
+    EXPECT_EQ(histogram.min(), 1);
+    EXPECT_EQ(histogram.max(), 1000);
+    EXPECT_EQ(histogram.valueAtPercentile(50), 500);
+    EXPECT_EQ(histogram.valueAtPercentile(99), 990);
+    EXPECT_EQ(histogram.valueAtPercentile(100), 1000);
+    EXPECT_DOUBLE_EQ(histogram.mean(), 500.5);
+}
+
+TEST(LatencyHistogramTest, PercentilesWithinConfiguredPrecision) {
+    LatencyHistogram histogram(3);
+    std::mt19937_64 rng(42);
+    std::vector<int64_t> samples;
+
+    for (int i = 0; i < 100000; ++i) {
+        int64_t value = static_cast<int64_t>(rng() % 50000000);
+        samples.push_back(value);
+        histogram.record(value);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    for (double percentile : {50.0, 90.0, 99.0, 99.9}) {
+        size_t rank = static_cast<size_t>(std::ceil(percentile / 100.0 * samples.size())) - 1;
+        double exact = static_cast<double>(samples[rank]);
+        EXPECT_NEAR(static_cast<double>(histogram.valueAtPercentile(percentile)), exact, exact * 0.002);
+    }
+}
+
+TEST(LatencyHistogramTest, MergeCombinesRecorders) {
+    LatencyHistogram first;
+    LatencyHistogram second;
+
+    for (int i = 0; i < 90; ++i) {
+        first.record(100);
+    }
+    for (int i = 0; i < 10; ++i) {
+        second.record(200000);
+    }
+
+    first.merge(second);
+
+    EXPECT_EQ(first.count(), 100);
+    EXPECT_EQ(first.min(), 100);
+    EXPECT_EQ(first.max(), 200000);
+    EXPECT_EQ(first.valueAtPercentile(90), 100);
+    EXPECT_NEAR(first.valueAtPercentile(95), 200000, 200);
+}
+
+TEST(LatencyHistogramTest, MergeAcrossDifferentPrecision) {
+    LatencyHistogram coarse(2, 1000000);
+    coarse.record(12345);
+
+    LatencyHistogram fine(3);
+    fine.merge(coarse);
+
+    EXPECT_EQ(fine.count(), 1);
+    EXPECT_NEAR(fine.valueAtPercentile(50), 12345, 12345 * 0.02);
+}
+
+TEST(LatencyHistogramTest, ClampsOutOfRangeValues) {
+    LatencyHistogram histogram(3, 1000);
+    histogram.record(-5);
+    histogram.record(5000);
+
+    EXPECT_EQ(histogram.min(), 0);
+    EXPECT_EQ(histogram.max(), 1000);
+}
+
+TEST(LatencyHistogramTest, ResetClearsCounts) {
+    LatencyHistogram histogram;
+    histogram.record(42);
+    histogram.reset();
+
+    EXPECT_EQ(histogram.count(), 0);
+    EXPECT_EQ(histogram.valueAtPercentile(50), 0);
+}
+
+TEST(LatencyHistogramTest, RejectsInvalidPrecision) {
+    EXPECT_THROW(LatencyHistogram(0), std::invalid_argument);
+    EXPECT_THROW(LatencyHistogram(6), std::invalid_argument);
+}
+
+}
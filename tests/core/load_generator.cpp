@@ -0,0 +1,146 @@
+﻿#include <sstream>
+#include <gtest/gtest.h>
+#include "services/load_generator.h"
+#include "../utils/test_http_server.h"
+
+namespace lunarica {
+
+class LoadGeneratorTest : public ::testing::Test {
+protected:
+    std::shared_ptr<Context> context;
+    std::shared_ptr<HttpService> httpService;
+    std::unique_ptr<testing::TestHttpServer> testServer;
+    std::ostringstream output;
+
+    void SetUp() override {
+        context = std::make_shared<Context>();
+        auto sink = std::make_shared<OutputSink>(output);
+        httpService = std::make_shared<HttpService>(context, std::make_shared<JsonFormatter>(sink), sink);
+
+        testServer = std::make_unique<testing::TestHttpServer>(8092);
+        testServer->start();
+
+        context->setUrl(testServer->getBaseUrl());
+    }
+
+    void TearDown() override {
+        testServer->stop();
+    }
+};
+
+TEST_F(LoadGeneratorTest, ClosedLoopCompletesAllRequests) {
+    LoadGenerator generator(httpService);
+    BenchOptions options;
+    options.requests = 40;
+    options.concurrency = 4;
+
+    BenchReport report = generator.runClosedLoop(httpService->prepareRequest("GET", "/posts/1"), options);
+
+    EXPECT_EQ(report.requests, 40);
+    EXPECT_EQ(report.concurrency, 4);
+    EXPECT_EQ(report.statusCounts[200], 40);
+    EXPECT_TRUE(report.errorCounts.empty());
+    EXPECT_EQ(report.latency.count(), 40);
+    EXPECT_EQ(report.serviceTime.count(), 0);
+    EXPECT_LE(report.percentile(50), report.percentile(99));
+    EXPECT_LE(report.percentile(99.9), report.max());
+    EXPECT_GT(report.throughput(), 0.0);
+}
+
+TEST_F(LoadGeneratorTest, CountsStatusAndTransportErrors) {
+    LoadGenerator generator(httpService);
+    BenchOptions options;
+    options.requests = 5;
+    options.concurrency = 2;
+
+    BenchReport report = generator.runClosedLoop(httpService->prepareRequest("GET", "/error"), options);
+    EXPECT_EQ(report.statusCounts[500], 5);
+
+    context->setUrl("http://localhost:1");
+    report = generator.runClosedLoop(httpService->prepareRequest("GET", "/posts/1"), options);
+    EXPECT_TRUE(report.statusCounts.empty());
+    EXPECT_EQ(report.errorCounts.size(), 1);
+}
+
+TEST_F(LoadGeneratorTest, OpenLoopHoldsScheduleAndMeasuresFromIntendedTime) {
+    LoadGenerator generator(httpService);
+    BenchOptions options;
+    options.requests = 20;
+    options.concurrency = 4;
+    options.rate = 200.0;
+
+    BenchReport report = generator.runOpenLoop(httpService->prepareRequest("GET", "/posts/1"), options);
+
+    EXPECT_EQ(report.statusCounts[200], 20);
+    EXPECT_EQ(report.serviceTime.count(), 20);
+    EXPECT_GE(std::chrono::duration_cast<std::chrono::milliseconds>(report.elapsed).count(), 95);
+    EXPECT_GE(report.percentile(50), report.servicePercentile(50));
+}
+
+#ifdef __linux__
+TEST_F(LoadGeneratorTest, EventLoopEngineMatchesThreadedReport) {
+    LoadGenerator generator(httpService);
+    BenchOptions options;
+    options.requests = 200;
+    options.concurrency = 16;
+    options.threads = 2;
+    options.eventLoop = true;
+
+    BenchReport report;
+    std::string error;
+    ASSERT_TRUE(generator.runEventLoop(httpService->prepareRequest("GET", "/posts/1"), options, report, error)) << error;
+    EXPECT_EQ(report.statusCounts[200], 200);
+    EXPECT_EQ(report.concurrency, 16);
+    EXPECT_EQ(report.latency.count(), 200);
+    EXPECT_TRUE(report.errorCounts.empty());
+
+    options.rate = 400.0;
+    options.requests = 20;
+    ASSERT_TRUE(generator.runEventLoop(httpService->prepareRequest("GET", "/posts/1"), options, report, error)) << error;
+    EXPECT_EQ(report.statusCounts[200], 20);
+    EXPECT_EQ(report.serviceTime.count(), 20);
+    EXPECT_GE(report.percentile(50), report.servicePercentile(50));
+
+    context->setUrl("https://localhost:8092");
+    EXPECT_FALSE(generator.runEventLoop(httpService->prepareRequest("GET", "/posts/1"), options, report, error));
+    EXPECT_NE(error.find("http://"), std::string::npos);
+}
+#endif
+
+TEST(PacerTest, SchedulesSlotsWithoutDrift) {
+    auto start = Pacer::Clock::now();
+    Pacer pacer(1000.0, 3, start);
+
+    size_t slot = 0;
+    Pacer::Clock::time_point intended;
+
+    ASSERT_TRUE(pacer.next(slot, intended));
+    EXPECT_EQ(slot, 0);
+    EXPECT_EQ(intended, start);
+
+    ASSERT_TRUE(pacer.next(slot, intended));
+    ASSERT_TRUE(pacer.next(slot, intended));
+    EXPECT_EQ(slot, 2);
+    EXPECT_EQ(intended - start, std::chrono::milliseconds(2));
+
+    EXPECT_FALSE(pacer.next(slot, intended));
+    EXPECT_EQ(pacer.intendedTime(1000000) - start, std::chrono::seconds(1000));
+
+    Pacer slow(1e-300, 3, start);
+    EXPECT_EQ(slow.intendedTime(0), start);
+    EXPECT_EQ(slow.intendedTime(1), Pacer::Clock::time_point::max());
+}
+
+TEST(BenchReportTest, PercentilesFromHistogram) {
+    BenchReport report;
+    for (int64_t i = 1; i <= 100; ++i) {
+        report.latency.record(i);
+    }
+
+    EXPECT_EQ(report.percentile(50), 50);
+    EXPECT_EQ(report.percentile(99), 99);
+    EXPECT_EQ(report.percentile(99.9), 100);
+    EXPECT_EQ(report.max(), 100);
+}
+
+}
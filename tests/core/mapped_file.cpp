@@ -0,0 +1,34 @@
+﻿#include "services/mapped_file.h"
+
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+
+namespace lunarica {
+
+TEST(MappedFileTest, MapsContentsUnchanged) {
+    std::string path = (std::filesystem::temp_directory_path() / "lunarica_mapped_test.bin").string();
+    std::string content("binary\0\xff\xfe data\r\n", 16);
+    {
+        std::ofstream out(path, std::ios::binary);
+        out.write(content.data(), static_cast<std::streamsize>(content.size()));
+    }
+
+    std::string error;
+    auto file = MappedFile::open(path, error);
+    ASSERT_TRUE(file != nullptr) << error;
+    EXPECT_EQ(file->size(), content.size());
+    EXPECT_EQ(file->view(), content);
+
+    std::ofstream(path, std::ios::trunc).close();
+    auto empty = MappedFile::open(path, error);
+    ASSERT_TRUE(empty != nullptr);
+    EXPECT_EQ(empty->size(), 0u);
+    EXPECT_TRUE(empty->view().empty());
+
+    std::filesystem::remove(path);
+    EXPECT_EQ(MappedFile::open(path, error), nullptr);
+    EXPECT_NE(error.find("Cannot open"), std::string::npos);
+}
+
+}
@@ -0,0 +1,70 @@
+﻿#include "services/multipart_body.h"
+
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+
+namespace lunarica {
+
+namespace {
+
+std::string collect(const MultipartBody& body, size_t step) {
+    std::string result;
+    while (result.size() < body.size()) {
+        std::string_view slice = body.slice(result.size(), step);
+        if (slice.empty()) {
+            break;
+        }
+        result.append(slice.data(), slice.size());
+    }
+    return result;
+}
+
+}
+
+TEST(MultipartBodyTest, StreamsFieldsAndFiles) {
+    std::string path = (std::filesystem::temp_directory_path() / "lunarica clip.mp4").string();
+    std::string content(100000, '\0');
+    for (size_t i = 0; i < content.size(); ++i) {
+        content[i] = static_cast<char>(i % 253);
+    }
+    {
+        std::ofstream out(path, std::ios::binary);
+        out.write(content.data(), static_cast<std::streamsize>(content.size()));
+    }
+
+    std::string error;
+    auto body = MultipartBody::build({{"title", "Holiday", ""}, {"say \"hi\"", "a\r\nb", ""}, {"video", "", path}},
+                                     error, "XYZ");
+    ASSERT_TRUE(body != nullptr) << error;
+    EXPECT_EQ(body->contentType(), "multipart/form-data; boundary=XYZ");
+
+    std::string expected =
+        "--XYZ\r\nContent-Disposition: form-data; name=\"title\"\r\n\r\nHoliday\r\n"
+        "--XYZ\r\nContent-Disposition: form-data; name=\"say %22hi%22\"\r\n\r\na\r\nb\r\n"
+        "--XYZ\r\nContent-Disposition: form-data; name=\"video\"; filename=\"lunarica clip.mp4\"\r\n"
+        "Content-Type: video/mp4\r\n\r\n" + content + "\r\n--XYZ--\r\n";
+    EXPECT_EQ(body->size(), expected.size());
+    for (size_t step : {7, 4096, 1 << 20}) {
+        EXPECT_TRUE(collect(*body, step) == expected) << "step " << step;
+    }
+    EXPECT_TRUE(body->slice(body->size(), 10).empty());
+
+    std::filesystem::remove(path);
+    EXPECT_EQ(MultipartBody::build({{"video", "", path}}, error), nullptr);
+    EXPECT_NE(error.find("Cannot open"), std::string::npos);
+}
+
+TEST(MultipartBodyTest, GuessesContentTypes) {
+    EXPECT_EQ(MultipartBody::contentTypeFor("photo.JPG"), "image/jpeg");
+    EXPECT_EQ(MultipartBody::contentTypeFor("data/payload.json"), "application/json");
+    EXPECT_EQ(MultipartBody::contentTypeFor("archive.tar.gz"), "application/gzip");
+    EXPECT_EQ(MultipartBody::contentTypeFor("v1.2/README"), "application/octet-stream");
+
+    std::string error;
+    auto first = MultipartBody::build({}, error);
+    auto second = MultipartBody::build({}, error);
+    EXPECT_NE(first->boundary(), second->boundary());
+}
+
+}
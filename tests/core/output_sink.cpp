@@ -0,0 +1,65 @@
+﻿#include "core/output_sink.h"
+
+#include <sstream>
+#include <thread>
+#include <gtest/gtest.h>
+
+namespace lunarica {
+
+TEST(OutputSinkTest, BuffersUntilFlush) {
+    std::ostringstream out;
+    OutputSink sink(out);
+
+    sink << "status " << 200 << '\n';
+    EXPECT_EQ(out.str(), "");
+    EXPECT_EQ(sink.buffered(), 11u);
+
+    sink.flush();
+    EXPECT_EQ(out.str(), "status 200\n");
+    EXPECT_EQ(sink.buffered(), 0u);
+}
+
+TEST(OutputSinkTest, FlushesWhenCapacityIsReached) {
+    std::ostringstream out;
+    OutputSink sink(out, 16);
+
+    sink << "0123456789";
+    EXPECT_EQ(out.str(), "");
+
+    sink << "abcdefghij";
+    EXPECT_EQ(out.str(), "0123456789");
+
+    sink << std::string(64, 'x');
+    EXPECT_EQ(out.str(), "0123456789abcdefghij" + std::string(64, 'x'));
+}
+
+TEST(OutputSinkTest, PacesChunkFlushes) {
+    std::ostringstream out;
+    OutputSink sink(out);
+
+    sink << "chunk\n";
+    sink.flushIfDue();
+    EXPECT_EQ(out.str(), "");
+
+    sink << std::string(OutputSink::kPaceBytes, 'x');
+    sink.flushIfDue();
+    EXPECT_EQ(out.str().size(), 6 + OutputSink::kPaceBytes);
+
+    sink << "late\n";
+    sink.flushIfDue();
+    EXPECT_EQ(sink.buffered(), 5u);
+    std::this_thread::sleep_for(OutputSink::kPaceInterval + std::chrono::milliseconds(10));
+    sink.flushIfDue();
+    EXPECT_EQ(sink.buffered(), 0u);
+}
+
+TEST(OutputSinkTest, FlushesOnDestruction) {
+    std::ostringstream out;
+    {
+        OutputSink sink(out);
+        sink << "bye\n";
+    }
+    EXPECT_EQ(out.str(), "bye\n");
+}
+
+}
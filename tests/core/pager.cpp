@@ -0,0 +1,176 @@
+﻿#include "services/pager.h"
+#include "services/json_path.h"
+
+#include <sstream>
+#include <string>
+#include <gtest/gtest.h>
+
+namespace lunarica {
+
+namespace {
+
+std::string stripAnsi(const std::string& input) {
+    std::string result;
+    bool inEscape = false;
+    for (char c : input) {
+        if (c == '\033') {
+            inEscape = true;
+        } else if (inEscape) {
+            inEscape = c != 'm';
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+std::string buildDocument(size_t items) {
+    std::string json = "{\"items\":[";
+    for (size_t i = 0; i < items; ++i) {
+        if (i > 0) {
+            json += ",";
+        }
+        json += "{\"id\":" + std::to_string(i) + ",\"name\":\"name-" + std::to_string(i) +
+                "\",\"note\":\"a \\\"quoted\\\" [x], {y}\",\"tags\":[\"a\",\"b\"],\"empty\":{},\"none\":[],\"ok\":true}";
+    }
+    json += "],\"count\":" + std::to_string(items) + "}";
+    return json;
+}
+
+std::vector<std::string> renderAll(const std::string& body) {
+    std::ostringstream out;
+    {
+        OutputSink sink(out);
+        JsonStreamRenderer renderer(sink, false, 0);
+        renderer.feed(body.data(), body.size());
+        renderer.finish();
+    }
+
+    std::vector<std::string> lines;
+    std::istringstream in(out.str());
+    std::string line;
+    while (std::getline(in, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+}
+
+TEST(PagerTest, LinesRenderedFromCheckpointsMatchFullRender) {
+    std::string body = buildDocument(300);
+    std::vector<std::string> expected = renderAll(body);
+
+    std::ostringstream out;
+    OutputSink sink(out);
+    Pager pager(body, true, sink);
+
+    pager.index().extendAll();
+    ASSERT_EQ(pager.index().lineCount(), expected.size());
+    for (size_t i = expected.size(); i-- > 0;) {
+        ASSERT_EQ(pager.line(i), expected[i]) << "line " << i;
+    }
+}
+
+TEST(PagerTest, IndexesLazily) {
+    std::string body = buildDocument(5000);
+
+    std::ostringstream out;
+    OutputSink sink(out);
+    Pager pager(body, true, sink);
+    pager.resize(20, 80);
+
+    std::vector<std::string> lines = pager.visibleLines();
+    ASSERT_EQ(lines.size(), 20u);
+    EXPECT_EQ(stripAnsi(lines[0]), "{");
+    EXPECT_EQ(stripAnsi(lines[1]), "  \"items\": [");
+    EXPECT_FALSE(pager.index().complete());
+    EXPECT_LT(pager.index().lineCount(), 1000u);
+
+    pager.scrollToEnd();
+    EXPECT_TRUE(pager.index().complete());
+    EXPECT_EQ(stripAnsi(pager.visibleLines().back()), "}");
+}
+
+TEST(PagerTest, PlainTextBodies) {
+    std::string body = "  alpha\nbeta\r\ngamma";
+
+    std::ostringstream out;
+    OutputSink sink(out);
+    Pager pager(body, false, sink);
+
+    pager.index().extendAll();
+    ASSERT_EQ(pager.index().lineCount(), 3u);
+    EXPECT_EQ(pager.line(0), "alpha");
+    EXPECT_EQ(pager.line(1), "beta");
+    EXPECT_EQ(pager.line(2), "gamma");
+}
+
+TEST(PagerTest, InvalidJsonContinuesAsText) {
+    std::string body = "{\"a\": [1, 2, oops\nsecond line\nthird line\n";
+    std::vector<std::string> expected = renderAll(body);
+
+    std::ostringstream out;
+    OutputSink sink(out);
+    Pager pager(body, true, sink);
+
+    pager.index().extendAll();
+    ASSERT_EQ(pager.index().lineCount(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(pager.line(i), expected[i]);
+    }
+}
+
+TEST(PagerTest, JumpsToPathAndSearches) {
+    std::string body = buildDocument(3000);
+
+    std::ostringstream out;
+    OutputSink sink(out);
+    Pager pager(body, true, sink);
+    pager.resize(10, 120);
+
+    ASSERT_TRUE(pager.jumpToPath("items[1500].name"));
+    EXPECT_EQ(stripAnsi(pager.visibleLines()[0]), "      \"name\": \"name-1500\",");
+    EXPECT_FALSE(pager.jumpToPath("items[3000]"));
+    EXPECT_FALSE(pager.jumpToPath("items[x]"));
+
+    ASSERT_TRUE(pager.search("name-2999"));
+    EXPECT_EQ(stripAnsi(pager.visibleLines()[0]), "      \"name\": \"name-2999\",");
+    EXPECT_FALSE(pager.search("name-2999"));
+
+    ASSERT_TRUE(pager.search("name-2", false));
+    EXPECT_EQ(stripAnsi(pager.visibleLines()[0]), "      \"name\": \"name-2998\",");
+}
+
+TEST(PagerTest, ClipsKeepingColors) {
+    std::string line = "\033[1;32m\"abcdef\"\033[0m, tail";
+    EXPECT_EQ(Pager::clip(line, 2, 3), "\033[1;32mbcd\033[0m");
+    EXPECT_EQ(stripAnsi(Pager::clip(line, 6, 100)), "f\", tail");
+}
+
+TEST(JsonPathTest, ParsesAndFindsValues) {
+    std::vector<JsonPathStep> steps;
+    ASSERT_TRUE(JsonPath::parse("$.items[1].tags[1]", steps));
+    ASSERT_EQ(steps.size(), 4u);
+    EXPECT_EQ(JsonPath::toString(steps), "$.items[1].tags[1]");
+    EXPECT_FALSE(JsonPath::parse("items[", steps));
+    EXPECT_FALSE(JsonPath::parse("items..id", steps));
+
+    std::string json = " {\"items\": [{\"id\": 1, \"tags\": [[1, {\"x\": 2}]]}, {\"id\": 2, \"tags\": [\"a\", \"b\"]}],"
+                       " \"meta\": {\"a.b\": true}}";
+    ASSERT_TRUE(JsonPath::parse("items[1].tags[1]", steps));
+    EXPECT_EQ(JsonPath::find(json, steps), json.find("\"b\""));
+
+    ASSERT_TRUE(JsonPath::parse("meta[\"a.b\"]", steps));
+    EXPECT_EQ(JsonPath::find(json, steps), json.find("true"));
+
+    ASSERT_TRUE(JsonPath::parse("meta.missing", steps));
+    EXPECT_EQ(JsonPath::find(json, steps), JsonPath::npos);
+
+    ASSERT_TRUE(JsonPath::parse("items[0].tags", steps));
+    EXPECT_EQ(JsonPath::extract(json, steps), "[[1, {\"x\": 2}]]");
+    ASSERT_TRUE(JsonPath::parse("items[1].id", steps));
+    EXPECT_EQ(JsonPath::extract(json, steps), "2");
+}
+
+}
@@ -0,0 +1,92 @@
+﻿#include "services/request_hedger.h"
+
+#include <thread>
+#include <gtest/gtest.h>
+
+namespace lunarica {
+
+TEST(RequestHedgerTest, FixedDelayAndObservedPercentile) {
+    RequestHedger hedger;
+    std::chrono::microseconds delay{0};
+
+    EXPECT_FALSE(hedger.delayFor("api:80", HedgeMode::Off, 50, delay));
+    ASSERT_TRUE(hedger.delayFor("api:80", HedgeMode::Fixed, 50, delay));
+    EXPECT_EQ(delay, std::chrono::milliseconds(50));
+
+    for (size_t i = 1; i < RequestHedger::kMinSamples; ++i) {
+        hedger.record("api:80", std::chrono::milliseconds(i));
+    }
+    EXPECT_FALSE(hedger.delayFor("api:80", HedgeMode::Percentile, 50, delay));
+
+    hedger.record("api:80", std::chrono::milliseconds(RequestHedger::kMinSamples));
+    ASSERT_TRUE(hedger.delayFor("api:80", HedgeMode::Percentile, 50, delay));
+    EXPECT_NEAR(static_cast<double>(delay.count()), 19000.0, 200.0);
+    EXPECT_FALSE(hedger.delayFor("other:80", HedgeMode::Percentile, 50, delay));
+
+    hedger.count(true, false);
+    hedger.count(true, true);
+    hedger.count(false, false);
+    HedgeStats stats = hedger.stats();
+    EXPECT_EQ(stats.requests, 3u);
+    EXPECT_EQ(stats.fired, 2u);
+    EXPECT_EQ(stats.won, 1u);
+
+    hedger.reset();
+    EXPECT_EQ(hedger.samples("api:80"), 0u);
+    EXPECT_EQ(hedger.stats().requests, 0u);
+}
+
+TEST(RequestHedgerTest, PercentileModeLeavesSampleRequestsUnhedged) {
+    RequestHedger hedger;
+    std::chrono::microseconds delay{0};
+    for (size_t i = 0; i < RequestHedger::kMinSamples; ++i) {
+        hedger.record("api:80", std::chrono::milliseconds(10));
+    }
+
+    size_t unhedged = 0;
+    for (size_t i = 0; i < 3 * RequestHedger::kSampleEvery; ++i) {
+        if (!hedger.delayFor("api:80", HedgeMode::Percentile, 50, delay)) {
+            unhedged++;
+        }
+    }
+    EXPECT_EQ(unhedged, 3u);
+
+    for (size_t i = 0; i < RequestHedger::kSampleEvery; ++i) {
+        EXPECT_TRUE(hedger.delayFor("api:80", HedgeMode::Fixed, 50, delay));
+    }
+}
+
+TEST(HedgeRaceTest, FirstLegWithHeadersWins) {
+    HedgeRace race;
+    HedgeRace::Leg original(race, 0);
+    HedgeRace::Leg duplicate(race, 1);
+    httplib::Client client("http://localhost:1");
+
+    EXPECT_FALSE(race.waitForHeaders(HedgeRace::Clock::now() + std::chrono::milliseconds(10)));
+    EXPECT_TRUE(original.attach(client));
+
+    EXPECT_TRUE(duplicate.claim());
+    EXPECT_TRUE(original.cancelled());
+    EXPECT_FALSE(duplicate.cancelled());
+    EXPECT_FALSE(original.claim());
+    EXPECT_EQ(race.winner(), 1);
+    EXPECT_TRUE(race.waitForHeaders(HedgeRace::Clock::now()));
+
+    original.detach();
+    EXPECT_FALSE(original.attach(client));
+}
+
+TEST(HedgeRaceTest, OriginalFinishingEndsTheWait) {
+    HedgeRace race;
+    HedgeRace::Leg original(race, 0);
+
+    std::thread finisher([&original] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        original.finish();
+    });
+    EXPECT_TRUE(race.waitForHeaders(HedgeRace::Clock::now() + std::chrono::seconds(5)));
+    finisher.join();
+    EXPECT_EQ(race.winner(), -1);
+}
+
+}
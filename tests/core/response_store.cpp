@@ -0,0 +1,90 @@
+﻿#include "services/response_store.h"
+
+#include <string>
+#include <gtest/gtest.h>
+
+namespace lunarica {
+
+namespace {
+
+std::shared_ptr<StoredResponse> makeResponse(ResponseStore& store, const std::string& url, const std::string& body) {
+    auto response = store.create("GET", url);
+    response->status = 200;
+    response->contentType = "application/json";
+    response->body.append(body.data(), body.size());
+    return response;
+}
+
+}
+
+TEST(ResponseStoreTest, KeepsNewestResponsesFirst) {
+    ResponseStore store(2);
+    store.add(makeResponse(store, "/a", "{}"));
+    store.add(makeResponse(store, "/b", "{}"));
+    store.add(makeResponse(store, "/c", "{}"));
+
+    ASSERT_EQ(store.entries().size(), 2u);
+    EXPECT_EQ(store.latest()->url, "/c");
+    EXPECT_EQ(store.get(2)->url, "/b");
+    EXPECT_EQ(store.get(3), nullptr);
+    EXPECT_EQ(store.get(0), nullptr);
+}
+
+TEST(ResponseStoreTest, SpillsOldestBodiesPastMemoryBudget) {
+    ResponseStore store(10, 1024);
+    std::string body = "[" + std::string(600, ' ') + "1]";
+    store.add(makeResponse(store, "/a", body));
+    store.add(makeResponse(store, "/b", body));
+
+    EXPECT_TRUE(store.get(2)->body.spilled());
+    EXPECT_FALSE(store.get(1)->body.spilled());
+    EXPECT_LE(store.memoryUsage(), 1024u);
+    EXPECT_EQ(store.get(2)->body.view(), body);
+}
+
+TEST(ResponseStoreTest, ParsesReferences) {
+    size_t number = 0;
+    std::vector<JsonPathStep> steps;
+
+    ASSERT_TRUE(ResponseStore::parseReference("$2.items[5000].id", number, steps));
+    EXPECT_EQ(number, 2u);
+    EXPECT_EQ(JsonPath::toString(steps), "$.items[5000].id");
+
+    ASSERT_TRUE(ResponseStore::parseReference("$.items", number, steps));
+    EXPECT_EQ(number, 1u);
+    ASSERT_TRUE(ResponseStore::parseReference("items[1]", number, steps));
+    EXPECT_EQ(number, 1u);
+    EXPECT_EQ(steps.size(), 2u);
+
+    ASSERT_TRUE(ResponseStore::parseReference("$3", number, steps));
+    EXPECT_EQ(number, 3u);
+    EXPECT_TRUE(steps.empty());
+}
+
+TEST(JsonDocumentIndexTest, ResolvesPathsLazily) {
+    std::string json = " {\"meta\": {\"count\": 3}, \"items\": [{\"id\": 10, \"tags\": [\"x\"]}, {\"id\": 11},"
+                       " {\"id\": 12, \"name\": \"a \\\"b\\\" [c]\"}], \"done\": true}";
+    JsonDocumentIndex index(json);
+    std::vector<JsonPathStep> steps;
+
+    ASSERT_TRUE(JsonPath::parse("items[2].name", steps));
+    EXPECT_EQ(index.value(index.resolve(steps)), "\"a \\\"b\\\" [c]\"");
+    EXPECT_EQ(index.indexedContainers(), 3u);
+
+    ASSERT_TRUE(JsonPath::parse("items[0]", steps));
+    EXPECT_EQ(index.value(index.resolve(steps)), "{\"id\": 10, \"tags\": [\"x\"]}");
+    EXPECT_EQ(index.indexedContainers(), 4u);
+
+    ASSERT_TRUE(JsonPath::parse("items", steps));
+    EXPECT_EQ(index.childCount(index.resolve(steps)), 3u);
+
+    ASSERT_TRUE(JsonPath::parse("done", steps));
+    EXPECT_EQ(index.value(index.resolve(steps)), "true");
+
+    ASSERT_TRUE(JsonPath::parse("items[3]", steps));
+    EXPECT_EQ(index.resolve(steps), JsonDocumentIndex::npos);
+    ASSERT_TRUE(JsonPath::parse("meta[0]", steps));
+    EXPECT_EQ(index.resolve(steps), JsonDocumentIndex::npos);
+}
+
+}
@@ -0,0 +1,64 @@
+﻿#include "services/tls_session_cache.h"
+
+#include <gtest/gtest.h>
+
+namespace lunarica {
+
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+namespace {
+
+SSL_SESSION* makeSession(const std::string& id) {
+    SSL_SESSION* session = SSL_SESSION_new();
+    SSL_SESSION_set1_id(session, reinterpret_cast<const unsigned char*>(id.data()), static_cast<unsigned int>(id.size()));
+    SSL_SESSION_set_protocol_version(session, TLS1_2_VERSION);
+    return session;
+}
+
+}
+
+TEST(TlsSessionCacheTest, StoresResumableSessionsPerHost) {
+    TlsSessionCache cache;
+    SSL_SESSION* session = makeSession("session-a");
+    cache.store("https://api.example.com:443", session);
+    SSL_SESSION_free(session);
+
+    SSL_SESSION* found = cache.lookup("https://api.example.com:443");
+    ASSERT_NE(found, nullptr);
+    unsigned int length = 0;
+    const unsigned char* id = SSL_SESSION_get_id(found, &length);
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(id), length), "session-a");
+    SSL_SESSION_free(found);
+
+    EXPECT_EQ(cache.lookup("https://other.example.com:443"), nullptr);
+
+    SSL_SESSION* unusable = SSL_SESSION_new();
+    cache.store("https://other.example.com:443", unusable);
+    SSL_SESSION_free(unusable);
+    EXPECT_EQ(cache.size(), 1u);
+}
+
+TEST(TlsSessionCacheTest, ReplacesAndBoundsEntries) {
+    TlsSessionCache cache;
+    for (size_t i = 0; i < TlsSessionCache::kMaxSessions + 10; ++i) {
+        SSL_SESSION* session = makeSession("id-" + std::to_string(i));
+        cache.store("https://host-" + std::to_string(i) + ":443", session);
+        SSL_SESSION_free(session);
+    }
+    EXPECT_EQ(cache.size(), TlsSessionCache::kMaxSessions);
+
+    SSL_SESSION* newer = makeSession("newer");
+    cache.store("https://host-300:443", newer);
+    SSL_SESSION_free(newer);
+    SSL_SESSION* found = cache.lookup("https://host-300:443");
+    ASSERT_NE(found, nullptr);
+    unsigned int length = 0;
+    SSL_SESSION_get_id(found, &length);
+    EXPECT_EQ(length, 5u);
+    SSL_SESSION_free(found);
+
+    cache.clear();
+    EXPECT_EQ(cache.size(), 0u);
+}
+#endif
+
+}
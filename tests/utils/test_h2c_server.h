@@ -0,0 +1,272 @@
+﻿#pragma once
+
+#ifndef _WIN32
+
+#include <nghttp2/nghttp2.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lunarica {
+namespace testing {
+
+class TestH2cServer {
+public:
+    explicit TestH2cServer(int port) : port_(port) {}
+
+    ~TestH2cServer() {
+        stop();
+    }
+
+    void start() {
+        listener_ = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port_));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(listener_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        listen(listener_, 16);
+
+        running_ = true;
+        acceptor_ = std::thread([this] {
+            while (running_) {
+                pollfd descriptor = {listener_, POLLIN, 0};
+                if (poll(&descriptor, 1, 20) <= 0) {
+                    continue;
+                }
+                int fd = accept(listener_, nullptr, nullptr);
+                if (fd < 0) {
+                    continue;
+                }
+                connections_++;
+                std::lock_guard<std::mutex> lock(mutex_);
+                workers_.emplace_back([this, fd] { serve(fd); });
+            }
+        });
+    }
+
+    void stop() {
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+        acceptor_.join();
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+        workers_.clear();
+        close(listener_);
+    }
+
+    std::string getBaseUrl() const {
+        return "http://127.0.0.1:" + std::to_string(port_);
+    }
+
+    size_t connectionCount() const {
+        return connections_;
+    }
+
+    static const std::string& largeContent() {
+        static const std::string content = [] {
+            std::string data(4 << 20, '\0');
+            for (size_t i = 0; i < data.size(); ++i) {
+                data[i] = static_cast<char>((i * 7 + i / 1000) % 253);
+            }
+            return data;
+        }();
+        return content;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stream {
+        std::string method;
+        std::string path;
+        std::string requestBody;
+        std::string responseBody;
+        std::string contentType = "text/plain";
+        std::string status = "200";
+        std::string location;
+        size_t sent = 0;
+        Clock::time_point due;
+        bool ready = false;
+        bool responded = false;
+    };
+
+    struct Connection {
+        nghttp2_session* session = nullptr;
+        std::map<int32_t, Stream> streams;
+    };
+
+    int port_;
+    int listener_ = -1;
+    std::atomic_bool running_{false};
+    std::atomic<size_t> connections_{0};
+    std::thread acceptor_;
+    std::mutex mutex_;
+    std::vector<std::thread> workers_;
+
+    static void prepare(Stream& stream) {
+        stream.ready = true;
+        stream.due = Clock::now();
+        if (stream.path == "/posts/1") {
+            stream.contentType = "application/json";
+            stream.responseBody = "{\"id\": 1, \"title\": \"Test Post\", \"protocol\": \"h2c\"}";
+        } else if (stream.path == "/slow") {
+            stream.due += std::chrono::milliseconds(200);
+            stream.responseBody = "slow";
+        } else if (stream.path == "/moved") {
+            stream.status = "302";
+            stream.location = "/posts/1";
+            stream.responseBody = "moved";
+        } else if (stream.path == "/echo") {
+            stream.responseBody = stream.method + ":" + stream.requestBody;
+        } else if (stream.path == "/large") {
+            stream.contentType = "application/octet-stream";
+            stream.responseBody = largeContent();
+        } else {
+            stream.responseBody = "not found";
+        }
+    }
+
+    static ssize_t readResponse(nghttp2_session*, int32_t, uint8_t* buffer, size_t length, uint32_t* flags,
+                                nghttp2_data_source* source, void*) {
+        auto* stream = static_cast<Stream*>(source->ptr);
+        size_t count = std::min(length, stream->responseBody.size() - stream->sent);
+        std::memcpy(buffer, stream->responseBody.data() + stream->sent, count);
+        stream->sent += count;
+        if (stream->sent == stream->responseBody.size()) {
+            *flags |= NGHTTP2_DATA_FLAG_EOF;
+        }
+        return static_cast<ssize_t>(count);
+    }
+
+    void serve(int fd) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        nghttp2_session_callbacks* callbacks = nullptr;
+        nghttp2_session_callbacks_new(&callbacks);
+        nghttp2_session_callbacks_set_on_begin_headers_callback(callbacks,
+            [](nghttp2_session*, const nghttp2_frame* frame, void* user) {
+                static_cast<Connection*>(user)->streams[frame->hd.stream_id];
+                return 0;
+            });
+        nghttp2_session_callbacks_set_on_header_callback(callbacks,
+            [](nghttp2_session*, const nghttp2_frame* frame, const uint8_t* name, size_t nameLength,
+               const uint8_t* value, size_t valueLength, uint8_t, void* user) {
+                Stream& stream = static_cast<Connection*>(user)->streams[frame->hd.stream_id];
+                std::string key(reinterpret_cast<const char*>(name), nameLength);
+                std::string text(reinterpret_cast<const char*>(value), valueLength);
+                if (key == ":method") {
+                    stream.method = text;
+                } else if (key == ":path") {
+                    stream.path = text;
+                }
+                return 0;
+            });
+        nghttp2_session_callbacks_set_on_data_chunk_recv_callback(callbacks,
+            [](nghttp2_session*, uint8_t, int32_t id, const uint8_t* data, size_t length, void* user) {
+                static_cast<Connection*>(user)->streams[id].requestBody.append(reinterpret_cast<const char*>(data), length);
+                return 0;
+            });
+        nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks,
+            [](nghttp2_session*, const nghttp2_frame* frame, void* user) {
+                auto& streams = static_cast<Connection*>(user)->streams;
+                auto it = streams.find(frame->hd.stream_id);
+                if (it != streams.end() && (frame->hd.flags & NGHTTP2_FLAG_END_STREAM)) {
+                    prepare(it->second);
+                }
+                return 0;
+            });
+        nghttp2_session_callbacks_set_on_stream_close_callback(callbacks,
+            [](nghttp2_session*, int32_t id, uint32_t, void* user) {
+                static_cast<Connection*>(user)->streams.erase(id);
+                return 0;
+            });
+
+        Connection connection;
+        nghttp2_session_server_new(&connection.session, callbacks, &connection);
+        nghttp2_session_callbacks_del(callbacks);
+        nghttp2_settings_entry settings[] = {{NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, 64}};
+        nghttp2_submit_settings(connection.session, NGHTTP2_FLAG_NONE, settings, 1);
+
+        bool open = true;
+        while (open && running_) {
+            pollfd descriptor = {fd, POLLIN, 0};
+            if (poll(&descriptor, 1, 5) > 0) {
+                char buffer[16384];
+                ssize_t length = recv(fd, buffer, sizeof(buffer), 0);
+                if (length <= 0 || nghttp2_session_mem_recv(connection.session,
+                        reinterpret_cast<const uint8_t*>(buffer), static_cast<size_t>(length)) < 0) {
+                    open = length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+                }
+            }
+
+            auto now = Clock::now();
+            for (auto& [id, stream] : connection.streams) {
+                if (stream.ready && !stream.responded && now >= stream.due) {
+                    stream.responded = true;
+                    std::string length = std::to_string(stream.responseBody.size());
+                    std::vector<nghttp2_nv> headers = {
+                        {(uint8_t*)":status", (uint8_t*)stream.status.data(), 7, stream.status.size(), NGHTTP2_NV_FLAG_NONE},
+                        {(uint8_t*)"content-type", (uint8_t*)stream.contentType.data(), 12, stream.contentType.size(), NGHTTP2_NV_FLAG_NONE},
+                        {(uint8_t*)"content-length", (uint8_t*)length.data(), 14, length.size(), NGHTTP2_NV_FLAG_NONE},
+                    };
+                    if (!stream.location.empty()) {
+                        headers.push_back({(uint8_t*)"location", (uint8_t*)stream.location.data(), 8, stream.location.size(), NGHTTP2_NV_FLAG_NONE});
+                    }
+                    nghttp2_data_provider provider;
+                    provider.source.ptr = &stream;
+                    provider.read_callback = &TestH2cServer::readResponse;
+                    nghttp2_submit_response(connection.session, id, headers.data(), headers.size(), &provider);
+                }
+            }
+
+            const uint8_t* data = nullptr;
+            ssize_t length = 0;
+            while (open && (length = nghttp2_session_mem_send(connection.session, &data)) > 0) {
+                while (length > 0) {
+                    ssize_t written = send(fd, data, static_cast<size_t>(length), MSG_NOSIGNAL);
+                    if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                        pollfd writable = {fd, POLLOUT, 0};
+                        poll(&writable, 1, 100);
+                        continue;
+                    }
+                    if (written <= 0) {
+                        open = false;
+                        break;
+                    }
+                    data += written;
+                    length -= written;
+                }
+            }
+            open = open && (nghttp2_session_want_read(connection.session) || nghttp2_session_want_write(connection.session));
+        }
+
+        nghttp2_session_del(connection.session);
+        close(fd);
+    }
+};
+
+}
+}
+
+#endif
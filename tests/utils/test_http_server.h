@@ -11,6 +11,10 @@
 #include <mutex>
 #include <condition_variable>
 
+#ifdef LUNARICA_ZLIB_SUPPORT
+#include <zlib.h>
+#endif
+
 namespace lunarica {
 namespace testing {
 
@@ -114,6 +118,106 @@ public:
                 res.set_content(req.body, req.get_header_value("Content-Type"));
             });
 
+            server_.Post("/upload", [](const httplib::Request& req, httplib::Response& res) {
+                uint32_t hash = 2166136261u;
+                for (char c : req.body) {
+                    hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+                }
+                bool chunked = req.get_header_value("Transfer-Encoding") == "chunked";
+
+                Json::Value response;
+                response["received"] = std::to_string(req.body.size()) + ":" + std::to_string(hash) + ":" +
+                                       (chunked ? "chunked" : "length") + ":" + req.get_header_value("Content-Type");
+                res.set_content(Json::FastWriter().write(response), "application/json");
+            });
+
+            server_.Post("/form", [](const httplib::Request& req, httplib::Response& res) {
+                std::string summary;
+                for (const auto& [name, part] : req.files) {
+                    summary += name + "=" + (part.filename.empty() ? part.content
+                                                                   : part.filename + ":" + std::to_string(part.content.size()) +
+                                                                     ":" + part.content_type) + ";";
+                }
+
+                Json::Value response;
+                response["received"] = summary;
+                res.set_content(Json::FastWriter().write(response), "application/json");
+            });
+
+            server_.Get("/stream", [](const httplib::Request&, httplib::Response& res) {
+                res.set_chunked_content_provider("application/json", [](size_t offset, httplib::DataSink& sink) {
+                    std::string chunk = offset == 0 ? "[" : "";
+                    for (int i = 0; i < 200; ++i) {
+                        chunk += (i == 0 ? "" : ",");
+                        chunk += "{\"id\": " + std::to_string(i) + ", \"name\": \"item-" + std::to_string(i) + "\"}";
+                        sink.write(chunk.data(), chunk.size());
+                        chunk.clear();
+                    }
+                    sink.write("]", 1);
+                    sink.done();
+                    return true;
+                });
+            });
+
+            server_.Get("/events", [](const httplib::Request&, httplib::Response& res) {
+                res.set_chunked_content_provider("text/event-stream", [](size_t, httplib::DataSink& sink) {
+                    for (int i = 0; i < 5; ++i) {
+                        std::string event = "event: tick\nid: " + std::to_string(i) +
+                                            "\ndata: {\"seq\": " + std::to_string(i) + "}\n\n";
+                        sink.write(event.data(), event.size());
+                    }
+                    sink.done();
+                    return true;
+                });
+            });
+
+            server_.Get("/ndjson", [](const httplib::Request&, httplib::Response& res) {
+                res.set_chunked_content_provider("application/x-ndjson", [](size_t, httplib::DataSink& sink) {
+                    for (int i = 0; i < 3; ++i) {
+                        std::string line = "{\"line\": " + std::to_string(i) + "}\n";
+                        sink.write(line.data(), line.size());
+                    }
+                    sink.done();
+                    return true;
+                });
+            });
+
+            server_.Get("/file", [](const httplib::Request&, httplib::Response& res) {
+                res.set_header("Accept-Ranges", "bytes");
+                res.set_header("ETag", "\"v1\"");
+                res.set_content(fileContent(), "application/octet-stream");
+            });
+
+            server_.Get("/file-no-ranges", [](const httplib::Request&, httplib::Response& res) {
+                res.set_chunked_content_provider("application/octet-stream", [](size_t, httplib::DataSink& sink) {
+                    const std::string& content = fileContent();
+                    sink.write(content.data(), content.size());
+                    sink.done();
+                    return true;
+                });
+            });
+
+#ifdef LUNARICA_ZLIB_SUPPORT
+            server_.Get("/gzip", [](const httplib::Request& req, httplib::Response& res) {
+                std::string body = compressibleContent();
+                if (req.get_header_value("Accept-Encoding").find("gzip") != std::string::npos) {
+                    std::string compressed(compressBound(body.size()) + 32, '\0');
+                    z_stream stream{};
+                    deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+                    stream.next_in = reinterpret_cast<Bytef*>(&body[0]);
+                    stream.avail_in = static_cast<uInt>(body.size());
+                    stream.next_out = reinterpret_cast<Bytef*>(&compressed[0]);
+                    stream.avail_out = static_cast<uInt>(compressed.size());
+                    deflate(&stream, Z_FINISH);
+                    compressed.resize(stream.total_out);
+                    deflateEnd(&stream);
+                    body = std::move(compressed);
+                    res.set_header("Content-Encoding", "gzip");
+                }
+                res.set_content(body, "application/json");
+            });
+#endif
+
             server_.Get("/error", [](const httplib::Request&, httplib::Response& res) {
                 res.status = 500;
                 res.set_header("Content-Type", "application/json");
@@ -124,6 +228,18 @@ public:
                 std::this_thread::sleep_for(std::chrono::seconds(10));
             });
 
+            server_.Get("/delay", [](const httplib::Request&, httplib::Response& res) {
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+                res.set_content("{\"delayed\": true}", "application/json");
+            });
+
+            server_.Get("/slow-once", [this](const httplib::Request&, httplib::Response& res) {
+                if (slowOnceHits_++ == 0) {
+                    std::this_thread::sleep_for(std::chrono::seconds(1));
+                }
+                res.set_content("{\"slow\": false}", "application/json");
+            });
+
             server_.Get("/not-found", [](const httplib::Request&, httplib::Response& res) {
                 res.status = 404;
                 res.set_header("Content-Type", "application/json");
@@ -154,11 +270,32 @@ public:
         return "http://localhost:" + std::to_string(port_);
     }
 
+    static const std::string& fileContent() {
+        static const std::string content = [] {
+            std::string data(1 << 20, '\0');
+            for (size_t i = 0; i < data.size(); ++i) {
+                data[i] = static_cast<char>((i * 31 + i / 4096) % 251);
+            }
+            return data;
+        }();
+        return content;
+    }
+
+    static std::string compressibleContent() {
+        std::string body = "[";
+        for (int i = 0; i < 2000; ++i) {
+            body += (i == 0 ? "" : ",");
+            body += "{\"id\": " + std::to_string(i) + ", \"name\": \"item-" + std::to_string(i) + "\"}";
+        }
+        return body + "]";
+    }
+
 private:
     httplib::Server server_;
     int port_;
     std::thread server_thread_;
     std::atomic_bool running_;
+    std::atomic_int slowOnceHits_{0};
 };
 
 }